@@ -3,10 +3,10 @@
 #include "../engine/core/Config.h"
 #include "../engine/shapes/AABBShape.h"
 #include "../engine/shapes/CircleShape.h"
+#include "../engine/shapes/TileGridShape.h"
 #include "../engine/collision/Collider.h"
 #include "../engine/forces/GravityForce.h"
 
-#include <iostream>
 #include <thread>
 #include <chrono>
 
@@ -15,9 +15,13 @@ Sandbox::Sandbox(): box(1.0f), ground(0.0f), ball(1.0f) {
     //Gravity Initialization
     GravityForce* gravity = new GravityForce(Vector2(0.0f, Config::GRAVITY));
     world.AddForceGenerator(gravity);
+    world.GetParticles().gravity = Vector2(0.0f, Config::GRAVITY);
 
-    // Initialize timing
+    // Initialize timing; physics gets half a 60 Hz frame and degrades past that
     lastTime = std::chrono::high_resolution_clock::now();
+    world.SetFrameBudget(0.008f);
+    // Only rendering reads bodies by index here, so the list may be re-sorted
+    world.SetBodyReordering(true);
 
 
     // Box Initialization
@@ -32,34 +36,18 @@ Sandbox::Sandbox(): box(1.0f), ground(0.0f), ball(1.0f) {
     box.SetInverseInertia(box.collider->shape->GetType());
     world.AddBody(&box);
 
-    //Ground Initialization
-    ground.position = {600.0f, 775.0f};
-    ground.size = {1200.0f, 50.0f};
-    ground.collider = new Collider(new AABBShape(Vector2(ground.size/2)));
+    // Level Initialization: ground and walls as one tile grid
+    TileGridShape* level = new TileGridShape(48, 32, 25.0f);
+    level->Fill(0, 0, 2, 30, true);     // Left wall
+    level->Fill(46, 0, 2, 30, true);    // Right wall
+    level->Fill(0, 30, 48, 2, true);    // Ground
+    ground.position = {0.0f, 0.0f};
+    ground.size = {1200.0f, 800.0f};
+    ground.collider = new Collider(level);
     ground.collider->restitution = 0.6f; 
     ground.collider->staticFriction = 0.3f;
     ground.collider->dynamicFriction = 0.2f;
     world.AddBody(&ground);
-
-    //left_Wall Initialization
-    RigidBody* left_wall = new RigidBody(0.0f);
-    left_wall->size = Vector2(50.0f, 750.0f);
-    left_wall->position = Vector2(25.0f, 375.0f);
-    left_wall->collider = new Collider(new AABBShape(Vector2(left_wall->size/2)));
-    left_wall->collider->restitution = 0.6f; 
-    left_wall->collider->staticFriction = 0.3f;
-    left_wall->collider->dynamicFriction = 0.2f;
-    world.AddBody(left_wall);
-
-    //Right_Wall Initialization
-    RigidBody* right_wall = new RigidBody(0.0f);
-    right_wall->size = Vector2(50.0f, 750.0f);
-    right_wall->position = Vector2(1175.0f, 375.0f);
-    right_wall->collider = new Collider(new AABBShape(Vector2(right_wall->size/2)));
-    right_wall->collider->restitution = 0.6f; 
-    right_wall->collider->staticFriction = 0.3f;
-    right_wall->collider->dynamicFriction = 0.2f;
-    world.AddBody(right_wall);
 }
 
 // Update the sandbox state
@@ -69,15 +57,7 @@ void Sandbox::Update(){
     std::chrono::duration<float> deltaTime = currentTime - lastTime;
     lastTime = currentTime;
     
-    float frameTime = deltaTime.count();
-    
-    if(frameTime > 0.25f)
-        frameTime = 0.25f;
-    
-    accumulator += frameTime;
-    
-    while(accumulator >= Time::FixedDeltaTime){
-        world.Step(Time::FixedDeltaTime);
-        accumulator -= Time::FixedDeltaTime;
-    }
+    // Over-budget frames are reported in world.GetAdvanceStats(); nothing is
+    // printed here, as that would only slow a frame that is already late
+    world.Advance(deltaTime.count());
 }
\ No newline at end of file
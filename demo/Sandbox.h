@@ -16,7 +16,6 @@ class Sandbox{
         RigidBody ball;
         RigidBody ground;
         
-        // Fixed timestep variables
-        float accumulator = 0.0f;
+        // Frame timing; the world keeps the fixed-timestep accumulator
         std::chrono::high_resolution_clock::time_point lastTime;
 };
\ No newline at end of file
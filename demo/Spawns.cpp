@@ -0,0 +1,43 @@
+#include "Spawns.h"
+#include "../engine/shapes/CircleShape.h"
+#include "../engine/shapes/PolygonShape.h"
+#include "../engine/collision/Collider.h"
+
+#include <cmath>
+
+static const float Pi = 3.14159265f;
+
+void Spawns::Ball(PhysicsWorld& world, const Vector2& position){
+    RigidBody* entity = new RigidBody(1.0f);
+    entity->position = position;
+    entity->size = Vector2(30.0f, 30.0f);
+    entity->collider = new Collider(new CircleShape(entity->size.x / 2));
+    entity->collider->restitution = 0.9f; // Set some bounciness
+    entity->collider->staticFriction = 0.2f;
+    entity->collider->dynamicFriction = 0.1f;
+    entity->velocity = Vector2(400.0f, 0.0f);
+    entity->isBullet = true; // Fast enough to skip through the walls at 60 Hz
+    entity->SetInverseInertia(entity->collider->shape->GetType());
+    world.GetCommandBuffer().AddBody(entity);
+}
+
+void Spawns::Hexagon(PhysicsWorld& world, const Vector2& position){
+    Vector2 points[6];
+    for(int i = 0; i < 6; i++)
+        points[i] = Vector2(std::cos(i * Pi / 3.0f), std::sin(i * Pi / 3.0f)) * 20.0f;
+    RigidBody* entity = new RigidBody(1.0f);
+    entity->position = position;
+    entity->size = Vector2(40.0f, 40.0f);
+    entity->collider = new Collider(new PolygonShape(points, 6));
+    entity->SetInverseInertia(entity->collider->shape->GetType());
+    world.GetCommandBuffer().AddBody(entity);
+}
+
+void Spawns::Burst(PhysicsWorld& world, const Vector2& position){
+    ParticleSystem& particles = world.GetParticles();
+    for(int i = 0; i < 64; i++){
+        float angle = i * (2.0f * Pi / 64.0f);
+        Vector2 offset(std::cos(angle) * 12.0f, std::sin(angle) * 12.0f);
+        particles.Spawn(position + offset, offset * 20.0f, 3.0f);
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "../engine/physics/PhysicsWorld.h"
+
+// What the demo's mouse buttons spawn. SDLApp and ReplayTool both call these,
+// so a replayed input script builds exactly the bodies a live session would
+namespace Spawns{
+    // Left click: a bouncy bullet ball thrown to the right
+    void Ball(PhysicsWorld& world, const Vector2& position);
+    // Middle click: a hexagon dropped in place
+    void Hexagon(PhysicsWorld& world, const Vector2& position);
+    // Right click: a ring of debris particles
+    void Burst(PhysicsWorld& world, const Vector2& position);
+}
@@ -0,0 +1,190 @@
+#include "BatchCollision.h"
+#include "../math/MathUtils.h"
+#include "../math/Vector2xN.h"
+#include <cmath>
+
+void BatchBodies::Resize(size_t count){
+    posX.resize(count);
+    posY.resize(count);
+    cosA.resize(count);
+    sinA.resize(count);
+    radius.resize(count);
+    halfX.resize(count);
+    halfY.resize(count);
+    margin.resize(count);
+}
+
+void BatchContacts::Clear(){
+    pair.clear();
+    normalX.clear();
+    normalY.clear();
+    penetration.clear();
+    pointX.clear();
+    pointY.clear();
+}
+
+void BatchContacts::Push(int pairIndex, float nx, float ny, float pen, float px, float py){
+    pair.push_back(pairIndex);
+    normalX.push_back(nx);
+    normalY.push_back(ny);
+    penetration.push_back(pen);
+    pointX.push_back(px);
+    pointY.push_back(py);
+}
+
+// Scalar versions, used for the tail of each batch
+static void CircleCircleScalar(const BatchBodies& bodies, int a, int b, int pairIndex, BatchContacts& out){
+    float dx = bodies.posX[b] - bodies.posX[a];
+    float dy = bodies.posY[b] - bodies.posY[a];
+    float radiiSum = bodies.radius[a] + bodies.radius[b];
+    float reach = radiiSum + (bodies.margin[a] + bodies.margin[b]);
+    float distSq = dx * dx + dy * dy;
+    if(distSq >= reach * reach) return;
+
+    float dist = std::sqrt(distSq);
+    float nx = 1.0f, ny = 0.0f;
+    if(dist != 0.0f){
+        nx = dx / dist;
+        ny = dy / dist;
+    }
+    out.Push(pairIndex, nx, ny, radiiSum - dist,
+             bodies.posX[a] + nx * bodies.radius[a],
+             bodies.posY[a] + ny * bodies.radius[a]);
+}
+
+// Normal for a circle whose centre lies on the box surface or inside it
+static void OBBCircleDegenerate(const BatchBodies& bodies, int a, int b, float& nx, float& ny){
+    float dx = bodies.posX[b] - bodies.posX[a];
+    float dy = bodies.posY[b] - bodies.posY[a];
+    float len = std::sqrt(dx * dx + dy * dy);
+    if(len > 1e-6f){
+        nx = dx / len;
+        ny = dy / len;
+    } else {
+        nx = 0.0f;
+        ny = 1.0f;
+    }
+}
+
+static void OBBCircleScalar(const BatchBodies& bodies, int a, int b, int pairIndex, BatchContacts& out){
+    float c = bodies.cosA[a];
+    float s = bodies.sinA[a];
+    float dx = bodies.posX[b] - bodies.posX[a];
+    float dy = bodies.posY[b] - bodies.posY[a];
+
+    // Circle centre in box space, clamped to the box
+    float lx = Clamp(dx * c + dy * s, -bodies.halfX[a], bodies.halfX[a]);
+    float ly = Clamp(dy * c - dx * s, -bodies.halfY[a], bodies.halfY[a]);
+
+    float closestX = bodies.posX[a] + (lx * c - ly * s);
+    float closestY = bodies.posY[a] + (lx * s + ly * c);
+    float diffX = closestX - bodies.posX[b];
+    float diffY = closestY - bodies.posY[b];
+    float distSq = diffX * diffX + diffY * diffY;
+    float r = bodies.radius[b];
+    float reach = r + (bodies.margin[a] + bodies.margin[b]);
+    if(distSq > reach * reach) return;
+
+    float dist = std::sqrt(distSq);
+    float nx, ny;
+    if(dist > 1e-6f){
+        nx = (bodies.posX[b] - closestX) / dist;
+        ny = (bodies.posY[b] - closestY) / dist;
+    } else {
+        OBBCircleDegenerate(bodies, a, b, nx, ny);
+    }
+    out.Push(pairIndex, nx, ny, r - dist, closestX, closestY);
+}
+
+void BatchCollision::CirclevsCircle(const BatchBodies& bodies,
+                                    const int* indexA,
+                                    const int* indexB,
+                                    int pairCount,
+                                    BatchContacts& out)
+{
+    const int Lanes = FloatN::Width;
+    alignas(32) float nx[Lanes], ny[Lanes], pen[Lanes], px[Lanes], py[Lanes];
+
+    int i = 0;
+    for(; i + Lanes <= pairCount; i += Lanes){
+        Vector2xN a = Vector2xN::Gather(bodies.posX.data(), bodies.posY.data(), indexA + i);
+        Vector2xN b = Vector2xN::Gather(bodies.posX.data(), bodies.posY.data(), indexB + i);
+        FloatN radiusA = FloatN::Gather(bodies.radius.data(), indexA + i);
+        FloatN radiiSum = radiusA + FloatN::Gather(bodies.radius.data(), indexB + i);
+        FloatN reach = radiiSum + (FloatN::Gather(bodies.margin.data(), indexA + i) +
+                                   FloatN::Gather(bodies.margin.data(), indexB + i));
+        Vector2xN delta = b - a;
+        FloatN distSq = delta.dot(delta);
+
+        int hits = (distSq < reach * reach).Bits();
+        if(hits == 0) continue;
+
+        // Only batches with at least one hit pay for the sqrt and divides
+        FloatN dist = Sqrt(distSq);
+        Vector2xN normal = Select(dist != FloatN(0.0f), delta / dist, Vector2xN(Vector2(1.0f, 0.0f)));
+        normal.Store(nx, ny);
+        (radiiSum - dist).Store(pen);
+        (a + normal * radiusA).Store(px, py);
+
+        while(hits){
+            int lane = 0;
+            while(!(hits & (1 << lane))) lane++;
+            hits &= hits - 1;
+            out.Push(i + lane, nx[lane], ny[lane], pen[lane], px[lane], py[lane]);
+        }
+    }
+    for(; i < pairCount; i++)
+        CircleCircleScalar(bodies, indexA[i], indexB[i], i, out);
+}
+
+void BatchCollision::OBBvsCircle(const BatchBodies& bodies,
+                                 const int* indexA,
+                                 const int* indexB,
+                                 int pairCount,
+                                 BatchContacts& out)
+{
+    const int Lanes = FloatN::Width;
+    alignas(32) float nx[Lanes], ny[Lanes], pen[Lanes], px[Lanes], py[Lanes];
+
+    int i = 0;
+    for(; i + Lanes <= pairCount; i += Lanes){
+        Vector2xN box = Vector2xN::Gather(bodies.posX.data(), bodies.posY.data(), indexA + i);
+        FloatN c = FloatN::Gather(bodies.cosA.data(), indexA + i);
+        FloatN s = FloatN::Gather(bodies.sinA.data(), indexA + i);
+        FloatN hx = FloatN::Gather(bodies.halfX.data(), indexA + i);
+        FloatN hy = FloatN::Gather(bodies.halfY.data(), indexA + i);
+        Vector2xN circle = Vector2xN::Gather(bodies.posX.data(), bodies.posY.data(), indexB + i);
+        FloatN r = FloatN::Gather(bodies.radius.data(), indexB + i);
+
+        // Circle centre in box space, clamped to the box
+        Vector2xN local = (circle - box).InverseRotate(c, s);
+        local.x = Clamp(local.x, -hx, hx);
+        local.y = Clamp(local.y, -hy, hy);
+
+        Vector2xN closest = box + local.Rotate(c, s);
+        Vector2xN diff = closest - circle;
+        FloatN distSq = diff.dot(diff);
+        FloatN reach = r + (FloatN::Gather(bodies.margin.data(), indexA + i) +
+                            FloatN::Gather(bodies.margin.data(), indexB + i));
+
+        int hits = (distSq <= reach * reach).Bits();
+        if(hits == 0) continue;
+
+        FloatN dist = Sqrt(distSq);
+        int separated = (dist > FloatN(1e-6f)).Bits();
+        ((circle - closest) / dist).Store(nx, ny);
+        (r - dist).Store(pen);
+        closest.Store(px, py);
+
+        while(hits){
+            int lane = 0;
+            while(!(hits & (1 << lane))) lane++;
+            hits &= hits - 1;
+            if(!(separated & (1 << lane)))
+                OBBCircleDegenerate(bodies, indexA[i + lane], indexB[i + lane], nx[lane], ny[lane]);
+            out.Push(i + lane, nx[lane], ny[lane], pen[lane], px[lane], py[lane]);
+        }
+    }
+    for(; i < pairCount; i++)
+        OBBCircleScalar(bodies, indexA[i], indexB[i], i, out);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Shape data of every body gathered into parallel arrays for the batch kernels.
+// Circles fill radius; boxes fill cos/sin of their orientation, half extents,
+// and their bounding-circle radius. margin is how far the body can move this
+// step (0 unless speculative contacts are on).
+struct BatchBodies{
+    std::vector<float> posX, posY;
+    std::vector<float> cosA, sinA;
+    std::vector<float> radius;
+    std::vector<float> halfX, halfY;
+    std::vector<float> margin;
+
+    void Resize(size_t count);
+};
+
+// Compact output of the batch kernels: one entry per colliding pair.
+// pair holds the index of the pair in the kernel's input arrays.
+struct BatchContacts{
+    std::vector<int> pair;
+    std::vector<float> normalX, normalY;
+    std::vector<float> penetration;
+    std::vector<float> pointX, pointY;
+
+    void Clear();
+    int Size() const { return static_cast<int>(pair.size()); }
+    void Push(int pairIndex, float nx, float ny, float pen, float px, float py);
+};
+
+// Narrowphase kernels that test FloatN::Width pairs of one shape combination
+// at once. Results match Collision::CirclevsCircle and Collision::OBBvsCircle.
+// Pairs closer than the sum of their margins are reported too, with the gap
+// as a negative penetration.
+class BatchCollision{
+    public:
+        // indexA/indexB: circle bodies of each pair
+        static void CirclevsCircle(const BatchBodies& bodies,
+                                   const int* indexA,
+                                   const int* indexB,
+                                   int pairCount,
+                                   BatchContacts& out);
+        // indexA: box bodies, indexB: circle bodies; normals point from box to circle
+        static void OBBvsCircle(const BatchBodies& bodies,
+                                const int* indexA,
+                                const int* indexB,
+                                int pairCount,
+                                BatchContacts& out);
+};
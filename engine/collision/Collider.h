@@ -8,6 +8,9 @@ class Collider{
         float restitution = 0.5f; // Bounciness factor
         float staticFriction = 0.3f;
         float dynamicFriction = 0.2f;
+        // Trigger volume: overlaps are reported as contact events but never
+        // resolved, and particles and bullets pass through
+        bool isSensor = false;
 
         explicit Collider(Shape* shape):shape(shape) {}
 };
\ No newline at end of file
@@ -1,7 +1,6 @@
 #include "Collision.h"
 #include "CollisionResolver.h"
 #include "../math/MathUtils.h"
-#include <vector>
 
 // Get the Axis-Aligned Bounding Box for a RigidBody with an AABBShape
 AABB Collision::GetAABB(const RigidBody &body, const AABBShape &shape)
@@ -13,11 +12,8 @@ AABB Collision::GetAABB(const RigidBody &body, const AABBShape &shape)
 }
 
 // Get the 4 corners of an Oriented Bounding Box
-void Collision::GetOBBCorners(const RigidBody& body, const AABBShape& shape, Vector2 corners[4])
+void Collision::GetOBBCorners(const RigidBody& body, const AABBShape& shape, float cosA, float sinA, Vector2 corners[4])
 {
-    float cosA = std::cos(body.orientation);
-    float sinA = std::sin(body.orientation);
-    
     Vector2 halfsize = shape.halfsize;
     
     // Local space corners
@@ -53,111 +49,388 @@ float Collision::ProjectOntoAxis(const Vector2 corners[], int numCorners, const
     return max - min;
 }
 
+// Outward edge normals of an OBB, matching the corner order of GetOBBCorners
+void Collision::GetOBBNormals(float cosA, float sinA, Vector2 normals[4])
+{
+    normals[0] = Vector2(sinA, -cosA);
+    normals[1] = Vector2(cosA, sinA);
+    normals[2] = Vector2(-sinA, cosA);
+    normals[3] = Vector2(-cosA, -sinA);
+}
+
+namespace {
+
+struct ClipVertex{
+    Vector2 position;
+    uint32_t source;    // Which end of the incident edge (0/1), kept when the end is clipped
+};
+
+// Keep the part of segment in[2] with dot(normal, p) <= offset. A clipped end
+// keeps its source, so feature ids stay the same while the edges slide
+int ClipSegment(const ClipVertex in[2], ClipVertex out[2], const Vector2& normal, float offset)
+{
+    int count = 0;
+    float d0 = normal.dot(in[0].position) - offset;
+    float d1 = normal.dot(in[1].position) - offset;
+
+    if (d0 <= 0.0f) out[count++] = in[0];
+    if (d1 <= 0.0f) out[count++] = in[1];
+
+    if (d0 * d1 < 0.0f)
+    {
+        float t = d0 / (d0 - d1);
+        out[count].position = in[0].position + (in[1].position - in[0].position) * t;
+        out[count].source = d0 > 0.0f ? in[0].source : in[1].source;
+        count++;
+    }
+    return count;
+}
+
+uint32_t FeatureId(int refFace, int incFace, uint32_t source, bool flip)
+{
+    return static_cast<uint32_t>(refFace) | static_cast<uint32_t>(incFace) << 8 | source << 16 | (flip ? 1u << 24 : 0u);
+}
+
+}
+
+// Clip the incident edge (the edge of the other polygon facing most against the
+// reference normal) to the side planes of the reference face, keeping the points
+// behind the face. flip marks the reference polygon as body B. Returns the number
+// of points added to the manifold.
+int Collision::ClipPolygons(const Vector2* refVertices, const Vector2* refNormals, int refCount, int refFace,
+                            const Vector2* incVertices, const Vector2* incNormals, int incCount,
+                            bool flip, CollisionManifold& manifold, float margin)
+{
+    const Vector2& refNormal = refNormals[refFace];
+
+    int incFace = 0;
+    float minDot = FLT_MAX;
+    for (int i = 0; i < incCount; i++)
+    {
+        float d = incNormals[i].dot(refNormal);
+        if (d < minDot)
+        {
+            minDot = d;
+            incFace = i;
+        }
+    }
+
+    ClipVertex incident[2] = {
+        {incVertices[incFace], 0},
+        {incVertices[(incFace + 1) % incCount], 1}
+    };
+
+    Vector2 v1 = refVertices[refFace];
+    Vector2 v2 = refVertices[(refFace + 1) % refCount];
+    Vector2 tangent = (v2 - v1).normalize();
+    float front = refNormal.dot(v1);
+
+    ClipVertex clipped1[2], clipped2[2];
+    int count = ClipSegment(incident, clipped1, tangent * -1.0f, -tangent.dot(v1));
+    if (count == 2)
+        count = ClipSegment(clipped1, clipped2, tangent, tangent.dot(v2));
+
+    int added = 0;
+    if (count == 2)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            float separation = refNormal.dot(clipped2[i].position) - front;
+            if (separation <= margin)
+            {
+                manifold.AddPoint(clipped2[i].position, -separation, FeatureId(refFace, incFace, clipped2[i].source, flip));
+                added++;
+            }
+        }
+    }
+
+    // Numerical corner cases: fall back to the deepest incident vertex
+    if (added == 0)
+    {
+        int deepest = refNormal.dot(incident[0].position) <= refNormal.dot(incident[1].position) ? 0 : 1;
+        float separation = refNormal.dot(incident[deepest].position) - front;
+        manifold.AddPoint(incident[deepest].position, std::max(-separation, -margin),
+                          FeatureId(refFace, incFace, incident[deepest].source, flip));
+        added = 1;
+    }
+    return added;
+}
+
 // Check collision between two Oriented Bounding Boxes using SAT
 bool Collision::OBBvsOBB(const RigidBody &a, const RigidBody &b, CollisionManifold& manifold)
+{
+    int axisHint = -1;
+    return OBBvsOBB(a, b, manifold, axisHint);
+}
+
+// axisHint (0-1: A's axes, 2-3: B's axes, -1: none) is tested first and updated
+// to the separating axis, or to the reference axis on contact. It only changes
+// how soon a separated pair exits, never the result.
+bool Collision::OBBvsOBB(const RigidBody &a, const RigidBody &b, CollisionManifold& manifold, int& axisHint)
+{
+    return OBBvsOBB(a, b, std::cos(a.orientation), std::sin(a.orientation),
+                    std::cos(b.orientation), std::sin(b.orientation), manifold, axisHint);
+}
+
+bool Collision::OBBvsOBB(const RigidBody &a, const RigidBody &b,
+                         float cosA, float sinA, float cosB, float sinB,
+                         CollisionManifold& manifold, int& axisHint, float margin)
 {
     AABBShape *shapeA = static_cast<AABBShape *>(a.collider->shape);
     AABBShape *shapeB = static_cast<AABBShape *>(b.collider->shape);
     
-    // Get corners of both OBBs
+    // Get corners and edge normals of both OBBs
     Vector2 cornersA[4], cornersB[4];
-    GetOBBCorners(a, *shapeA, cornersA);
-    GetOBBCorners(b, *shapeB, cornersB);
-    
-    // Get axes to test (perpendicular to edges)
-    Vector2 axes[4];
-    
-    // Axes from box A (perpendicular to edges)
-    float cosA = std::cos(a.orientation);
-    float sinA = std::sin(a.orientation);
-    axes[0] = Vector2(cosA, sinA);           // Right direction
-    axes[1] = Vector2(-sinA, cosA);          // Up direction
-    
-    // Axes from box B
-    float cosB = std::cos(b.orientation);
-    float sinB = std::sin(b.orientation);
-    axes[2] = Vector2(cosB, sinB);
-    axes[3] = Vector2(-sinB, cosB);
-    
-    float minOverlap = FLT_MAX;
-    Vector2 smallestAxis;
-    
-    // Test all axes using SAT
-    for (int i = 0; i < 4; i++)
+    GetOBBCorners(a, *shapeA, cosA, sinA, cornersA);
+    GetOBBCorners(b, *shapeB, cosB, sinB, cornersB);
+
+    Vector2 normalsA[4], normalsB[4];
+    GetOBBNormals(cosA, sinA, normalsA);
+    GetOBBNormals(cosB, sinB, normalsB);
+
+    // Axes to test: two edge normals per box
+    Vector2 axes[4] = { normalsA[1], normalsA[2], normalsB[1], normalsB[2] };
+
+    // Test all axes using SAT, starting with the hinted one
+    float overlaps[4];
+    for (int k = -1; k < 4; k++)
     {
+        int i = k < 0 ? axisHint : k;
+        if (i < 0 || (k >= 0 && i == axisHint))
+            continue;
+
         float minA, maxA, minB, maxB;
         ProjectOntoAxis(cornersA, 4, axes[i], minA, maxA);
         ProjectOntoAxis(cornersB, 4, axes[i], minB, maxB);
         
         // Check for separation
-        if (maxA < minB || maxB < minA)
+        if (maxA + margin < minB || maxB + margin < minA)
+        {
+            axisHint = i;
             return false; // No collision
+        }
         
         // Calculate overlap
-        float overlap = std::min(maxA, maxB) - std::max(minA, minB);
-        
-        if (overlap < minOverlap)
-        {
-            minOverlap = overlap;
-            smallestAxis = axes[i];
-            
-            // Make sure normal points from A to B
-            Vector2 centerDiff = b.position - a.position;
-            if (centerDiff.dot(smallestAxis) < 0)
-                smallestAxis = smallestAxis * -1.0f;
-        }
+        overlaps[i] = std::min(maxA, maxB) - std::max(minA, minB);
     }
-    
-    // Collision detected, fill manifold
-    manifold.normal = smallestAxis;
-    manifold.penetration = minOverlap;
-    
-    // Find contact points: vertices of one box that are inside the other box
-    std::vector<Vector2> contactPoints;
-    
-    // Check vertices of B that are "inside" A (behind the collision normal)
+
+    // Smallest overlap per box, in axis order so the hint can't change the choice
+    Vector2 centerDiff = b.position - a.position;
+    float overlapA = FLT_MAX, overlapB = FLT_MAX;
+    int indexA = 0, indexB = 2;
     for (int i = 0; i < 4; i++)
     {
-        // Project B's corner onto the collision normal from A's center
-        Vector2 diff = cornersB[i] - a.position;
-        float projection = diff.dot(manifold.normal);
-        
-        // If the projection is positive and within the penetration depth, it's a contact point
-        if (projection > 0 && projection <= minOverlap + 0.1f)
+        if (i < 2 && overlaps[i] < overlapA)
+        {
+            overlapA = overlaps[i];
+            indexA = i;
+        }
+        else if (i >= 2 && overlaps[i] < overlapB)
         {
-            contactPoints.push_back(cornersB[i]);
+            overlapB = overlaps[i];
+            indexB = i;
         }
     }
+
+    // Make sure normal points from A to B
+    Vector2 axisA = centerDiff.dot(axes[indexA]) < 0 ? axes[indexA] * -1.0f : axes[indexA];
+    Vector2 axisB = centerDiff.dot(axes[indexB]) < 0 ? axes[indexB] * -1.0f : axes[indexB];
+
+    // Prefer A's faces unless B's are clearly better, so the reference face
+    // doesn't flip back and forth between nearly equal axes of a resting pair
+    bool flip = overlapB < 0.95f * overlapA - 0.01f;
+    manifold.normal = flip ? axisB : axisA;
+    axisHint = flip ? indexB : indexA;
+
+    if (!flip)
+    {
+        int refFace = 0;
+        for (int i = 1; i < 4; i++)
+            if (normalsA[i].dot(manifold.normal) > normalsA[refFace].dot(manifold.normal)) refFace = i;
+        ClipPolygons(cornersA, normalsA, 4, refFace, cornersB, normalsB, 4, false, manifold, margin);
+    }
+    else
+    {
+        Vector2 refDirection = manifold.normal * -1.0f;
+        int refFace = 0;
+        for (int i = 1; i < 4; i++)
+            if (normalsB[i].dot(refDirection) > normalsB[refFace].dot(refDirection)) refFace = i;
+        ClipPolygons(cornersB, normalsB, 4, refFace, cornersA, normalsA, 4, true, manifold, margin);
+    }
+
+    manifold.penetration = manifold.points[0].penetration;
+    if (manifold.contactCount == 2)
+        manifold.penetration = std::max(manifold.penetration, manifold.points[1].penetration);
     
-    // Check vertices of A that are "inside" B (ahead of the collision normal)
-    for (int i = 0; i < 4; i++)
+    return true;
+}
+
+namespace {
+
+// A polygon or box placed in the world, for PolygonvsPolygon
+struct PlacedPolygon
+{
+    const PolygonShape* polygon;    // Null for a box
+    Vector2 vertices[PolygonShape::MaxVertices];
+    Vector2 normals[PolygonShape::MaxVertices];
+    int count;
+    float cosA, sinA;
+
+    // Vertex farthest along a world direction; polygons search in local space
+    int Support(const Vector2& direction) const
     {
-        Vector2 diff = cornersA[i] - b.position;
-        float projection = diff.dot(manifold.normal);
-        
-        // If the projection is negative and within the penetration depth, it's a contact point
-        if (projection < 0 && std::abs(projection) <= minOverlap + 0.1f)
+        if (polygon)
+            return polygon->Support(Vector2(direction.x * cosA + direction.y * sinA, -direction.x * sinA + direction.y * cosA));
+        int best = 0;
+        for (int i = 1; i < count; i++)
+            if (vertices[i].dot(direction) > vertices[best].dot(direction)) best = i;
+        return best;
+    }
+};
+
+// Largest separation of b from a face of a, and that face
+float MaxSeparation(const PlacedPolygon& a, const PlacedPolygon& b, int& face)
+{
+    float best = -FLT_MAX;
+    for (int i = 0; i < a.count; i++)
+    {
+        const Vector2& normal = a.normals[i];
+        float separation = normal.dot(b.vertices[b.Support(normal * -1.0f)] - a.vertices[i]);
+        if (separation > best)
         {
-            contactPoints.push_back(cornersA[i]);
+            best = separation;
+            face = i;
         }
     }
-    
-    // Use average of contact points, or center between objects if none found
-    if (contactPoints.size() > 0)
+    return best;
+}
+
+}
+
+bool Collision::PolygonvsPolygon(const RigidBody& a, const RigidBody& b,
+                                 float cosA, float sinA, float cosB, float sinB,
+                                 CollisionManifold& manifold, float margin)
+{
+    PlacedPolygon placed[2];
+    const RigidBody* bodies[2] = { &a, &b };
+    const float cosines[2] = { cosA, cosB };
+    const float sines[2] = { sinA, sinB };
+    for (int k = 0; k < 2; k++)
     {
-        Vector2 avgContact(0, 0);
-        for (const auto& point : contactPoints)
+        PlacedPolygon& p = placed[k];
+        const Shape* shape = bodies[k]->collider->shape;
+        p.cosA = cosines[k];
+        p.sinA = sines[k];
+        if (shape->GetType() == ShapeType::Polygon)
         {
-            avgContact = avgContact + point;
+            p.polygon = static_cast<const PolygonShape*>(shape);
+            p.count = p.polygon->count;
+            for (int i = 0; i < p.count; i++)
+            {
+                const Vector2& v = p.polygon->vertices[i];
+                const Vector2& n = p.polygon->normals[i];
+                p.vertices[i] = bodies[k]->position + Vector2(v.x * p.cosA - v.y * p.sinA, v.x * p.sinA + v.y * p.cosA);
+                p.normals[i] = Vector2(n.x * p.cosA - n.y * p.sinA, n.x * p.sinA + n.y * p.cosA);
+            }
+        }
+        else
+        {
+            p.polygon = nullptr;
+            p.count = 4;
+            GetOBBCorners(*bodies[k], *static_cast<const AABBShape*>(shape), p.cosA, p.sinA, p.vertices);
+            GetOBBNormals(p.cosA, p.sinA, p.normals);
         }
-        manifold.contactPoint = avgContact / static_cast<float>(contactPoints.size());
+    }
+
+    int faceA = 0, faceB = 0;
+    float separationA = MaxSeparation(placed[0], placed[1], faceA);
+    if (separationA > margin)
+        return false;
+    float separationB = MaxSeparation(placed[1], placed[0], faceB);
+    if (separationB > margin)
+        return false;
+
+    // Same preference for A's faces as OBBvsOBB
+    const PlacedPolygon& pa = placed[0];
+    const PlacedPolygon& pb = placed[1];
+    if (separationB > 0.95f * separationA + 0.01f)
+    {
+        manifold.normal = pb.normals[faceB] * -1.0f;
+        ClipPolygons(pb.vertices, pb.normals, pb.count, faceB, pa.vertices, pa.normals, pa.count, true, manifold, margin);
     }
     else
     {
-        // Fallback: contact at the midpoint between centers projected onto collision normal
-        manifold.contactPoint = a.position + manifold.normal * (shapeA->halfsize.x + shapeA->halfsize.y) * 0.5f;
+        manifold.normal = pa.normals[faceA];
+        ClipPolygons(pa.vertices, pa.normals, pa.count, faceA, pb.vertices, pb.normals, pb.count, false, manifold, margin);
     }
-    
+
+    manifold.penetration = manifold.points[0].penetration;
+    if (manifold.contactCount == 2)
+        manifold.penetration = std::max(manifold.penetration, manifold.points[1].penetration);
+    return true;
+}
+
+bool Collision::PolygonvsCircleLocal(const PolygonShape& polygon, const Vector2& center, float radius, float margin,
+                                     Vector2& normal, Vector2& point, float& penetration)
+{
+    // Face the centre is farthest in front of
+    int face = 0;
+    float separation = -FLT_MAX;
+    for (int i = 0; i < polygon.count; i++)
+    {
+        float s = polygon.normals[i].dot(center - polygon.vertices[i]);
+        if (s > separation)
+        {
+            separation = s;
+            face = i;
+        }
+    }
+    if (separation > radius + margin)
+        return false;
+
+    // Centre inside: out through that face
+    if (separation < FLT_EPSILON)
+    {
+        normal = polygon.normals[face];
+        point = center - normal * separation;
+        penetration = radius - separation;
+        return true;
+    }
+
+    // Outside: closest to the face or to one of its ends
+    const Vector2& v1 = polygon.vertices[face];
+    const Vector2& v2 = polygon.vertices[(face + 1) % polygon.count];
+    bool atV1 = (center - v1).dot(v2 - v1) <= 0.0f;
+    bool atV2 = (center - v2).dot(v1 - v2) <= 0.0f;
+    point = atV1 ? v1 : atV2 ? v2 : center - polygon.normals[face] * separation;
+
+    Vector2 difference = center - point;
+    float distanceSq = difference.lengthSquared();
+    if (distanceSq > (radius + margin) * (radius + margin))
+        return false;
+    float distance = std::sqrt(distanceSq);
+    normal = atV1 || atV2 ? difference / distance : polygon.normals[face];
+    penetration = radius - distance;
+    return true;
+}
+
+bool Collision::PolygonvsCircle(const RigidBody& a, const RigidBody& b,
+                                const PolygonShape& shapeA, const CircleShape& shapeB,
+                                float cosA, float sinA,
+                                CollisionManifold& manifold, float margin)
+{
+    // Circle centre in polygon space
+    Vector2 diff = b.position - a.position;
+    Vector2 local(diff.x * cosA + diff.y * sinA, -diff.x * sinA + diff.y * cosA);
+
+    Vector2 normal, point;
+    float penetration;
+    if (!PolygonvsCircleLocal(shapeA, local, shapeB.radius, margin, normal, point, penetration))
+        return false;
+
+    manifold.normal = Vector2(normal.x * cosA - normal.y * sinA, normal.x * sinA + normal.y * cosA);
+    manifold.penetration = penetration;
+    manifold.AddPoint(a.position + Vector2(point.x * cosA - point.y * sinA, point.x * sinA + point.y * cosA), penetration);
     return true;
 }
 
@@ -185,7 +458,7 @@ bool Collision::AABBvsAABB(const RigidBody &a, const RigidBody &b, CollisionMani
         // Contact point on the edge between the two boxes
         float contactX = (delta.x < 0) ? (a.position.x - shapeA->halfsize.x) : (a.position.x + shapeA->halfsize.x);
         float contactY = a.position.y + Clamp(delta.y, -shapeA->halfsize.y, shapeA->halfsize.y);
-        manifold.contactPoint = Vector2(contactX, contactY);
+        manifold.AddPoint(Vector2(contactX, contactY), manifold.penetration);
     }
     else
     {
@@ -194,7 +467,7 @@ bool Collision::AABBvsAABB(const RigidBody &a, const RigidBody &b, CollisionMani
         // Contact point on the edge between the two boxes
         float contactX = a.position.x + Clamp(delta.x, -shapeA->halfsize.x, shapeA->halfsize.x);
         float contactY = (delta.y < 0) ? (a.position.y - shapeA->halfsize.y) : (a.position.y + shapeA->halfsize.y);
-        manifold.contactPoint = Vector2(contactX, contactY);
+        manifold.AddPoint(Vector2(contactX, contactY), manifold.penetration);
     }
 
     AABB aabbA = GetAABB(a, *shapeA);
@@ -227,7 +500,7 @@ bool Collision::CirclevsCircle(const RigidBody &a,
 
     manifold.penetration = radiiSum - dist;
     // Contact point is on the surface of circle A along the collision normal
-    manifold.contactPoint = a.position + manifold.normal * shapeA.radius;
+    manifold.AddPoint(a.position + manifold.normal * shapeA.radius, manifold.penetration);
     return true;
 }
 
@@ -271,7 +544,7 @@ bool Collision::AABBvsCircle(const RigidBody &a,
 
     manifold.penetration = shapeB.radius - distance;
     // Contact point is the closest point on the AABB to the circle
-    manifold.contactPoint = closest;
+    manifold.AddPoint(closest, manifold.penetration);
     return true;
 }
 
@@ -334,7 +607,7 @@ bool Collision::OBBvsCircle(const RigidBody& a,
     }
     
     manifold.penetration = shapeB.radius - distance;
-    manifold.contactPoint = closest;
+    manifold.AddPoint(closest, manifold.penetration);
     
     return true;
 }
@@ -345,6 +618,10 @@ void Collision::CheckCollision(RigidBody &a, RigidBody &b)
     ShapeType typeA = a.collider ? a.collider->shape->GetType() : ShapeType::AABB;
     ShapeType typeB = b.collider ? b.collider->shape->GetType() : ShapeType::AABB;
 
+    // Terrain has no pairwise test here; the world collides it (see TerrainCollision.h)
+    if ((a.collider && a.collider->shape->IsTerrain()) || (b.collider && b.collider->shape->IsTerrain()))
+        return;
+
     if (typeA == ShapeType::AABB && typeB == ShapeType::AABB)
     {   
         CollisionManifold m;
@@ -388,4 +665,29 @@ void Collision::CheckCollision(RigidBody &a, RigidBody &b)
         if (OBBvsCircle(a, b, *box, *circle, m))
             CollisionResolver::Resolve(a, b, m);
     }
+    else if (typeA == ShapeType::Polygon || typeB == ShapeType::Polygon)
+    {
+        CollisionManifold m;
+        float cosA = std::cos(a.orientation), sinA = std::sin(a.orientation);
+        float cosB = std::cos(b.orientation), sinB = std::sin(b.orientation);
+        if (typeB == ShapeType::Circle)
+        {
+            if (PolygonvsCircle(a, b, *static_cast<PolygonShape *>(a.collider->shape),
+                                *static_cast<CircleShape *>(b.collider->shape), cosA, sinA, m))
+                CollisionResolver::Resolve(a, b, m);
+        }
+        else if (typeA == ShapeType::Circle)
+        {
+            if (PolygonvsCircle(b, a, *static_cast<PolygonShape *>(b.collider->shape),
+                                *static_cast<CircleShape *>(a.collider->shape), cosB, sinB, m))
+            {
+                m.normal = m.normal * -1.0f;
+                CollisionResolver::Resolve(a, b, m);
+            }
+        }
+        else if (PolygonvsPolygon(a, b, cosA, sinA, cosB, sinB, m))
+        {
+            CollisionResolver::Resolve(a, b, m);
+        }
+    }
 }
\ No newline at end of file
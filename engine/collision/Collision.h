@@ -2,6 +2,7 @@
 #include "AABBCollider.h"
 #include "../shapes/AABBShape.h"
 #include "../shapes/CircleShape.h"
+#include "../shapes/PolygonShape.h"
 #include "../physics/RigidBody.h"
 #include "CollisionManifold.h"
 
@@ -14,6 +15,20 @@ class Collision{
         static bool OBBvsOBB(const RigidBody &a, 
                              const RigidBody &b,
                              CollisionManifold& manifold);
+        // Same test, trying axisHint first (see Collision.cpp)
+        static bool OBBvsOBB(const RigidBody &a,
+                             const RigidBody &b,
+                             CollisionManifold& manifold,
+                             int& axisHint);
+        // With the cos/sin of both orientations already computed. Boxes up to
+        // margin apart also collide, with negative (speculative) penetration
+        static bool OBBvsOBB(const RigidBody &a,
+                             const RigidBody &b,
+                             float cosA, float sinA,
+                             float cosB, float sinB,
+                             CollisionManifold& manifold,
+                             int& axisHint,
+                             float margin = 0.0f);
         static bool CirclevsCircle(const RigidBody& a,
                                    const RigidBody& b, 
                                    const CircleShape& shapeA, 
@@ -29,8 +44,37 @@ class Collision{
                                 const AABBShape& shapeA,
                                 const CircleShape& shapeB,
                                 CollisionManifold& manifold);
+        // Polygons against polygons or boxes (each body may be either): SAT over
+        // both sets of edge normals, using the polygons' support search, then
+        // ClipPolygons. Margin works as in OBBvsOBB
+        static bool PolygonvsPolygon(const RigidBody& a,
+                                     const RigidBody& b,
+                                     float cosA, float sinA,
+                                     float cosB, float sinB,
+                                     CollisionManifold& manifold,
+                                     float margin = 0.0f);
+        // Normal from the polygon (a) to the circle (b)
+        static bool PolygonvsCircle(const RigidBody& a,
+                                    const RigidBody& b,
+                                    const PolygonShape& shapeA,
+                                    const CircleShape& shapeB,
+                                    float cosA, float sinA,
+                                    CollisionManifold& manifold,
+                                    float margin = 0.0f);
+        // The same in the polygon's local space: normal out of the polygon, closest
+        // point on it and penetration of a circle at center
+        static bool PolygonvsCircleLocal(const PolygonShape& polygon, const Vector2& center, float radius, float margin,
+                                         Vector2& normal, Vector2& point, float& penetration);
         static void CheckCollision(RigidBody& a, RigidBody& b);
+
+        // Up to two contact points between convex polygons (counter-clockwise
+        // vertices, outward edge normals) by reference/incident edge clipping.
+        // Points up to margin in front of the reference face are kept.
+        static int ClipPolygons(const Vector2* refVertices, const Vector2* refNormals, int refCount, int refFace,
+                                const Vector2* incVertices, const Vector2* incNormals, int incCount,
+                                bool flip, CollisionManifold& manifold, float margin = 0.0f);
     private:
-        static void GetOBBCorners(const RigidBody& body, const AABBShape& shape, Vector2 corners[4]);
+        static void GetOBBCorners(const RigidBody& body, const AABBShape& shape, float cosA, float sinA, Vector2 corners[4]);
+        static void GetOBBNormals(float cosA, float sinA, Vector2 normals[4]);
         static float ProjectOntoAxis(const Vector2 corners[4], int numCorners, const Vector2& axis, float& min, float& max);
 };
\ No newline at end of file
@@ -1,8 +1,23 @@
 #pragma once
+#include <cstdint>
 #include "../math/Vector2.h"
 
+struct ContactPoint{
+    Vector2 position;
+    float penetration;
+    uint32_t id;    // Features (edges/vertices) that produced the point, 0 for single-point shapes
+};
+
 struct CollisionManifold{
     Vector2 normal;
-    float penetration;
-    Vector2 contactPoint;
+    float penetration;      // Deepest contact point
+    ContactPoint points[2];
+    int contactCount = 0;
+
+    void AddPoint(const Vector2& position, float depth, uint32_t id = 0){
+        points[contactCount].position = position;
+        points[contactCount].penetration = depth;
+        points[contactCount].id = id;
+        contactCount++;
+    }
 };
\ No newline at end of file
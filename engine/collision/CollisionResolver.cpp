@@ -1,21 +1,55 @@
 #include "CollisionResolver.h"
 #include <cmath>
 #include <algorithm>
+#include <limits>
 #include "../shapes/AABBShape.h"
+#include "../core/Config.h"
 
-void CollisionResolver::Resolve(
+// Static bodies are never written to, so contacts that only share a static
+// body can be solved at the same time
+static void ApplyImpulseAt(RigidBody &body, const Vector2 &impulse, const Vector2 &r)
+{
+    if (body.inverseMass == 0.0f)
+        return;
+    body.velocity += impulse * body.inverseMass;
+    body.angularVelocity += r.cross(impulse) * body.inverseInertia;
+}
+
+static void ClampSmallVelocities(RigidBody &body)
+{
+    const float velocityEpsilon = 0.5f;
+    const float angularEpsilon = 0.05f; // Increased to stop spinning earlier
+
+    if (body.inverseMass == 0.0f)
+        return;
+    if (std::abs(body.velocity.x) < velocityEpsilon)
+        body.velocity.x = 0.0f;
+    if (std::abs(body.velocity.y) < velocityEpsilon)
+        body.velocity.y = 0.0f;
+    if (std::abs(body.angularVelocity) < angularEpsilon)
+        body.angularVelocity = 0.0f;
+}
+
+float CollisionResolver::Resolve(
     RigidBody &a,
     RigidBody &b,
-    const CollisionManifold &m)
+    const CollisionManifold &m,
+    float deltaTime,
+    float *normalImpulse)
 {
-    a.sleepTime = 0.0f;
-    b.sleepTime = 0.0f;
-    a.isSleeping = false;
-    b.isSleeping = false;
     // ---- early out ----
+    if (normalImpulse)
+        *normalImpulse = 0.0f;
     float totalInvMass = a.inverseMass + b.inverseMass;
     if (totalInvMass == 0.0f)
-        return;
+        return 0.0f;
+
+    // Wake both bodies; they fall asleep again at the end of the step
+    // unless the contact actually set them moving
+    if (a.inverseMass > 0.0f)
+        a.isSleeping = false;
+    if (b.inverseMass > 0.0f)
+        b.isSleeping = false;
 
     const float slop = 0.01f;   // allowed penetration
     const float percent = 0.8f; // correction strength
@@ -25,41 +59,83 @@ void CollisionResolver::Resolve(
 
     Vector2 correction = m.normal * correctionMag;
 
-    a.position -= correction * a.inverseMass;
-    b.position += correction * b.inverseMass;
+    if (a.inverseMass > 0.0f)
+        a.position -= correction * a.inverseMass;
+    if (b.inverseMass > 0.0f)
+        b.position += correction * b.inverseMass;
+
+    float restitution = (a.collider->restitution + b.collider->restitution) / 2.0f;
+    // Use geometric mean for friction coefficient
+    float mu = std::sqrt(a.collider->dynamicFriction * b.collider->dynamicFriction);
+
+    // Solve each contact point in turn; velocities updated by the first are seen by the second
+    float inverseDeltaTime = deltaTime > 0.0f ? 1.0f / deltaTime : std::numeric_limits<float>::infinity();
+    bool applied = false;
+    float maxImpulse = 0.0f;
+    for (int i = 0; i < m.contactCount; i++)
+    {
+        float impulse = 0.0f;
+        applied |= ResolvePoint(a, b, m.normal, m.points[i], inverseDeltaTime, restitution, mu, impulse);
+        maxImpulse = std::max(maxImpulse, impulse);
+        if (normalImpulse)
+            *normalImpulse += impulse;
+    }
+
+    // Objects are separating
+    if (!applied)
+        return 0.0f;
+
+    ClampSmallVelocities(a);
+    ClampSmallVelocities(b);
+    return maxImpulse * totalInvMass;
+}
 
-    // Recalculate contact vectors after position correction
-    Vector2 ra = m.contactPoint - a.position;
-    Vector2 rb = m.contactPoint - b.position;
+// Normal and friction impulse at one contact point; false if the bodies are separating there
+bool CollisionResolver::ResolvePoint(
+    RigidBody &a,
+    RigidBody &b,
+    const Vector2 &normal,
+    const ContactPoint &point,
+    float inverseDeltaTime,
+    float restitution,
+    float mu,
+    float &normalImpulse)
+{
+    // Contact vectors from the corrected positions
+    Vector2 ra = point.position - a.position;
+    Vector2 rb = point.position - b.position;
     
     Vector2 va = a.velocity + Vector2(-a.angularVelocity * ra.y, a.angularVelocity * ra.x);
     Vector2 vb = b.velocity + Vector2(-b.angularVelocity * rb.y, b.angularVelocity * rb.x);
     Vector2 rv = vb - va;
     
-    float velAlongNormal = rv.dot(m.normal);
-
-    // Objects are separating
-    if (velAlongNormal > 0.0f)
-        return;
+    float velAlongNormal = rv.dot(normal);
 
-    float restitution = (a.collider->restitution + b.collider->restitution) / 2.0f;
+    // Speculative point: the bodies are still apart, so only the part of the
+    // approach that would close the gap within the step is removed
+    float gapVelocity = point.penetration < 0.0f ? -point.penetration * inverseDeltaTime : 0.0f;
+    if (velAlongNormal + gapVelocity > 0.0f)
+        return false;
 
     // Calculate impulse with angular components
-    float raCrossN = ra.cross(m.normal);
-    float rbCrossN = rb.cross(m.normal);
-    float invMassSum = totalInvMass + raCrossN * raCrossN * a.inverseInertia + rbCrossN * rbCrossN * b.inverseInertia;
+    float raCrossN = ra.cross(normal);
+    float rbCrossN = rb.cross(normal);
+    float invMassSum = a.inverseMass + b.inverseMass + raCrossN * raCrossN * a.inverseInertia + rbCrossN * rbCrossN * b.inverseInertia;
     
+    // Slow approaches (a body resting under gravity) don't bounce
+    if (-velAlongNormal < Config::RestitutionVelocityThreshold)
+        restitution = 0.0f;
+
     float j = -(1.0f + restitution) * velAlongNormal;
+    if (gapVelocity > 0.0f)
+        j = -(velAlongNormal + gapVelocity); // No bounce until they touch
     j /= invMassSum;
+    normalImpulse = j;
 
     // ---- impulse resolution ----
-    Vector2 impulse = m.normal * j;
-    a.velocity -= impulse * a.inverseMass;
-    b.velocity += impulse * b.inverseMass;
-
-    // Angular velocity update
-    a.angularVelocity -= ra.cross(impulse) * a.inverseInertia;
-    b.angularVelocity += rb.cross(impulse) * b.inverseInertia;
+    Vector2 impulse = normal * j;
+    ApplyImpulseAt(a, impulse * -1.0f, ra);
+    ApplyImpulseAt(b, impulse, rb);
 
     // ---- friction resolution ----
     // Recalculate relative velocity after normal impulse
@@ -67,7 +143,7 @@ void CollisionResolver::Resolve(
     vb = b.velocity + Vector2(-b.angularVelocity * rb.y, b.angularVelocity * rb.x);
     rv = vb - va;
     
-    Vector2 tangent = rv - m.normal * rv.dot(m.normal);
+    Vector2 tangent = rv - normal * rv.dot(normal);
     float tangentLen = tangent.length();
 
     if (tangentLen > 1e-6f)
@@ -77,43 +153,20 @@ void CollisionResolver::Resolve(
         // Calculate friction impulse with angular components
         float raCrossT = ra.cross(tangent);
         float rbCrossT = rb.cross(tangent);
-        float invMassSumFriction = totalInvMass + raCrossT * raCrossT * a.inverseInertia + rbCrossT * rbCrossT * b.inverseInertia;
+        float invMassSumFriction = a.inverseMass + b.inverseMass + raCrossT * raCrossT * a.inverseInertia + rbCrossT * rbCrossT * b.inverseInertia;
         
         float jt = -rv.dot(tangent);
         jt /= invMassSumFriction;
 
-        // Use geometric mean for friction coefficient
-        float mu = std::sqrt(a.collider->dynamicFriction * b.collider->dynamicFriction);
-
         float maxFriction = mu * std::abs(j);
 
         jt = std::clamp(jt, -maxFriction, maxFriction);
 
         Vector2 frictionImpulse = tangent * jt;
 
-        a.velocity -= frictionImpulse * a.inverseMass;
-        b.velocity += frictionImpulse * b.inverseMass;
-        
-        // Apply angular friction
-        a.angularVelocity -= ra.cross(frictionImpulse) * a.inverseInertia;
-        b.angularVelocity += rb.cross(frictionImpulse) * b.inverseInertia;
+        ApplyImpulseAt(a, frictionImpulse * -1.0f, ra);
+        ApplyImpulseAt(b, frictionImpulse, rb);
     }
 
-    const float velocityEpsilon = 0.5f;
-    const float angularEpsilon = 0.05f; // Increased to stop spinning earlier
-
-    if (std::abs(a.velocity.x) < velocityEpsilon)
-        a.velocity.x = 0.0f;
-    if (std::abs(a.velocity.y) < velocityEpsilon)
-        a.velocity.y = 0.0f;
-    if (std::abs(b.velocity.x) < velocityEpsilon)
-        b.velocity.x = 0.0f;
-    if (std::abs(b.velocity.y) < velocityEpsilon)
-        b.velocity.y = 0.0f;
-    
-    // Clamp small angular velocities
-    if (std::abs(a.angularVelocity) < angularEpsilon)
-        a.angularVelocity = 0.0f;
-    if (std::abs(b.angularVelocity) < angularEpsilon)
-        b.angularVelocity = 0.0f;
+    return true;
 }
@@ -4,5 +4,13 @@
 
 class CollisionResolver{
     public:
-        static void Resolve(RigidBody &a, RigidBody &b, const CollisionManifold& manifold);
+        // Returns the residual: the largest normal velocity change applied (pixels/s).
+        // Points with negative penetration are speculative: they only act if the
+        // bodies would close the gap within deltaTime (never, if deltaTime is 0).
+        // normalImpulse, if given, receives the sum of the points' normal impulses.
+        static float Resolve(RigidBody &a, RigidBody &b, const CollisionManifold& manifold, float deltaTime = 0.0f,
+                             float* normalImpulse = nullptr);
+    private:
+        static bool ResolvePoint(RigidBody &a, RigidBody &b, const Vector2& normal, const ContactPoint& point,
+                                 float inverseDeltaTime, float restitution, float mu, float& normalImpulse);
 };
\ No newline at end of file
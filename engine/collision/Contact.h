@@ -0,0 +1,13 @@
+#pragma once
+#include "CollisionManifold.h"
+
+class RigidBody;
+
+// A detected collision waiting to be resolved. The manifold normal points from a to b.
+struct Contact{
+    RigidBody* a;
+    RigidBody* b;
+    int indexA, indexB;     // Positions of a and b in the world's body list
+    uint32_t part = 0;      // Piece of terrain a that b touches (rectangle or segment), 0 otherwise
+    CollisionManifold manifold;
+};
@@ -0,0 +1,81 @@
+#include "ContactSolver.h"
+#include "CollisionResolver.h"
+#include "../core/JobSystem.h"
+#include <algorithm>
+
+// Greedy colouring in contact order: each contact takes the lowest colour
+// neither of its dynamic bodies is already in
+void ContactSolver::Colour(const std::vector<Contact>& contacts, int bodyCount){
+    bodyColours.assign(bodyCount, 0);
+    contactColour.resize(contacts.size());
+    colourStart.assign(MaxColours + 2, 0);
+
+    for(size_t i = 0; i < contacts.size(); i++){
+        const Contact& contact = contacts[i];
+        bool dynamicA = contact.a->inverseMass > 0.0f;
+        bool dynamicB = contact.b->inverseMass > 0.0f;
+
+        uint64_t used = 0;
+        if(dynamicA) used |= bodyColours[contact.indexA];
+        if(dynamicB) used |= bodyColours[contact.indexB];
+
+        int colour = 0;
+        while(colour < MaxColours && (used & (1ull << colour))) colour++;
+
+        if(colour < MaxColours){
+            if(dynamicA) bodyColours[contact.indexA] |= 1ull << colour;
+            if(dynamicB) bodyColours[contact.indexB] |= 1ull << colour;
+        }
+        contactColour[i] = static_cast<unsigned char>(colour);
+        colourStart[colour + 1]++;
+    }
+
+    colourCount = 0;
+    for(int c = 0; c <= MaxColours; c++){
+        if(colourStart[c + 1] > 0) colourCount = c + 1;
+        colourStart[c + 1] += colourStart[c];
+    }
+
+    // Stable counting sort by colour
+    ordered.resize(contacts.size());
+    colourFill.assign(colourStart.begin(), colourStart.end() - 1);
+    for(size_t i = 0; i < contacts.size(); i++)
+        ordered[colourFill[contactColour[i]]++] = static_cast<int>(i);
+}
+
+float ContactSolver::Solve(const std::vector<Contact>& contacts, int bodyCount, float deltaTime, float* impulses){
+    float residual = 0.0f;
+    if(!jobs || jobs->GetWorkerCount() == 0){
+        for(size_t i = 0; i < contacts.size(); i++){
+            const Contact& contact = contacts[i];
+            residual = std::max(residual, CollisionResolver::Resolve(*contact.a, *contact.b, contact.manifold, deltaTime,
+                                                                     impulses ? impulses + i : nullptr));
+        }
+        return residual;
+    }
+
+    // Residuals are written per contact and reduced afterwards, so threads don't share a maximum
+    Colour(contacts, bodyCount);
+    residuals.resize(contacts.size());
+
+    for(int c = 0; c < colourCount; c++){
+        const int* first = ordered.data() + colourStart[c];
+        int count = colourStart[c + 1] - colourStart[c];
+        auto resolveRange = [&](int begin, int end){
+            for(int i = begin; i < end; i++){
+                const Contact& contact = contacts[first[i]];
+                residuals[first[i]] = CollisionResolver::Resolve(*contact.a, *contact.b, contact.manifold, deltaTime,
+                                                                 impulses ? impulses + first[i] : nullptr);
+            }
+        };
+
+        if(c == MaxColours)
+            resolveRange(0, count);
+        else
+            jobs->ParallelFor(count, GrainSize, resolveRange);
+    }
+
+    for(float r : residuals)
+        residual = std::max(residual, r);
+    return residual;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include "Contact.h"
+
+class JobSystem;
+
+// Resolves the contacts found by the narrowphase. Without worker threads they are
+// resolved one after another in the order they were found. With more, the
+// contacts are first coloured so that no two contacts of a colour share a
+// dynamic body (static bodies are never written by the resolver, so they
+// don't conflict), and each colour is then resolved in parallel. Colours only
+// depend on contact order, so the result is the same for any worker count
+// above zero.
+class ContactSolver{
+    public:
+        // Not owned; null or a system without workers solves serially
+        void SetJobSystem(JobSystem* jobs) { this->jobs = jobs; }
+
+        // Returns the largest residual of any contact (see CollisionResolver::Resolve).
+        // impulses, if given, receives each contact's normal impulse (one per contact)
+        float Solve(const std::vector<Contact>& contacts, int bodyCount, float deltaTime, float* impulses = nullptr);
+
+        // Colours used by the last parallel Solve, including the overflow colour
+        int GetColourCount() const { return colourCount; }
+
+    private:
+        void Colour(const std::vector<Contact>& contacts, int bodyCount);
+
+        // Contacts of colour c are ordered[colourStart[c] .. colourStart[c + 1]).
+        // A body can take part in at most MaxColours colours; contacts that don't
+        // fit go into one extra colour that is solved serially.
+        static constexpr int MaxColours = 64;
+        static constexpr int GrainSize = 32;
+
+        JobSystem* jobs = nullptr;
+        std::vector<uint64_t> bodyColours;
+        std::vector<unsigned char> contactColour;
+        std::vector<int> colourStart;
+        std::vector<int> colourFill;
+        std::vector<int> ordered;
+        std::vector<float> residuals;
+        int colourCount = 0;
+};
@@ -0,0 +1,255 @@
+#include "Narrowphase.h"
+#include "Collision.h"
+#include "../core/JobSystem.h"
+#include <cmath>
+
+// Copy the shape data of every body into the kernels' parallel arrays
+void Narrowphase::Gather(const std::vector<RigidBody*>& bodies, const float* margins){
+    batchBodies.Resize(bodies.size());
+    trigAngle.resize(bodies.size(), std::nanf(""));
+    bodyFlags.resize(bodies.size());
+
+    int count = static_cast<int>(bodies.size());
+    if(jobs)
+        jobs->ParallelFor(count, GatherGrainSize, [&](int begin, int end){ GatherRange(bodies, margins, begin, end); });
+    else
+        GatherRange(bodies, margins, 0, count);
+}
+
+void Narrowphase::GatherRange(const std::vector<RigidBody*>& bodies, const float* margins, int begin, int end){
+    for(int i = begin; i < end; i++){
+        const RigidBody* body = bodies[i];
+        batchBodies.posX[i] = body->position.x;
+        batchBodies.posY[i] = body->position.y;
+        batchBodies.margin[i] = margins ? margins[i] : 0.0f;
+
+        uint8_t flags = 0;
+        if(body->isSleeping) flags |= Sleeping;
+        if(body->inverseMass == 0.0f) flags |= Static;
+        // Terrain pairs only come from the all-pairs broadphase; the world collides terrain itself
+        if(!body->collider || body->collider->shape->IsTerrain()){
+            bodyFlags[i] = flags | NoCollider;
+            continue;
+        }
+
+        Shape* shape = body->collider->shape;
+        if(shape->GetType() == ShapeType::Circle){
+            bodyFlags[i] = flags | Circle;
+            batchBodies.radius[i] = static_cast<CircleShape*>(shape)->radius;
+        } else {
+            if(shape->GetType() == ShapeType::Polygon){
+                bodyFlags[i] = flags | Polygon;
+                batchBodies.radius[i] = static_cast<PolygonShape*>(shape)->radius;
+            } else {
+                bodyFlags[i] = flags;
+                const Vector2& halfsize = static_cast<AABBShape*>(shape)->halfsize;
+                batchBodies.halfX[i] = halfsize.x;
+                batchBodies.halfY[i] = halfsize.y;
+                batchBodies.radius[i] = halfsize.length();
+            }
+            // Orientation only changes during integration, so later iterations
+            // of a step reuse the previous cos/sin
+            if(trigAngle[i] != body->orientation){
+                trigAngle[i] = body->orientation;
+                batchBodies.cosA[i] = std::cos(body->orientation);
+                batchBodies.sinA[i] = std::sin(body->orientation);
+            }
+        }
+    }
+}
+
+void Narrowphase::Run(const std::vector<RigidBody*>& bodies,
+                      const std::vector<std::pair<int, int>>& pairs,
+                      std::vector<Contact>& contacts,
+                      const float* margins)
+{
+    contacts.clear();
+    circleA.clear();
+    circleB.clear();
+    boxCircleA.clear();
+    boxCircleB.clear();
+    boxCircleSwapped.clear();
+    boxPairs.clear();
+    polygonPairs.clear();
+
+    if(pairs.empty())
+        return;
+    Gather(bodies, margins);
+
+    for(const auto& pair : pairs){
+        uint8_t a = bodyFlags[pair.first];
+        uint8_t b = bodyFlags[pair.second];
+
+        if((a & b & Sleeping) || (a & b & Static)) continue;
+        if((a | b) & NoCollider) continue;
+
+        if((a | b) & Polygon){
+            polygonPairs.push_back(pair);
+        } else if(a & b & Circle){
+            circleA.push_back(pair.first);
+            circleB.push_back(pair.second);
+        } else if(a & Circle){
+            boxCircleA.push_back(pair.second);
+            boxCircleB.push_back(pair.first);
+            boxCircleSwapped.push_back(true);
+        } else if(b & Circle){
+            boxCircleA.push_back(pair.first);
+            boxCircleB.push_back(pair.second);
+            boxCircleSwapped.push_back(false);
+        } else {
+            boxPairs.push_back(pair);
+        }
+    }
+
+    // Circle pairs
+    batchContacts.Clear();
+    BatchCollision::CirclevsCircle(batchBodies, circleA.data(), circleB.data(),
+                                   static_cast<int>(circleA.size()), batchContacts);
+    for(int i = 0; i < batchContacts.Size(); i++){
+        int pair = batchContacts.pair[i];
+        Contact contact;
+        contact.indexA = circleA[pair];
+        contact.indexB = circleB[pair];
+        contact.a = bodies[contact.indexA];
+        contact.b = bodies[contact.indexB];
+        contact.manifold.normal = Vector2(batchContacts.normalX[i], batchContacts.normalY[i]);
+        contact.manifold.penetration = batchContacts.penetration[i];
+        contact.manifold.AddPoint(Vector2(batchContacts.pointX[i], batchContacts.pointY[i]), contact.manifold.penetration);
+        contacts.push_back(contact);
+    }
+
+    // Box-circle pairs, flipped back to the broadphase order
+    batchContacts.Clear();
+    BatchCollision::OBBvsCircle(batchBodies, boxCircleA.data(), boxCircleB.data(),
+                                static_cast<int>(boxCircleA.size()), batchContacts);
+    for(int i = 0; i < batchContacts.Size(); i++){
+        int pair = batchContacts.pair[i];
+        Contact contact;
+        contact.indexA = boxCircleA[pair];
+        contact.indexB = boxCircleB[pair];
+        contact.a = bodies[contact.indexA];
+        contact.b = bodies[contact.indexB];
+        contact.manifold.normal = Vector2(batchContacts.normalX[i], batchContacts.normalY[i]);
+        contact.manifold.penetration = batchContacts.penetration[i];
+        contact.manifold.AddPoint(Vector2(batchContacts.pointX[i], batchContacts.pointY[i]), contact.manifold.penetration);
+        if(boxCircleSwapped[pair]){
+            std::swap(contact.a, contact.b);
+            std::swap(contact.indexA, contact.indexB);
+            contact.manifold.normal = contact.manifold.normal * -1.0f;
+        }
+        contacts.push_back(contact);
+    }
+
+    // Box pairs: bounding circles first, then SAT starting from the pair's cached axis.
+    // Cache entries are looked up here, since the map isn't thread-safe; the
+    // tests then fill one slot per pair and the hits are appended in pair order
+    run++;
+    boxTests.clear();
+    for(const auto& pair : boxPairs){
+        float dx = batchBodies.posX[pair.second] - batchBodies.posX[pair.first];
+        float dy = batchBodies.posY[pair.second] - batchBodies.posY[pair.first];
+        // Slightly inflated so rounding can't reject a touching pair
+        float margin = batchBodies.margin[pair.first] + batchBodies.margin[pair.second];
+        float bound = (batchBodies.radius[pair.first] + batchBodies.radius[pair.second] + margin) * 1.0001f;
+        if(dx * dx + dy * dy > bound * bound) continue;
+
+        uint64_t key = static_cast<uint64_t>(bodies[pair.first]->id) << 32 | bodies[pair.second]->id;
+        AxisCacheEntry& entry = axisCache[key];
+        entry.lastRun = run;
+        boxTests.push_back({pair.first, pair.second, &entry.axis});
+    }
+
+    boxContacts.resize(boxTests.size());
+    boxHits.resize(boxTests.size());
+    auto testRange = [&](int begin, int end){
+        for(int i = begin; i < end; i++){
+            const BoxTest& test = boxTests[i];
+            Contact contact;
+            contact.indexA = test.a;
+            contact.indexB = test.b;
+            contact.a = bodies[test.a];
+            contact.b = bodies[test.b];
+            float margin = batchBodies.margin[test.a] + batchBodies.margin[test.b];
+            boxHits[i] = Collision::OBBvsOBB(*contact.a, *contact.b,
+                                             batchBodies.cosA[test.a], batchBodies.sinA[test.a],
+                                             batchBodies.cosA[test.b], batchBodies.sinA[test.b],
+                                             contact.manifold, *test.axis, margin);
+            boxContacts[i] = contact;
+        }
+    };
+    int testCount = static_cast<int>(boxTests.size());
+    if(jobs)
+        jobs->ParallelFor(testCount, BoxGrainSize, testRange);
+    else
+        testRange(0, testCount);
+
+    for(int i = 0; i < testCount; i++){
+        if(boxHits[i])
+            contacts.push_back(boxContacts[i]);
+    }
+
+    // Polygon pairs: bounding circles, then polygon-circle or polygon-polygon
+    // (which also takes boxes). Circle pairs are tested polygon first and flipped back
+    polygonTests.clear();
+    for(const auto& pair : polygonPairs){
+        float dx = batchBodies.posX[pair.second] - batchBodies.posX[pair.first];
+        float dy = batchBodies.posY[pair.second] - batchBodies.posY[pair.first];
+        float margin = batchBodies.margin[pair.first] + batchBodies.margin[pair.second];
+        float bound = (batchBodies.radius[pair.first] + batchBodies.radius[pair.second] + margin) * 1.0001f;
+        if(dx * dx + dy * dy <= bound * bound)
+            polygonTests.push_back(pair);
+    }
+
+    polygonContacts.resize(polygonTests.size());
+    polygonHits.resize(polygonTests.size());
+    auto polygonRange = [&](int begin, int end){
+        for(int i = begin; i < end; i++){
+            int a = polygonTests[i].first;
+            int b = polygonTests[i].second;
+            Contact contact;
+            contact.indexA = a;
+            contact.indexB = b;
+            contact.a = bodies[a];
+            contact.b = bodies[b];
+            float margin = batchBodies.margin[a] + batchBodies.margin[b];
+            if((bodyFlags[a] | bodyFlags[b]) & Circle){
+                bool swapped = (bodyFlags[a] & Circle) != 0;
+                int polygon = swapped ? b : a;
+                int circle = swapped ? a : b;
+                polygonHits[i] = Collision::PolygonvsCircle(*bodies[polygon], *bodies[circle],
+                                                            *static_cast<PolygonShape*>(bodies[polygon]->collider->shape),
+                                                            *static_cast<CircleShape*>(bodies[circle]->collider->shape),
+                                                            batchBodies.cosA[polygon], batchBodies.sinA[polygon],
+                                                            contact.manifold, margin);
+                if(swapped)
+                    contact.manifold.normal = contact.manifold.normal * -1.0f;
+            } else {
+                polygonHits[i] = Collision::PolygonvsPolygon(*contact.a, *contact.b,
+                                                             batchBodies.cosA[a], batchBodies.sinA[a],
+                                                             batchBodies.cosA[b], batchBodies.sinA[b],
+                                                             contact.manifold, margin);
+            }
+            polygonContacts[i] = contact;
+        }
+    };
+    int polygonCount = static_cast<int>(polygonTests.size());
+    if(jobs)
+        jobs->ParallelFor(polygonCount, BoxGrainSize, polygonRange);
+    else
+        polygonRange(0, polygonCount);
+
+    for(int i = 0; i < polygonCount; i++){
+        if(polygonHits[i])
+            contacts.push_back(polygonContacts[i]);
+    }
+
+    // Forget pairs that haven't been tested for a while
+    if(run % AxisCacheSweepInterval == 0){
+        for(auto it = axisCache.begin(); it != axisCache.end();){
+            if(run - it->second.lastRun >= AxisCacheSweepInterval)
+                it = axisCache.erase(it);
+            else
+                ++it;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "BatchCollision.h"
+#include "Contact.h"
+
+class RigidBody;
+class JobSystem;
+
+// Turns broadphase pairs into contacts. Pairs are sorted by shape combination
+// so circle-circle and box-circle pairs go through the batch kernels; box-box
+// pairs use the scalar SAT test, which starts from the axis that separated (or
+// was the reference axis for) the same pair last time, and pairs with a
+// polygon use the scalar polygon tests. With a job system the gather and the
+// box-box and polygon tests run in parallel; contacts come out in the same
+// order either way.
+class Narrowphase{
+    public:
+        // Not owned; null runs everything on the calling thread
+        void SetJobSystem(JobSystem* jobs) { this->jobs = jobs; }
+
+        // margins (one per body, optional) turn on speculative contacts: pairs
+        // closer than the sum of their margins get contacts with a negative
+        // penetration equal to the gap
+        void Run(const std::vector<RigidBody*>& bodies,
+                 const std::vector<std::pair<int, int>>& pairs,
+                 std::vector<Contact>& contacts,
+                 const float* margins = nullptr);
+
+    private:
+        void Gather(const std::vector<RigidBody*>& bodies, const float* margins);
+        void GatherRange(const std::vector<RigidBody*>& bodies, const float* margins, int begin, int end);
+
+        static constexpr int GatherGrainSize = 256;
+        static constexpr int BoxGrainSize = 16;
+
+        JobSystem* jobs = nullptr;
+        BatchBodies batchBodies;
+        std::vector<float> trigAngle;   // Orientation that cosA/sinA were computed from
+
+        // Per-body flags used to sort pairs without touching the bodies again
+        enum BodyFlag : uint8_t { Sleeping = 1, Static = 2, NoCollider = 4, Circle = 8, Polygon = 16 };
+        std::vector<uint8_t> bodyFlags;
+        BatchContacts batchContacts;
+
+        // Pair lists per shape combination; box-circle pairs are stored box first
+        std::vector<int> circleA, circleB;
+        std::vector<int> boxCircleA, boxCircleB;
+        std::vector<bool> boxCircleSwapped;
+        std::vector<std::pair<int, int>> boxPairs;
+        std::vector<std::pair<int, int>> polygonPairs;
+
+        // Box pairs that passed the bounding-circle test, with one result slot each
+        struct BoxTest{
+            int a, b;
+            int* axis;
+        };
+        std::vector<BoxTest> boxTests;
+        std::vector<Contact> boxContacts;
+        std::vector<uint8_t> boxHits;
+
+        // Polygon pairs that passed the bounding-circle test, likewise
+        std::vector<std::pair<int, int>> polygonTests;
+        std::vector<Contact> polygonContacts;
+        std::vector<uint8_t> polygonHits;
+
+        // SAT axis per box pair, keyed by the body ids of (a, b)
+        struct AxisCacheEntry{
+            int axis = -1;
+            uint32_t lastRun = 0;
+        };
+        static constexpr uint32_t AxisCacheSweepInterval = 64;
+        std::unordered_map<uint64_t, AxisCacheEntry> axisCache;
+        uint32_t run = 0;
+};
@@ -0,0 +1,333 @@
+#include "TerrainCollision.h"
+#include "Collision.h"
+#include "../shapes/CircleShape.h"
+#include "../shapes/PolygonShape.h"
+#include "../shapes/TileGridShape.h"
+#include "../shapes/HeightfieldShape.h"
+#include <algorithm>
+#include <cmath>
+
+static float BoundingRadius(const Shape* shape){
+    if(shape->GetType() == ShapeType::Circle) return static_cast<const CircleShape*>(shape)->radius;
+    if(shape->GetType() == ShapeType::Polygon) return static_cast<const PolygonShape*>(shape)->radius;
+    return static_cast<const AABBShape*>(shape)->halfsize.length();
+}
+
+// Whether the tile just across a rectangle face (point on the face, normal out of it) is solid
+static bool AcrossIsSolid(const TileGridShape& grid, const Vector2& origin, const Vector2& point, const Vector2& normal){
+    float tile = grid.GetTileSize();
+    Vector2 probe = point + normal * (0.5f * tile) - origin;
+    return grid.IsSolid(static_cast<int>(std::floor(probe.x / tile)), static_cast<int>(std::floor(probe.y / tile)));
+}
+
+TerrainCollision::TerrainCollision() : rectShape(Vector2(0, 0)), rectCollider(&rectShape), rectBody(0.0f) {
+    rectBody.inverseMass = 0.0f;
+    rectBody.collider = &rectCollider;
+}
+
+void TerrainCollision::Collide(RigidBody* terrain, int terrainIndex, RigidBody* body, int bodyIndex,
+                               float margin, std::vector<Contact>& contacts)
+{
+    if(terrain->collider->shape->GetType() == ShapeType::TileGrid)
+        CollideTileGrid(terrain, terrainIndex, body, bodyIndex, margin, contacts);
+    else
+        CollideHeightfield(terrain, terrainIndex, body, bodyIndex, margin, contacts);
+}
+
+bool TerrainCollision::ComputeTimeOfImpact(RigidBody* terrain, const Shape& shape, const Sweep& sweep, const AABB& bounds,
+                                           float target, float& t, DistanceOutput& contact)
+{
+    const Vector2 origin = terrain->position;
+    bool hit = false;
+    t = 1.0f;
+    auto sweepAgainst = [&](const Shape& piece, const Vector2& position){
+        float pieceT;
+        DistanceOutput pieceContact;
+        if(TimeOfImpact::Compute(shape, sweep, piece, position, 0.0f, target, pieceT, pieceContact) && pieceT < t){
+            t = pieceT;
+            contact = pieceContact;
+            hit = true;
+        }
+    };
+
+    if(terrain->collider->shape->GetType() == ShapeType::TileGrid){
+        // Each merged rectangle under the swept bounds, as a box
+        TileGridShape& grid = *static_cast<TileGridShape*>(terrain->collider->shape);
+        const float tile = grid.GetTileSize();
+        auto cell = [](float v, int count){ return static_cast<int>(std::floor(std::max(-1.0f, std::min(v, static_cast<float>(count))))); };
+        grid.Query(cell((bounds.min.x - origin.x) / tile, grid.GetColumns()), cell((bounds.min.y - origin.y) / tile, grid.GetRows()),
+                   cell((bounds.max.x - origin.x) / tile, grid.GetColumns()), cell((bounds.max.y - origin.y) / tile, grid.GetRows()), rects);
+        const std::vector<TileGridShape::Rect>& all = grid.GetRects();
+        for(int k : rects){
+            const TileGridShape::Rect& rect = all[k];
+            Vector2 min = origin + Vector2(rect.column * tile, rect.row * tile);
+            rectShape.halfsize = Vector2(rect.columns * tile, rect.rows * tile) * 0.5f;
+            sweepAgainst(rectShape, min + rectShape.halfsize);
+        }
+        return hit;
+    }
+
+    // Each segment under the swept bounds, as the slab of ground below it
+    const HeightfieldShape& field = *static_cast<const HeightfieldShape*>(terrain->collider->shape);
+    const float spacing = field.spacing;
+    int segments = field.GetSegmentCount();
+    float left = (bounds.min.x - origin.x) / spacing;
+    float right = (bounds.max.x - origin.x) / spacing;
+    if(segments == 0 || right < 0.0f || left >= segments) return false;
+    int first = std::max(static_cast<int>(std::floor(left)), 0);
+    int last = std::min(static_cast<int>(std::floor(right)), segments - 1);
+    for(int i = first; i <= last; i++){
+        Vector2 p0 = origin + Vector2(i * spacing, field.heights[i]);
+        Vector2 p1 = origin + Vector2((i + 1) * spacing, field.heights[i + 1]);
+        if(std::min(p0.y, p1.y) > bounds.max.y) continue;
+        float bottom = std::max(p0.y, p1.y) + spacing;
+        Vector2 slab[4] = { p0, p1, Vector2(p1.x, bottom), Vector2(p0.x, bottom) };
+        Vector2 corner(p0.x, std::min(p0.y, p1.y));
+        for(Vector2& v : slab) v -= corner;
+        PolygonShape piece(slab, 4);
+        // The polygon is centred on its centroid: place it back over the segment
+        sweepAgainst(piece, corner - piece.localMin);
+    }
+    return hit;
+}
+
+void TerrainCollision::CollideTileGrid(RigidBody* terrain, int terrainIndex, RigidBody* body, int bodyIndex,
+                                       float margin, std::vector<Contact>& contacts)
+{
+    TileGridShape& grid = *static_cast<TileGridShape*>(terrain->collider->shape);
+    const Shape* shape = body->collider->shape;
+    const Vector2 origin = terrain->position;
+    const float tile = grid.GetTileSize();
+
+    // Tiles under the bounding square, clamped before the cast so far bodies can't overflow it
+    float reach = BoundingRadius(shape) + margin;
+    auto cell = [](float v, int count){ return static_cast<int>(std::floor(std::max(-1.0f, std::min(v, static_cast<float>(count))))); };
+    Vector2 local = body->position - origin;
+    grid.Query(cell((local.x - reach) / tile, grid.GetColumns()), cell((local.y - reach) / tile, grid.GetRows()),
+               cell((local.x + reach) / tile, grid.GetColumns()), cell((local.y + reach) / tile, grid.GetRows()), rects);
+    if(rects.empty()) return;
+
+    const std::vector<TileGridShape::Rect>& all = grid.GetRects();
+    bool circle = shape->GetType() == ShapeType::Circle;
+    float cosB = 1.0f, sinB = 0.0f;
+    if(!circle){
+        cosB = std::cos(body->orientation);
+        sinB = std::sin(body->orientation);
+    }
+
+    for(int k : rects){
+        const TileGridShape::Rect& rect = all[k];
+        Vector2 min = origin + Vector2(rect.column * tile, rect.row * tile);
+        Vector2 max = min + Vector2(rect.columns * tile, rect.rows * tile);
+
+        Contact contact;
+        contact.a = terrain;
+        contact.b = body;
+        contact.indexA = terrainIndex;
+        contact.indexB = bodyIndex;
+        contact.part = static_cast<uint32_t>(k);
+        CollisionManifold& m = contact.manifold;
+
+        if(circle){
+            float radius = static_cast<const CircleShape*>(shape)->radius;
+            Vector2 c = body->position;
+            Vector2 closest(std::max(min.x, std::min(c.x, max.x)), std::max(min.y, std::min(c.y, max.y)));
+            Vector2 d = c - closest;
+            float distSq = d.lengthSquared();
+            if(distSq > 0.0f){
+                if(distSq > (radius + margin) * (radius + margin)) continue;
+                float dist = std::sqrt(distSq);
+                m.normal = d / dist;
+                m.AddPoint(closest, radius - dist);
+            } else {
+                // Centre inside: out through the nearest face that isn't shared with another tile
+                const Vector2 normals[4] = { Vector2(-1, 0), Vector2(1, 0), Vector2(0, -1), Vector2(0, 1) };
+                const float depths[4] = { c.x - min.x, max.x - c.x, c.y - min.y, max.y - c.y };
+                int best = -1;
+                for(int f = 0; f < 4; f++){
+                    Vector2 face = c + normals[f] * depths[f];
+                    if((best < 0 || depths[f] < depths[best]) && !AcrossIsSolid(grid, origin, face, normals[f]))
+                        best = f;
+                }
+                if(best < 0) continue;
+                m.normal = normals[best];
+                m.AddPoint(c + normals[best] * depths[best], radius + depths[best]);
+            }
+        } else {
+            rectShape.halfsize = (max - min) * 0.5f;
+            rectBody.position = (min + max) * 0.5f;
+            int axisHint = -1;
+            bool hit = shape->GetType() == ShapeType::Polygon
+                ? Collision::PolygonvsPolygon(rectBody, *body, 1.0f, 0.0f, cosB, sinB, m, margin)
+                : Collision::OBBvsOBB(rectBody, *body, 1.0f, 0.0f, cosB, sinB, m, axisHint, margin);
+            if(!hit) continue;
+        }
+
+        // Drop points on faces shared with a solid tile: the neighbouring
+        // rectangle's own face is the one the body should meet
+        if(std::abs(m.normal.x) > 0.999f || std::abs(m.normal.y) > 0.999f){
+            Vector2 n(std::round(m.normal.x), std::round(m.normal.y));
+            int kept = 0;
+            for(int p = 0; p < m.contactCount; p++){
+                Vector2 face(std::max(min.x, std::min(m.points[p].position.x, max.x)),
+                             std::max(min.y, std::min(m.points[p].position.y, max.y)));
+                if(n.x != 0.0f) face.x = n.x > 0.0f ? max.x : min.x;
+                else face.y = n.y > 0.0f ? max.y : min.y;
+                if(!AcrossIsSolid(grid, origin, face, n))
+                    m.points[kept++] = m.points[p];
+            }
+            m.contactCount = kept;
+        }
+        if(m.contactCount == 0) continue;
+
+        m.penetration = m.points[0].penetration;
+        if(m.contactCount > 1)
+            m.penetration = std::max(m.penetration, m.points[1].penetration);
+        contacts.push_back(contact);
+    }
+}
+
+void TerrainCollision::CollideHeightfield(RigidBody* terrain, int terrainIndex, RigidBody* body, int bodyIndex,
+                                         float margin, std::vector<Contact>& contacts)
+{
+    const HeightfieldShape& field = *static_cast<const HeightfieldShape*>(terrain->collider->shape);
+    const Shape* shape = body->collider->shape;
+    const Vector2 origin = terrain->position;
+    const float spacing = field.spacing;
+    int segments = field.GetSegmentCount();
+
+    // Segments under the bounding square
+    float reach = BoundingRadius(shape) + margin;
+    float left = (body->position.x - reach - origin.x) / spacing;
+    float right = (body->position.x + reach - origin.x) / spacing;
+    if(segments == 0 || right < 0.0f || left >= segments) return;
+    int first = std::max(static_cast<int>(std::floor(left)), 0);
+    int last = std::min(static_cast<int>(std::floor(right)), segments - 1);
+
+    auto vertex = [&](int i){ return origin + Vector2(i * spacing, field.heights[i]); };
+    // One contact per segment (part i) or peak (part i with the top bit set)
+    auto makeContact = [&](uint32_t part){
+        Contact contact;
+        contact.a = terrain;
+        contact.b = body;
+        contact.indexA = terrainIndex;
+        contact.indexB = bodyIndex;
+        contact.part = part;
+        return contact;
+    };
+
+    if(shape->GetType() == ShapeType::Circle){
+        float radius = static_cast<const CircleShape*>(shape)->radius;
+        Vector2 c = body->position;
+        for(int i = first; i <= last; i++){
+            Vector2 p0 = vertex(i);
+            Vector2 edge = vertex(i + 1) - p0;
+            float length = edge.length();
+            Vector2 t = edge / length;
+            Vector2 n(t.y, -t.x);
+
+            float s = (c - p0).dot(t);
+            float side = (c - p0).dot(n);
+            Contact contact = makeContact(static_cast<uint32_t>(i));
+            CollisionManifold& m = contact.manifold;
+            if(side < 0.0f && s >= 0.0f && s <= length){
+                // Centre below the surface: straight up out of it
+                m.normal = n;
+                m.AddPoint(c - n * side, radius - side);
+            } else {
+                float clamped = std::max(0.0f, std::min(s, length));
+                // A shared vertex belongs to the segment that ends there
+                if(clamped == 0.0f && i > first) continue;
+                Vector2 closest = p0 + t * clamped;
+                Vector2 d = c - closest;
+                float distSq = d.lengthSquared();
+                if(distSq > (radius + margin) * (radius + margin)) continue;
+                float dist = std::sqrt(distSq);
+                m.normal = dist > 1e-6f ? d / dist : n;
+                m.AddPoint(closest, radius - dist);
+            }
+            m.penetration = m.points[0].penetration;
+            contacts.push_back(contact);
+        }
+        return;
+    }
+
+    // Boxes and polygons: each corner against the segment under it, one
+    // contact per segment with its two deepest corners
+    const PolygonShape* polygon = shape->GetType() == ShapeType::Polygon ? static_cast<const PolygonShape*>(shape) : nullptr;
+    const Vector2 halfsize = polygon ? Vector2() : static_cast<const AABBShape*>(shape)->halfsize;
+    float cosB = std::cos(body->orientation);
+    float sinB = std::sin(body->orientation);
+    Vector2 localCorners[PolygonShape::MaxVertices] = { Vector2(-halfsize.x, -halfsize.y), Vector2(halfsize.x, -halfsize.y),
+                                                        Vector2(halfsize.x, halfsize.y), Vector2(-halfsize.x, halfsize.y) };
+    int localCount = 4;
+    if(polygon){
+        localCount = polygon->count;
+        std::copy(polygon->vertices, polygon->vertices + localCount, localCorners);
+    }
+    struct Corner{
+        int segment, index;
+        float separation;
+        Vector2 position;
+    };
+    Corner corners[PolygonShape::MaxVertices];
+    int cornerCount = 0;
+    for(int k = 0; k < localCount; k++){
+        Vector2 p = body->position + Vector2(localCorners[k].x * cosB - localCorners[k].y * sinB,
+                                             localCorners[k].x * sinB + localCorners[k].y * cosB);
+        float x = (p.x - origin.x) / spacing;
+        if(x < 0.0f || x >= segments) continue;
+        int i = static_cast<int>(x);
+        Vector2 p0 = vertex(i);
+        Vector2 edge = vertex(i + 1) - p0;
+        Vector2 n = Vector2(edge.y, -edge.x).normalize();
+        float separation = (p - p0).dot(n);
+        if(separation > margin) continue;
+        corners[cornerCount++] = {i, k, separation, p};
+    }
+    std::sort(corners, corners + cornerCount, [](const Corner& a, const Corner& b){
+        return a.segment != b.segment ? a.segment < b.segment : a.separation < b.separation;
+    });
+    for(int begin = 0; begin < cornerCount;){
+        int end = begin + 1;
+        while(end < cornerCount && corners[end].segment == corners[begin].segment) end++;
+
+        int i = corners[begin].segment;
+        Vector2 edge = vertex(i + 1) - vertex(i);
+        Contact contact = makeContact(static_cast<uint32_t>(i));
+        CollisionManifold& m = contact.manifold;
+        m.normal = Vector2(edge.y, -edge.x).normalize();
+        for(int k = begin; k < std::min(end, begin + 2); k++)
+            m.AddPoint(corners[k].position, -corners[k].separation, static_cast<uint32_t>(corners[k].index));
+        m.penetration = m.points[0].penetration;
+        contacts.push_back(contact);
+        begin = end;
+    }
+
+    // Peaks (samples above the line between their neighbours) can poke into
+    // the body between its corners: push the body off through its nearest face
+    for(int i = std::max(first, 1); i <= std::min(last + 1, segments - 1); i++){
+        if(2.0f * field.heights[i] >= field.heights[i - 1] + field.heights[i + 1]) continue;
+        Vector2 d = vertex(i) - body->position;
+        Vector2 local(d.x * cosB + d.y * sinB, -d.x * sinB + d.y * cosB);
+
+        // Face normal in body space, then the contact normal (into the body) in world space
+        Vector2 face, point;
+        float depth;
+        if(polygon){
+            if(!Collision::PolygonvsCircleLocal(*polygon, local, 0.0f, margin, face, point, depth)) continue;
+        } else {
+            float depthX = halfsize.x - std::abs(local.x);
+            float depthY = halfsize.y - std::abs(local.y);
+            if(depthX < -margin || depthY < -margin) continue;
+            face = depthX < depthY ? Vector2(local.x < 0.0f ? -1.0f : 1.0f, 0.0f) : Vector2(0.0f, local.y < 0.0f ? -1.0f : 1.0f);
+            depth = std::min(depthX, depthY);
+        }
+        Contact contact = makeContact(0x80000000u | static_cast<uint32_t>(i));
+        CollisionManifold& m = contact.manifold;
+        m.normal = Vector2(-(face.x * cosB - face.y * sinB), -(face.x * sinB + face.y * cosB));
+        m.AddPoint(vertex(i), depth);
+        m.penetration = m.points[0].penetration;
+        contacts.push_back(contact);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include "AABBCollider.h"
+#include "Contact.h"
+#include "TimeOfImpact.h"
+#include "../physics/RigidBody.h"
+#include "../shapes/AABBShape.h"
+#include "Collider.h"
+
+class TileGridShape;
+class HeightfieldShape;
+
+// Contacts between static terrain (TileGridShape, HeightfieldShape) and
+// dynamic circles, boxes and polygons. Terrain stays out of the broadphase;
+// the world hands every dynamic body to Collide, which only looks at the part
+// of the terrain under the body's bounding square. Terrain is body a of each contact,
+// so normals point out of it. Tile edges shared with another solid tile never
+// produce contacts, so bodies slide across the seams between rectangles.
+// A body gets one contact per rectangle or segment it touches, each with its
+// own Contact::part, so the solver can warm start them separately.
+class TerrainCollision{
+    public:
+        TerrainCollision();
+
+        // Appends the contacts of body with terrain. Pairs up to margin
+        // apart collide too, with the gap as negative penetration
+        void Collide(RigidBody* terrain, int terrainIndex, RigidBody* body, int bodyIndex,
+                     float margin, std::vector<Contact>& contacts);
+
+        // First time t at which shape, moving along sweep, comes within target
+        // of the terrain inside bounds, as TimeOfImpact::Compute. Contact
+        // normals point from shape into the terrain
+        bool ComputeTimeOfImpact(RigidBody* terrain, const Shape& shape, const Sweep& sweep, const AABB& bounds,
+                                 float target, float& t, DistanceOutput& contact);
+
+    private:
+        void CollideTileGrid(RigidBody* terrain, int terrainIndex, RigidBody* body, int bodyIndex,
+                             float margin, std::vector<Contact>& contacts);
+        void CollideHeightfield(RigidBody* terrain, int terrainIndex, RigidBody* body, int bodyIndex,
+                                float margin, std::vector<Contact>& contacts);
+
+        std::vector<int> rects;     // Query results
+
+        // Stand-in for one merged rectangle, for the box-box test
+        AABBShape rectShape;
+        Collider rectCollider;
+        RigidBody rectBody;
+};
@@ -0,0 +1,181 @@
+#include "TimeOfImpact.h"
+#include "../shapes/AABBShape.h"
+#include "../shapes/CircleShape.h"
+#include "../shapes/PolygonShape.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static_assert(PolygonShape::MaxVertices <= DistanceProxy::MaxVertices, "a polygon must fit in a proxy");
+
+DistanceProxy DistanceProxy::Make(const Shape& shape, const Vector2& position, float angle){
+    DistanceProxy proxy;
+    if(shape.GetType() == ShapeType::Circle){
+        proxy.vertices[0] = position;
+        proxy.count = 1;
+        proxy.radius = static_cast<const CircleShape&>(shape).radius;
+    } else if(shape.GetType() == ShapeType::Polygon){
+        const PolygonShape& polygon = static_cast<const PolygonShape&>(shape);
+        float c = std::cos(angle);
+        float s = std::sin(angle);
+        for(int i = 0; i < polygon.count; i++){
+            const Vector2& v = polygon.vertices[i];
+            proxy.vertices[i] = position + Vector2(v.x * c - v.y * s, v.x * s + v.y * c);
+        }
+        proxy.count = polygon.count;
+    } else {
+        // Same corner order as Collision::GetOBBCorners
+        Vector2 h = static_cast<const AABBShape&>(shape).halfsize;
+        Vector2 local[4] = { Vector2(-h.x, -h.y), Vector2(h.x, -h.y), Vector2(h.x, h.y), Vector2(-h.x, h.y) };
+        float c = std::cos(angle);
+        float s = std::sin(angle);
+        for(int i = 0; i < 4; i++)
+            proxy.vertices[i] = position + Vector2(local[i].x * c - local[i].y * s, local[i].x * s + local[i].y * c);
+        proxy.count = 4;
+    }
+    return proxy;
+}
+
+namespace {
+
+Vector2 ClosestOnSegment(const Vector2& p, const Vector2& a, const Vector2& b){
+    Vector2 ab = b - a;
+    float lengthSq = ab.dot(ab);
+    float t = lengthSq > 0.0f ? std::clamp((p - a).dot(ab) / lengthSq, 0.0f, 1.0f) : 0.0f;
+    return a + ab * t;
+}
+
+Vector2 EdgeNormal(const Vector2& a, const Vector2& b){
+    Vector2 edge = b - a;
+    return Vector2(edge.y, -edge.x).normalize();
+}
+
+// Largest separation of poly from any edge of face, and that edge's outward
+// normal. Positive means the edge separates the two.
+float MaxSeparation(const DistanceProxy& face, const DistanceProxy& poly, Vector2& normal){
+    float best = -FLT_MAX;
+    for(int i = 0; i < face.count; i++){
+        const Vector2& v = face.vertices[i];
+        Vector2 n = EdgeNormal(v, face.vertices[(i + 1) % face.count]);
+        float nearest = FLT_MAX;
+        for(int j = 0; j < poly.count; j++)
+            nearest = std::min(nearest, n.dot(poly.vertices[j] - v));
+        if(nearest > best){
+            best = nearest;
+            normal = n;
+        }
+    }
+    return best;
+}
+
+// Closest pair between the vertices of a and the edges of b (b's point if it has one)
+void ClosestFeatures(const DistanceProxy& a, const DistanceProxy& b, bool swap,
+                     float& bestSq, Vector2& pointA, Vector2& pointB){
+    for(int i = 0; i < a.count; i++){
+        const Vector2& p = a.vertices[i];
+        for(int j = 0; j < b.count; j++){
+            Vector2 q = b.count > 1 ? ClosestOnSegment(p, b.vertices[j], b.vertices[(j + 1) % b.count]) : b.vertices[j];
+            float distanceSq = (q - p).lengthSquared();
+            if(distanceSq < bestSq){
+                bestSq = distanceSq;
+                pointA = swap ? q : p;
+                pointB = swap ? p : q;
+            }
+        }
+    }
+}
+
+}
+
+DistanceOutput TimeOfImpact::Distance(const DistanceProxy& a, const DistanceProxy& b){
+    DistanceOutput out;
+
+    // Separating edge of either polygon, if any
+    Vector2 normalA, normalB;
+    float separationA = a.count > 1 ? MaxSeparation(a, b, normalA) : -FLT_MAX;
+    float separationB = b.count > 1 ? MaxSeparation(b, a, normalB) : -FLT_MAX;
+    bool pointsOnly = a.count == 1 && b.count == 1;
+
+    float core = 0.0f;
+    bool found = false;
+    if(pointsOnly || separationA > 0.0f || separationB > 0.0f){
+        // Disjoint convex cores: the closest pair is a vertex of one against an edge of the other
+        float bestSq = FLT_MAX;
+        ClosestFeatures(a, b, false, bestSq, out.pointA, out.pointB);
+        ClosestFeatures(b, a, true, bestSq, out.pointA, out.pointB);
+        core = std::sqrt(bestSq);
+        if(core > 1e-6f){
+            out.normal = (out.pointB - out.pointA) / core;
+            found = true;
+        }
+    }
+
+    if(!found){
+        // Overlapping (or exactly touching) cores: use the shallowest edge separation,
+        // with the deepest vertex of the other shape as the contact point
+        const DistanceProxy& incident = separationA >= separationB ? b : a;
+        if(separationA >= separationB){
+            core = std::min(separationA, 0.0f);
+            out.normal = normalA;
+        } else {
+            core = std::min(separationB, 0.0f);
+            out.normal = normalB * -1.0f;
+        }
+        if(pointsOnly){
+            core = 0.0f;
+            out.normal = Vector2(0.0f, 1.0f);
+        }
+
+        float direction = &incident == &b ? -1.0f : 1.0f;
+        int deepest = 0;
+        for(int i = 1; i < incident.count; i++){
+            if(direction * out.normal.dot(incident.vertices[i]) > direction * out.normal.dot(incident.vertices[deepest]))
+                deepest = i;
+        }
+        out.pointA = out.pointB = incident.vertices[deepest];
+    }
+
+    out.distance = core - a.radius - b.radius;
+    out.pointA += out.normal * a.radius;
+    out.pointB -= out.normal * b.radius;
+    return out;
+}
+
+bool TimeOfImpact::Compute(const Shape& shape, const Sweep& sweep,
+                           const Shape& other, const Vector2& otherPosition, float otherAngle,
+                           float target, float& t, DistanceOutput& contact)
+{
+    const int MaxIterations = 20;
+    const float tolerance = 0.25f * target;
+
+    DistanceProxy still = DistanceProxy::Make(other, otherPosition, otherAngle);
+
+    // Fastest any point of the shape can move relative to its centre, per unit of t
+    DistanceProxy start = DistanceProxy::Make(shape, sweep.position0, sweep.angle0);
+    float extent = 0.0f;
+    for(int i = 0; i < start.count; i++)
+        extent = std::max(extent, (start.vertices[i] - sweep.position0).length());
+    float angularBound = std::abs(sweep.angle1 - sweep.angle0) * (extent + start.radius);
+    Vector2 translation = sweep.position1 - sweep.position0;
+
+    t = 0.0f;
+    for(int iteration = 0; iteration < MaxIterations; iteration++){
+        DistanceProxy moving = DistanceProxy::Make(shape, sweep.Position(t), sweep.Angle(t));
+        contact = Distance(moving, still);
+
+        if(contact.distance <= target + tolerance)
+            return t > 0.0f;
+
+        // Upper bound on how fast the gap can close along the current normal
+        float approach = translation.dot(contact.normal) + angularBound;
+        if(approach <= 0.0f)
+            return false;
+
+        t += (contact.distance - target) / approach;
+        if(t >= 1.0f)
+            return false;
+    }
+
+    // Out of iterations: t is still a safe time to stop at
+    return t > 0.0f;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "../math/Vector2.h"
+#include "../shapes/Shape.h"
+
+// A shape placed in the world as a convex polygon (a point for circles)
+// inflated by a radius, which is all the distance query needs
+struct DistanceProxy{
+    static constexpr int MaxVertices = 8;
+
+    Vector2 vertices[MaxVertices];  // Counter-clockwise
+    int count = 0;
+    float radius = 0.0f;
+
+    static DistanceProxy Make(const Shape& shape, const Vector2& position, float angle);
+};
+
+struct DistanceOutput{
+    float distance;     // Negative when the shapes overlap
+    Vector2 normal;     // From A towards B
+    Vector2 pointA;     // Closest point on A's surface
+    Vector2 pointB;     // Closest point on B's surface
+};
+
+// Motion of a body over one step, linear in position and angle
+struct Sweep{
+    Vector2 position0, position1;
+    float angle0, angle1;
+
+    Vector2 Position(float t) const { return position0 + (position1 - position0) * t; }
+    float Angle(float t) const { return angle0 + (angle1 - angle0) * t; }
+};
+
+// Continuous collision for fast (bullet) bodies. Conservative advancement
+// moves the shape along its sweep by the largest fraction that can't close
+// the gap to the other shape, until the two are within target of touching.
+class TimeOfImpact{
+    public:
+        static DistanceOutput Distance(const DistanceProxy& a, const DistanceProxy& b);
+
+        // First time t in (0, 1] at which shape, moving along sweep, comes within target
+        // of the other shape held still. False if it doesn't, or if the two already
+        // start that close (the discrete contacts handle those).
+        static bool Compute(const Shape& shape, const Sweep& sweep,
+                            const Shape& other, const Vector2& otherPosition, float otherAngle,
+                            float target, float& t, DistanceOutput& contact);
+};
@@ -9,4 +9,26 @@ namespace Config {
 
     constexpr float SleepVelocityThreshold = 0.1f;
     constexpr float SleepTimeThreshold = 0.5f; // in seconds
+
+    // Contacts closing slower than this (pixels/s) are solved without restitution
+    constexpr float RestitutionVelocityThreshold = 40.0f;
+
+    // Solver passes stop once no contact changed velocity by more than this (pixels/s)
+    constexpr float SolverResidualTolerance = 1.0f;
+
+    // Every this many steps the world checks how well the body list follows the
+    // scene's layout, and re-sorts it once this fraction of neighbours in the
+    // list are out of Morton order
+    constexpr int BodyReorderInterval = 64;
+    constexpr float BodyReorderThreshold = 0.25f;
+
+    // Level of detail: distance from the nearest focus point (pixels) beyond
+    // which bodies are stepped at half and quarter rate
+    constexpr float LodHalfRateDistance = 1500.0f;
+    constexpr float LodQuarterRateDistance = 3000.0f;
+    constexpr int LodMaxRate = 4;
+
+    // Band on each side of a partition boundary (pixels) whose bodies are
+    // mirrored to the neighbouring partition as ghosts
+    constexpr float PartitionGhostWidth = 100.0f;
 }
\ No newline at end of file
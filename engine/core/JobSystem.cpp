@@ -0,0 +1,202 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+// Which system and queue the current thread works for, so jobs submitted from
+// inside a job go to that worker's own deque
+static thread_local const JobSystem* currentSystem = nullptr;
+static thread_local int currentWorker = -1;
+
+JobSystem::JobSystem(int workerCount){
+    workerCount = std::max(workerCount, 0);
+    for(int i = 0; i <= workerCount; i++)
+        queues.emplace_back(new Queue());
+    for(int i = 0; i < workerCount; i++)
+        workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem(){
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(std::thread& worker : workers)
+        worker.join();
+}
+
+int JobSystem::CurrentQueue() const {
+    return currentSystem == this ? currentWorker : static_cast<int>(workers.size());
+}
+
+void JobSystem::Push(Job job){
+    Queue& queue = *queues[CurrentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    queued.fetch_add(1);
+
+    // A worker going to sleep registers before it checks queued, so one of
+    // the two always sees the other
+    if(sleeping.load() > 0){
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_one();
+    }
+}
+
+// Own deque newest first, then the shared queue, then steal the oldest job of another worker
+bool JobSystem::Pop(int index, Job& job){
+    if(queued.load(std::memory_order_relaxed) == 0) return false;
+
+    int queueCount = static_cast<int>(queues.size());
+    int shared = queueCount - 1;
+    for(int n = 0; n < queueCount; n++){
+        int q;
+        if(n == 0) q = index;
+        else if(index == shared) q = n - 1;
+        else q = n == 1 ? shared : (index + n - 1) % shared;
+
+        Queue& queue = *queues[q];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.jobs.empty()) continue;
+        if(q == index && q != shared){
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        } else {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::Run(Job& job){
+    job.run();
+    Finish(job.fence);
+}
+
+// Count a job off its fence; the last one releases the jobs waiting on the fence.
+// The fence mutex stays held until then, so Wait can't return (and the fence
+// be destroyed) while it's still in use here
+void JobSystem::Finish(JobFence* fence){
+    if(!fence) return;
+
+    std::vector<JobFence::Deferred> ready;
+    {
+        std::lock_guard<std::mutex> lock(fence->mutex);
+        if(fence->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            ready.swap(fence->continuations);
+    }
+
+    for(JobFence::Deferred& deferred : ready){
+        Job job{std::move(deferred.run), deferred.fence};
+        if(workers.empty())
+            Run(job);
+        else
+            Push(std::move(job));
+    }
+}
+
+void JobSystem::Submit(std::function<void()> job, JobFence* fence, JobFence* after){
+    if(fence)
+        fence->pending.fetch_add(1, std::memory_order_relaxed);
+
+    if(after){
+        std::lock_guard<std::mutex> lock(after->mutex);
+        if(after->pending.load(std::memory_order_acquire) > 0){
+            after->continuations.push_back({std::move(job), fence});
+            return;
+        }
+    }
+
+    Job ready{std::move(job), fence};
+    if(workers.empty())
+        Run(ready);
+    else
+        Push(std::move(ready));
+}
+
+void JobSystem::Wait(JobFence& fence){
+    while(!fence.IsDone()){
+        if(!RunOne())
+            std::this_thread::yield();
+    }
+    // Let the thread that finished the fence let go of it
+    std::lock_guard<std::mutex> lock(fence.mutex);
+}
+
+bool JobSystem::RunOne(){
+    Job job;
+    if(!Pop(CurrentQueue(), job)) return false;
+    Run(job);
+    return true;
+}
+
+void JobSystem::ParallelFor(int count, int grainSize, const std::function<void(int, int)>& body){
+    if(count <= 0) return;
+    if(grainSize < 1) grainSize = 1;
+
+    int chunks = (count - 1) / grainSize + 1;
+    if(workers.empty() || chunks == 1){
+        body(0, count);
+        return;
+    }
+
+    // Chunks are handed out from one counter, so the helpers balance the load
+    // between them however fast each one runs
+    struct Loop{
+        const std::function<void(int, int)>* body;
+        int count;
+        int grainSize;
+        std::atomic<int> next{0};
+
+        void Run(){
+            for(;;){
+                int begin = next.fetch_add(grainSize, std::memory_order_relaxed);
+                if(begin >= count) return;
+                (*body)(begin, std::min(begin + grainSize, count));
+            }
+        }
+    };
+    Loop loop;
+    loop.body = &body;
+    loop.count = count;
+    loop.grainSize = grainSize;
+
+    JobFence fence;
+    int helpers = std::min(static_cast<int>(workers.size()), chunks - 1);
+    for(int i = 0; i < helpers; i++)
+        Submit([&loop]{ loop.Run(); }, &fence);
+
+    loop.Run();
+    Wait(fence);
+}
+
+void JobSystem::WorkerLoop(int index){
+    currentSystem = this;
+    currentWorker = index;
+
+    for(;;){
+        Job job;
+        if(Pop(index, job)){
+            Run(job);
+            continue;
+        }
+
+        // Jobs often come in bursts; look again briefly before sleeping
+        bool found = false;
+        for(int spin = 0; spin < 64 && !found; spin++){
+            std::this_thread::yield();
+            found = queued.load(std::memory_order_relaxed) > 0;
+        }
+        if(found) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleeping.fetch_add(1);
+        wake.wait(lock, [this]{ return stopping || queued.load() > 0; });
+        sleeping.fetch_sub(1);
+        if(stopping && queued.load() == 0) return;
+    }
+}
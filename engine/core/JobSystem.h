@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Counts unfinished jobs. Pass it to JobSystem::Submit to track a job and to
+// JobSystem::Wait to join them; passed as "after", it holds other jobs back
+// until it completes. Must outlive the jobs that reference it.
+class JobFence{
+    public:
+        JobFence() = default;
+        JobFence(const JobFence&) = delete;
+        JobFence& operator=(const JobFence&) = delete;
+
+        bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+        struct Deferred{
+            std::function<void()> run;
+            JobFence* fence;
+        };
+
+        std::atomic<int> pending{0};
+        std::mutex mutex;
+        std::vector<Deferred> continuations;
+};
+
+// Work-stealing scheduler. Every worker owns a deque: it pops its own jobs
+// newest first and, when empty, steals the oldest job from the other deques.
+// Jobs submitted by threads that aren't workers go into a shared queue.
+// Threads that wait (Wait, ParallelFor) run queued jobs instead of blocking,
+// and idle workers sleep rather than spin.
+//
+// With zero workers every job runs inline on the submitting thread. To share
+// cores with a host's own thread pool, either hand one JobSystem to both
+// (PhysicsWorld::SetJobSystem) or have the host's threads call RunOne.
+class JobSystem{
+    public:
+        explicit JobSystem(int workerCount);
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+        ~JobSystem();
+
+        int GetWorkerCount() const { return static_cast<int>(workers.size()); }
+
+        // Queue job. fence (optional) counts it until it has run; after
+        // (optional) holds it back until that fence completes.
+        void Submit(std::function<void()> job, JobFence* fence = nullptr, JobFence* after = nullptr);
+
+        // Run queued jobs on the calling thread until fence completes
+        void Wait(JobFence& fence);
+
+        // Run one queued job on the calling thread; false if there was none
+        bool RunOne();
+
+        // Calls body(begin, end) over [0, count) in chunks of at most grainSize
+        // and returns once every chunk has run. Chunks are claimed in order by
+        // the caller and up to one helper job per worker. Safe to nest.
+        void ParallelFor(int count, int grainSize, const std::function<void(int, int)>& body);
+
+    private:
+        struct Job{
+            std::function<void()> run;
+            JobFence* fence = nullptr;
+        };
+        struct Queue{
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        void Push(Job job);
+        bool Pop(int queue, Job& job);
+        void Run(Job& job);
+        void Finish(JobFence* fence);
+        void WorkerLoop(int index);
+        int CurrentQueue() const;
+
+        // queues[i] belongs to worker i; the last one is shared by outside threads
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<int> queued{0};
+
+        std::mutex sleepMutex;
+        std::atomic<int> sleeping{0};
+        std::condition_variable wake;
+        bool stopping = false;
+};
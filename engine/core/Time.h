@@ -2,4 +2,5 @@
 
 namespace Time{
     constexpr float FixedDeltaTime = 1.0f / 60.0f; // 60 FPS
+    constexpr float MaxFrameTime = 0.25f; // Longer frames are clamped, slowing the simulation down
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+// Apply may be called for different bodies at the same time when the world
+// has worker threads (PhysicsWorld::SetWorkerThreads)
 class ForceGenerator{
     public:
     virtual ~ForceGenerator() = default;
@@ -9,6 +9,8 @@ class GravityForce: public ForceGenerator{
     explicit GravityForce(const Vector2& g) : gravity(g) {}
 
     void Apply(RigidBody& body) override {
-        body.ApplyForce(gravity * body.mass);
+        // Accumulate directly: ApplyForce would reset the sleep timer, and a
+        // constant field shouldn't keep resting bodies awake
+        body.force += gravity * body.mass;
     }
 };
\ No newline at end of file
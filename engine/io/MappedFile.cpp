@@ -0,0 +1,59 @@
+#include "MappedFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NGEN2D_HAS_MMAP 1
+#else
+#include <fstream>
+#endif
+
+bool MappedFile::Open(const char* path){
+    Close();
+
+#ifdef NGEN2D_HAS_MMAP
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size <= 0){
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(view == MAP_FAILED) return false;
+
+    data = static_cast<const unsigned char*>(view);
+    size = static_cast<size_t>(info.st_size);
+    mapped = true;
+    return true;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file) return false;
+
+    std::streamsize length = file.tellg();
+    if(length <= 0) return false;
+    fallback.resize(static_cast<size_t>(length));
+    file.seekg(0);
+    if(!file.read(reinterpret_cast<char*>(fallback.data()), length)) return false;
+
+    data = fallback.data();
+    size = fallback.size();
+    return true;
+#endif
+}
+
+void MappedFile::Close(){
+#ifdef NGEN2D_HAS_MMAP
+    if(mapped)
+        munmap(const_cast<unsigned char*>(data), size);
+#endif
+    fallback.clear();
+    data = nullptr;
+    size = 0;
+    mapped = false;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Read-only view of a whole file. Uses mmap where available and falls back
+// to reading the file into memory elsewhere.
+class MappedFile{
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile() { Close(); }
+
+        bool Open(const char* path);
+        void Close();
+
+        const unsigned char* GetData() const { return data; }
+        size_t GetSize() const { return size; }
+
+    private:
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+        bool mapped = false;
+        std::vector<unsigned char> fallback;
+};
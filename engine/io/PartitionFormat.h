@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+
+// Layout of the messages PartitionedWorld partitions exchange every step: a
+// header, then the bodies migrating to the receiver, then the ghosts (bodies
+// the sender owns near the shared boundary), then one PolygonRecord for each
+// polygon body in the same order. Every field is a 32-bit word and floats are
+// copied bit for bit, so a body continues exactly where it left off.
+namespace PartitionFormat {
+    constexpr uint32_t Magic = 0x5452474E; // "NGRT"
+    constexpr uint32_t Version = 2;
+    constexpr uint32_t MaxPolygonVertices = 8;
+
+    enum ShapeKind : uint32_t {
+        ShapeNone = 0,
+        ShapeCircle = 1,
+        ShapeAABB = 2,
+        ShapePolygon = 3    // Vertices in the body's PolygonRecord
+    };
+
+    enum BodyFlags : uint32_t {
+        BodySleeping = 1u << 0,
+        BodyBullet = 1u << 1,
+        BodySensor = 1u << 2    // The collider is a sensor
+    };
+
+    struct Header{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t step;
+        uint32_t migrationCount;
+        uint32_t ghostCount;
+        uint32_t polygonCount;
+    };
+
+    struct BodyRecord{
+        uint32_t id;
+        uint32_t flags;
+        float mass;
+        float inverseInertia;
+        float sizeX, sizeY;
+        float positionX, positionY;
+        float velocityX, velocityY;
+        float forceX, forceY;
+        float orientation;
+        float angularVelocity;
+        float torque;
+        float sleepTime;
+        float linearDamping;
+        float angularDamping;
+        uint32_t shapeKind;
+        float shapeX;   // Radius for circles, half width for boxes
+        float shapeY;   // Half height for boxes
+        float restitution;
+        float staticFriction;
+        float dynamicFriction;
+    };
+
+    struct PolygonRecord{
+        uint32_t count;
+        float x[MaxPolygonVertices];    // Local space, centroid at the origin
+        float y[MaxPolygonVertices];
+    };
+
+    static_assert(sizeof(Header) == 24, "partition header layout changed");
+    static_assert(sizeof(BodyRecord) == 96, "partition body record layout changed");
+    static_assert(sizeof(PolygonRecord) == 68, "partition polygon record layout changed");
+}
@@ -0,0 +1,160 @@
+#include "PartitionTransport.h"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define NGEN2D_HAS_UNIX_SOCKETS 1
+#endif
+
+#ifdef NGEN2D_HAS_UNIX_SOCKETS
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static bool MakeAddress(const std::string& path, sockaddr_un& address){
+    if(path.size() >= sizeof(address.sun_path)) return false;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static bool WriteAll(int socket, const void* data, size_t size){
+    const char* bytes = static_cast<const char*>(data);
+    while(size > 0){
+        ssize_t written = send(socket, bytes, size, MSG_NOSIGNAL);
+        if(written <= 0) return false;
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+static bool ReadAll(int socket, void* data, size_t size){
+    char* bytes = static_cast<char*>(data);
+    while(size > 0){
+        ssize_t got = recv(socket, bytes, size, 0);
+        if(got <= 0) return false;
+        bytes += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+bool UnixSocketTransport::Open(const char* prefix, int self, const std::vector<int>& peers, float timeoutSeconds){
+    Close();
+
+    int lowerPeers = 0;
+    for(int peer : peers)
+        if(peer > self) lowerPeers++;
+
+    // Listen first, so peers that connect to us find the socket as early as possible
+    if(lowerPeers > 0){
+        sockaddr_un address;
+        listenPath = std::string(prefix) + std::to_string(self);
+        if(!MakeAddress(listenPath, address)) return false;
+        unlink(listenPath.c_str());
+
+        listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(listenSocket < 0 ||
+           bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+           listen(listenSocket, lowerPeers) != 0){
+            Close();
+            return false;
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<float>(timeoutSeconds);
+    for(int peer : peers){
+        if(peer > self) continue;
+
+        sockaddr_un address;
+        if(!MakeAddress(std::string(prefix) + std::to_string(peer), address)){
+            Close();
+            return false;
+        }
+        int s = -1;
+        for(;;){
+            s = socket(AF_UNIX, SOCK_STREAM, 0);
+            if(s >= 0 && connect(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) break;
+            if(s >= 0) close(s);
+            s = -1;
+            if(std::chrono::steady_clock::now() > deadline) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        uint32_t id = static_cast<uint32_t>(self);
+        if(s < 0 || !WriteAll(s, &id, sizeof(id))){
+            if(s >= 0) close(s);
+            Close();
+            return false;
+        }
+        connections.emplace_back(peer, s);
+    }
+
+    // The connecting side introduces itself with its partition number
+    for(int i = 0; i < lowerPeers; i++){
+        int s = accept(listenSocket, nullptr, nullptr);
+        uint32_t id = 0;
+        if(s < 0 || !ReadAll(s, &id, sizeof(id))){
+            if(s >= 0) close(s);
+            Close();
+            return false;
+        }
+        connections.emplace_back(static_cast<int>(id), s);
+    }
+
+    close(listenSocket);
+    listenSocket = -1;
+    unlink(listenPath.c_str());
+    listenPath.clear();
+    return true;
+}
+
+void UnixSocketTransport::Close(){
+    for(auto& connection : connections)
+        close(connection.second);
+    connections.clear();
+    if(listenSocket >= 0){
+        close(listenSocket);
+        listenSocket = -1;
+    }
+    if(!listenPath.empty()){
+        unlink(listenPath.c_str());
+        listenPath.clear();
+    }
+}
+
+bool UnixSocketTransport::Send(int partition, const std::vector<unsigned char>& message){
+    int s = FindSocket(partition);
+    uint32_t size = static_cast<uint32_t>(message.size());
+    return s >= 0 && WriteAll(s, &size, sizeof(size)) && WriteAll(s, message.data(), message.size());
+}
+
+bool UnixSocketTransport::Receive(int partition, std::vector<unsigned char>& message){
+    int s = FindSocket(partition);
+    uint32_t size = 0;
+    if(s < 0 || !ReadAll(s, &size, sizeof(size))) return false;
+    message.resize(size);
+    return ReadAll(s, message.data(), size);
+}
+
+#else
+
+bool UnixSocketTransport::Open(const char*, int, const std::vector<int>&, float){ return false; }
+void UnixSocketTransport::Close(){}
+bool UnixSocketTransport::Send(int, const std::vector<unsigned char>&){ return false; }
+bool UnixSocketTransport::Receive(int, std::vector<unsigned char>&){ return false; }
+
+#endif
+
+int UnixSocketTransport::FindSocket(int partition) const {
+    for(const auto& connection : connections)
+        if(connection.first == partition) return connection.second;
+    return -1;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+// Carries messages between the partitions of a PartitionedWorld. Messages
+// between two partitions arrive whole and in the order they were sent.
+class PartitionTransport{
+    public:
+        virtual ~PartitionTransport() = default;
+
+        virtual bool Send(int partition, const std::vector<unsigned char>& message) = 0;
+        // Blocks until the next message from partition has arrived
+        virtual bool Receive(int partition, std::vector<unsigned char>& message) = 0;
+};
+
+// Unix domain stream sockets, for running partitions as processes on one
+// machine. Partition i listens on "<prefix><i>"; of each pair of peers the
+// higher-numbered one connects to the lower one, retrying until it is up or
+// the timeout runs out. Messages are framed with a 32-bit length.
+class UnixSocketTransport : public PartitionTransport{
+    public:
+        UnixSocketTransport() = default;
+        UnixSocketTransport(const UnixSocketTransport&) = delete;
+        UnixSocketTransport& operator=(const UnixSocketTransport&) = delete;
+        ~UnixSocketTransport() override { Close(); }
+
+        // Connect this partition to every partition in peers
+        bool Open(const char* prefix, int self, const std::vector<int>& peers, float timeoutSeconds = 10.0f);
+        void Close();
+
+        bool Send(int partition, const std::vector<unsigned char>& message) override;
+        bool Receive(int partition, std::vector<unsigned char>& message) override;
+
+    private:
+        int FindSocket(int partition) const;
+
+        std::vector<std::pair<int, int>> connections; // (partition, socket)
+        int listenSocket = -1;
+        std::string listenPath;
+};
@@ -0,0 +1,380 @@
+#include "Scene.h"
+#include "SceneFormat.h"
+#include "MappedFile.h"
+#include "../physics/PhysicsWorld.h"
+#include "../forces/GravityForce.h"
+
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+using namespace SceneFormat;
+
+namespace {
+    bool IsLittleEndian(){
+        const uint32_t probe = 1;
+        unsigned char first;
+        std::memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+
+    // All scene fields are 32-bit words, so converting a table is a word-wise swap
+    void SwapWords(void* data, size_t bytes){
+        unsigned char* p = static_cast<unsigned char*>(data);
+        for(size_t i = 0; i + 4 <= bytes; i += 4){
+            std::swap(p[i], p[i + 3]);
+            std::swap(p[i + 1], p[i + 2]);
+        }
+    }
+
+    // Copy a table out of the mapped file in one block, fixing byte order if needed
+    template<typename T>
+    bool ReadTable(const unsigned char* data, size_t size, uint32_t offset, uint32_t count, std::vector<T>& out){
+        size_t bytes = static_cast<size_t>(count) * sizeof(T);
+        if(offset % 4 != 0 || offset > size || bytes > size - offset)
+            return false;
+
+        out.resize(count);
+        if(bytes > 0)
+            std::memcpy(out.data(), data + offset, bytes);
+        if(!IsLittleEndian())
+            SwapWords(out.data(), bytes);
+        return true;
+    }
+
+    float WordToFloat(uint32_t word){
+        float value;
+        std::memcpy(&value, &word, sizeof(float));
+        return value;
+    }
+
+    uint32_t FloatToWord(float value){
+        uint32_t word;
+        std::memcpy(&word, &value, sizeof(float));
+        return word;
+    }
+
+    // Largest tile grid side: tile coordinates stay exact as floats
+    constexpr uint32_t MaxGridSide = 1u << 24;
+
+    // Polygon from a shape record's data slice of x, y word pairs
+    PolygonShape ReadPolygon(const uint32_t* words, uint32_t wordCount){
+        Vector2 points[PolygonShape::MaxVertices];
+        int count = static_cast<int>(wordCount / 2);
+        for(int k = 0; k < count; k++)
+            points[k] = Vector2(WordToFloat(words[2 * k]), WordToFloat(words[2 * k + 1]));
+        return PolygonShape(points, count);
+    }
+
+    // Words of tile bits after the grid's columns and rows
+    size_t TileBitWords(uint32_t columns, uint32_t rows){
+        return (static_cast<size_t>(columns) * rows + 31) / 32;
+    }
+
+    // Whether a shape record's data slice is in range and the size its kind needs
+    bool ValidShapeData(const ShapeRecord& shape, const std::vector<uint32_t>& data){
+        if(static_cast<size_t>(shape.dataIndex) + shape.dataCount > data.size())
+            return false;
+        switch(shape.kind){
+            case ShapeCircle:
+            case ShapeAABB:
+                return true;
+            case ShapePolygon:
+                return shape.dataCount % 2 == 0 && shape.dataCount >= 6 &&
+                       shape.dataCount <= 2 * PolygonShape::MaxVertices &&
+                       !ReadPolygon(&data[shape.dataIndex], shape.dataCount).IsDegenerate();
+            case ShapeTileGrid: {
+                if(shape.dataCount < 2) return false;
+                uint32_t columns = data[shape.dataIndex], rows = data[shape.dataIndex + 1];
+                return columns > 0 && rows > 0 && columns <= MaxGridSide && rows <= MaxGridSide &&
+                       shape.dataCount - 2 == TileBitWords(columns, rows);
+            }
+            case ShapeHeightfield:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    template<typename T>
+    void WriteTable(std::ofstream& file, std::vector<T>& table){
+        if(table.empty()) return;
+        if(!IsLittleEndian())
+            SwapWords(table.data(), table.size() * sizeof(T));
+        file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(T));
+    }
+}
+
+void Scene::Clear(){
+    bodies.clear();
+    colliders.clear();
+    circles.clear();
+    boxes.clear();
+    polygons.clear();
+    tileGrids.clear();
+    heightfields.clear();
+    forceGenerators.clear();
+}
+
+bool Scene::LoadFromFile(const char* path){
+    MappedFile file;
+    if(!file.Open(path))
+        return false;
+    return LoadFromMemory(file.GetData(), file.GetSize());
+}
+
+bool Scene::LoadFromMemory(const unsigned char* data, size_t size){
+    Clear();
+
+    if(size < sizeof(Header))
+        return false;
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if(!IsLittleEndian())
+        SwapWords(&header, sizeof(Header));
+
+    if(header.magic != Magic || header.version != Version)
+        return false;
+
+    std::vector<BodyRecord> bodyTable;
+    std::vector<ShapeRecord> shapeTable;
+    std::vector<MaterialRecord> materialTable;
+    std::vector<ForceRecord> forceTable;
+    std::vector<uint32_t> dataTable;
+
+    if(!ReadTable(data, size, header.bodyOffset, header.bodyCount, bodyTable) ||
+       !ReadTable(data, size, header.shapeOffset, header.shapeCount, shapeTable) ||
+       !ReadTable(data, size, header.materialOffset, header.materialCount, materialTable) ||
+       !ReadTable(data, size, header.forceOffset, header.forceCount, forceTable) ||
+       !ReadTable(data, size, header.dataOffset, header.dataCount, dataTable))
+        return false;
+
+    // Shapes are stored by kind in contiguous arrays. Reserve exactly so the
+    // pointers handed to colliders stay valid.
+    size_t kindCounts[5] = {};
+    for(const ShapeRecord& shape : shapeTable){
+        if(!ValidShapeData(shape, dataTable)) return false;
+        kindCounts[shape.kind]++;
+    }
+    circles.reserve(kindCounts[ShapeCircle]);
+    boxes.reserve(kindCounts[ShapeAABB]);
+    polygons.reserve(kindCounts[ShapePolygon]);
+    tileGrids.reserve(kindCounts[ShapeTileGrid]);
+    heightfields.reserve(kindCounts[ShapeHeightfield]);
+
+    std::vector<Shape*> shapes(shapeTable.size());
+    for(size_t i = 0; i < shapeTable.size(); i++){
+        const ShapeRecord& record = shapeTable[i];
+        const uint32_t* words = dataTable.data() + record.dataIndex;
+        if(record.kind == ShapeCircle){
+            circles.emplace_back(record.x);
+            shapes[i] = &circles.back();
+        } else if(record.kind == ShapeAABB){
+            boxes.emplace_back(Vector2(record.x, record.y));
+            shapes[i] = &boxes.back();
+        } else if(record.kind == ShapePolygon){
+            polygons.push_back(ReadPolygon(words, record.dataCount));
+            shapes[i] = &polygons.back();
+        } else if(record.kind == ShapeTileGrid){
+            tileGrids.emplace_back(static_cast<int>(words[0]), static_cast<int>(words[1]), record.x);
+            tileGrids.back().SetTiles(words + 2);
+            shapes[i] = &tileGrids.back();
+        } else {
+            std::vector<float> heights(record.dataCount);
+            for(size_t k = 0; k < heights.size(); k++)
+                heights[k] = WordToFloat(words[k]);
+            heightfields.emplace_back(std::move(heights), record.x);
+            shapes[i] = &heightfields.back();
+        }
+    }
+
+    size_t colliderCount = 0;
+    for(const BodyRecord& record : bodyTable){
+        if(record.shapeIndex == NoIndex) continue;
+        if(record.shapeIndex >= shapeTable.size() || record.materialIndex >= materialTable.size())
+            return false;
+        colliderCount++;
+    }
+    colliders.reserve(colliderCount);
+
+    bodies.resize(bodyTable.size());
+    for(size_t i = 0; i < bodyTable.size(); i++){
+        const BodyRecord& record = bodyTable[i];
+        RigidBody& body = bodies[i];
+
+        body.mass = record.mass;
+        body.inverseMass = record.mass > 0.0f ? 1.0f / record.mass : 0.0f;
+        body.inverseInertia = record.inverseInertia;
+        body.size = Vector2(record.sizeX, record.sizeY);
+        body.position = Vector2(record.positionX, record.positionY);
+        body.velocity = Vector2(record.velocityX, record.velocityY);
+        body.orientation = record.orientation;
+        body.angularVelocity = record.angularVelocity;
+        body.linearDamping = record.linearDamping;
+        body.angularDamping = record.angularDamping;
+        body.sleepTime = record.sleepTime;
+        body.isSleeping = (record.flags & BodySleeping) != 0;
+        body.isBullet = (record.flags & BodyBullet) != 0;
+
+        if(record.shapeIndex != NoIndex){
+            const MaterialRecord& material = materialTable[record.materialIndex];
+            colliders.emplace_back(shapes[record.shapeIndex]);
+            Collider& collider = colliders.back();
+            collider.restitution = material.restitution;
+            collider.staticFriction = material.staticFriction;
+            collider.dynamicFriction = material.dynamicFriction;
+            collider.isSensor = (record.flags & BodySensor) != 0;
+            body.collider = &collider;
+        }
+    }
+
+    for(const ForceRecord& record : forceTable){
+        if(record.kind == ForceGravity)
+            forceGenerators.emplace_back(new GravityForce(Vector2(record.x, record.y)));
+    }
+
+    return true;
+}
+
+void Scene::AddToWorld(PhysicsWorld& world){
+    std::vector<RigidBody*> pointers(bodies.size());
+    for(size_t i = 0; i < bodies.size(); i++)
+        pointers[i] = &bodies[i];
+    world.AddBodies(pointers.data(), static_cast<int>(pointers.size()));
+
+    for(auto& fg : forceGenerators)
+        world.AddForceGenerator(fg.get());
+}
+
+bool Scene::SaveWorld(const PhysicsWorld& world, const char* path){
+    std::vector<BodyRecord> bodyTable;
+    std::vector<ShapeRecord> shapeTable;
+    std::vector<MaterialRecord> materialTable;
+    std::vector<ForceRecord> forceTable;
+    std::vector<uint32_t> dataTable;
+
+    bodyTable.reserve(world.GetBodyCount());
+    for(int i = 0; i < world.GetBodyCount(); i++){
+        const RigidBody* body = world.GetBody(i);
+
+        BodyRecord record;
+        record.mass = body->mass;
+        record.inverseInertia = body->inverseInertia;
+        record.sizeX = body->size.x;
+        record.sizeY = body->size.y;
+        record.positionX = body->position.x;
+        record.positionY = body->position.y;
+        record.velocityX = body->velocity.x;
+        record.velocityY = body->velocity.y;
+        record.orientation = body->orientation;
+        record.angularVelocity = body->angularVelocity;
+        record.linearDamping = body->linearDamping;
+        record.angularDamping = body->angularDamping;
+        record.sleepTime = body->sleepTime;
+        record.flags = (body->isSleeping ? BodySleeping : 0u) | (body->isBullet ? BodyBullet : 0u) |
+                       (body->collider && body->collider->isSensor ? BodySensor : 0u);
+        record.shapeIndex = NoIndex;
+        record.materialIndex = NoIndex;
+
+        if(body->collider && body->collider->shape){
+            const Collider* collider = body->collider;
+
+            ShapeRecord shape = {};
+            shape.dataIndex = static_cast<uint32_t>(dataTable.size());
+            switch(collider->shape->GetType()){
+                case ShapeType::Circle:
+                    shape.kind = ShapeCircle;
+                    shape.x = static_cast<const CircleShape*>(collider->shape)->radius;
+                    break;
+                case ShapeType::AABB: {
+                    const AABBShape* box = static_cast<const AABBShape*>(collider->shape);
+                    shape.kind = ShapeAABB;
+                    shape.x = box->halfsize.x;
+                    shape.y = box->halfsize.y;
+                    break;
+                }
+                case ShapeType::Polygon: {
+                    const PolygonShape* polygon = static_cast<const PolygonShape*>(collider->shape);
+                    shape.kind = ShapePolygon;
+                    for(int k = 0; k < polygon->count; k++){
+                        dataTable.push_back(FloatToWord(polygon->vertices[k].x));
+                        dataTable.push_back(FloatToWord(polygon->vertices[k].y));
+                    }
+                    break;
+                }
+                case ShapeType::TileGrid: {
+                    const TileGridShape* grid = static_cast<const TileGridShape*>(collider->shape);
+                    uint32_t columns = static_cast<uint32_t>(grid->GetColumns());
+                    uint32_t rows = static_cast<uint32_t>(grid->GetRows());
+                    shape.kind = ShapeTileGrid;
+                    shape.x = grid->GetTileSize();
+                    dataTable.push_back(columns);
+                    dataTable.push_back(rows);
+                    size_t bits = dataTable.size();
+                    dataTable.resize(bits + TileBitWords(columns, rows));
+                    grid->GetTiles(&dataTable[bits]);
+                    break;
+                }
+                case ShapeType::Heightfield: {
+                    const HeightfieldShape* field = static_cast<const HeightfieldShape*>(collider->shape);
+                    shape.kind = ShapeHeightfield;
+                    shape.x = field->spacing;
+                    for(float height : field->heights)
+                        dataTable.push_back(FloatToWord(height));
+                    break;
+                }
+            }
+            shape.dataCount = static_cast<uint32_t>(dataTable.size()) - shape.dataIndex;
+            record.shapeIndex = static_cast<uint32_t>(shapeTable.size());
+            shapeTable.push_back(shape);
+
+            // Scenes typically use a handful of materials, so a linear search is enough
+            MaterialRecord material = {collider->restitution, collider->staticFriction, collider->dynamicFriction};
+            uint32_t materialIndex = 0;
+            while(materialIndex < materialTable.size() &&
+                  std::memcmp(&materialTable[materialIndex], &material, sizeof(MaterialRecord)) != 0)
+                materialIndex++;
+            if(materialIndex == materialTable.size())
+                materialTable.push_back(material);
+            record.materialIndex = materialIndex;
+        }
+
+        bodyTable.push_back(record);
+    }
+
+    for(int i = 0; i < world.GetForceGeneratorCount(); i++){
+        auto* gravity = dynamic_cast<const GravityForce*>(world.GetForceGenerator(i));
+        if(gravity)
+            forceTable.push_back({ForceGravity, gravity->gravity.x, gravity->gravity.y});
+    }
+
+    Header header = {};
+    header.magic = Magic;
+    header.version = Version;
+    header.bodyCount = static_cast<uint32_t>(bodyTable.size());
+    header.shapeCount = static_cast<uint32_t>(shapeTable.size());
+    header.materialCount = static_cast<uint32_t>(materialTable.size());
+    header.forceCount = static_cast<uint32_t>(forceTable.size());
+    header.bodyOffset = sizeof(Header);
+    header.shapeOffset = header.bodyOffset + header.bodyCount * sizeof(BodyRecord);
+    header.materialOffset = header.shapeOffset + header.shapeCount * sizeof(ShapeRecord);
+    header.forceOffset = header.materialOffset + header.materialCount * sizeof(MaterialRecord);
+    header.dataCount = static_cast<uint32_t>(dataTable.size());
+    header.dataOffset = header.forceOffset + header.forceCount * sizeof(ForceRecord);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file)
+        return false;
+
+    if(!IsLittleEndian())
+        SwapWords(&header, sizeof(Header));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    WriteTable(file, bodyTable);
+    WriteTable(file, shapeTable);
+    WriteTable(file, materialTable);
+    WriteTable(file, forceTable);
+    WriteTable(file, dataTable);
+
+    return static_cast<bool>(file);
+}
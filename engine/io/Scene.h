@@ -0,0 +1,44 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "../physics/RigidBody.h"
+#include "../shapes/AABBShape.h"
+#include "../shapes/CircleShape.h"
+#include "../shapes/PolygonShape.h"
+#include "../shapes/TileGridShape.h"
+#include "../shapes/HeightfieldShape.h"
+#include "../forces/ForceGenerator.h"
+
+class PhysicsWorld;
+
+// Owns the bodies, colliders, shapes and force generators loaded from a binary
+// scene file (see SceneFormat.h). Objects live in contiguous arrays, so the
+// scene must outlive any world it was added to.
+class Scene{
+    public:
+        Scene() = default;
+        Scene(const Scene&) = delete;
+        Scene& operator=(const Scene&) = delete;
+
+        bool LoadFromFile(const char* path);
+        void AddToWorld(PhysicsWorld& world);
+
+        // Write every body and gravity generator of a world to a scene file
+        static bool SaveWorld(const PhysicsWorld& world, const char* path);
+
+        int GetBodyCount() const { return static_cast<int>(bodies.size()); }
+        RigidBody* GetBody(int index) { return &bodies[index]; }
+
+    private:
+        bool LoadFromMemory(const unsigned char* data, size_t size);
+        void Clear();
+
+        std::vector<RigidBody> bodies;
+        std::vector<Collider> colliders;
+        std::vector<CircleShape> circles;
+        std::vector<AABBShape> boxes;
+        std::vector<PolygonShape> polygons;
+        std::vector<TileGridShape> tileGrids;
+        std::vector<HeightfieldShape> heightfields;
+        std::vector<std::unique_ptr<ForceGenerator>> forceGenerators;
+};
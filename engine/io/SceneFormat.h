@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+
+// On-disk layout of a binary scene. Every field is a 32-bit little-endian word,
+// so a file can be mapped and its tables read in place on little-endian hosts.
+namespace SceneFormat {
+    constexpr uint32_t Magic = 0x4432474E; // "NG2D"
+    constexpr uint32_t Version = 2;
+    constexpr uint32_t NoIndex = 0xFFFFFFFFu;
+
+    // Polygons and terrain keep their variable-length part in the data table,
+    // words [dataIndex, dataIndex + dataCount):
+    //   polygon      x, y of each vertex, centroid at the origin
+    //   tile grid    columns, rows, then one bit per tile, row by row, 32 per word
+    //   heightfield  every height
+    enum ShapeKind : uint32_t {
+        ShapeCircle = 0,
+        ShapeAABB = 1,
+        ShapePolygon = 2,
+        ShapeTileGrid = 3,
+        ShapeHeightfield = 4
+    };
+
+    enum ForceKind : uint32_t {
+        ForceGravity = 0
+    };
+
+    enum BodyFlags : uint32_t {
+        BodySleeping = 1u << 0,
+        BodyBullet = 1u << 1,
+        BodySensor = 1u << 2    // The collider is a sensor
+    };
+
+    struct Header{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t bodyCount;
+        uint32_t shapeCount;
+        uint32_t materialCount;
+        uint32_t forceCount;
+        // Byte offsets of each table from the start of the file
+        uint32_t bodyOffset;
+        uint32_t shapeOffset;
+        uint32_t materialOffset;
+        uint32_t forceOffset;
+        uint32_t dataCount;     // Words
+        uint32_t dataOffset;
+    };
+
+    struct BodyRecord{
+        float mass;
+        float inverseInertia;
+        float sizeX, sizeY;
+        float positionX, positionY;
+        float velocityX, velocityY;
+        float orientation;
+        float angularVelocity;
+        float linearDamping;
+        float angularDamping;
+        float sleepTime;
+        uint32_t flags;
+        uint32_t shapeIndex;    // NoIndex if the body has no collider
+        uint32_t materialIndex;
+    };
+
+    struct ShapeRecord{
+        uint32_t kind;
+        float x; // Radius for circles, half width for boxes, tile size, heightfield spacing
+        float y; // Half height for boxes
+        uint32_t dataIndex;
+        uint32_t dataCount;
+    };
+
+    struct MaterialRecord{
+        float restitution;
+        float staticFriction;
+        float dynamicFriction;
+    };
+
+    struct ForceRecord{
+        uint32_t kind;
+        float x, y;
+    };
+
+    static_assert(sizeof(Header) == 48, "scene header layout changed");
+    static_assert(sizeof(BodyRecord) == 64, "body record layout changed");
+    static_assert(sizeof(ShapeRecord) == 20, "shape record layout changed");
+    static_assert(sizeof(MaterialRecord) == 12, "material record layout changed");
+    static_assert(sizeof(ForceRecord) == 12, "force record layout changed");
+}
@@ -0,0 +1,109 @@
+#include "SharedTransformExporter.h"
+#include "../physics/PhysicsWorld.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define NGEN2D_HAS_SHM 1
+#endif
+
+using namespace SharedTransformLayout;
+
+bool SharedTransformExporter::Open(const char* name, uint32_t capacity){
+    Close();
+
+#ifdef NGEN2D_HAS_SHM
+    size_t size = RegionSize(capacity);
+
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if(fd < 0) return false;
+
+    if(ftruncate(fd, static_cast<off_t>(size)) != 0){
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(view == MAP_FAILED){
+        shm_unlink(name);
+        return false;
+    }
+
+    region = view;
+    regionSize = size;
+    this->capacity = capacity;
+    this->name = name;
+    nextBuffer = 0;
+
+    // Buffers start even (complete) and empty; magic is written last so a
+    // reader never sees a half-initialised region as valid
+    Header* header = static_cast<Header*>(region);
+    header->magic = 0;
+    header->version = Version;
+    header->capacity = capacity;
+    header->latest.store(NoFrame, std::memory_order_relaxed);
+    for(uint32_t i = 0; i < 2; i++){
+        BufferHeader* buffer = GetBuffer(region, capacity, i);
+        buffer->sequence.store(0, std::memory_order_relaxed);
+        buffer->bodyCount = 0;
+        buffer->truncated = 0;
+        buffer->step = 0;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = Magic;
+    return true;
+#else
+    (void)name;
+    (void)capacity;
+    return false;
+#endif
+}
+
+void SharedTransformExporter::Close(){
+#ifdef NGEN2D_HAS_SHM
+    if(region){
+        munmap(region, regionSize);
+        shm_unlink(name.c_str());
+    }
+#endif
+    region = nullptr;
+    regionSize = 0;
+}
+
+void SharedTransformExporter::Publish(const PhysicsWorld& world){
+    if(!region) return;
+
+    Header* header = static_cast<Header*>(region);
+    BufferHeader* buffer = GetBuffer(region, capacity, nextBuffer);
+    BodyTransform* out = GetBodies(buffer);
+
+    // Seqlock write: odd while the buffer is being filled
+    uint32_t sequence = buffer->sequence.load(std::memory_order_relaxed);
+    buffer->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint32_t count = static_cast<uint32_t>(world.GetBodyCount());
+    buffer->truncated = count > capacity ? 1u : 0u;
+    if(count > capacity) count = capacity;
+
+    for(uint32_t i = 0; i < count; i++){
+        const RigidBody* body = world.GetBody(static_cast<int>(i));
+        BodyTransform& t = out[i];
+        t.id = body->id;
+        t.positionX = body->position.x;
+        t.positionY = body->position.y;
+        t.orientation = body->orientation;
+        t.velocityX = body->velocity.x;
+        t.velocityY = body->velocity.y;
+        t.angularVelocity = body->angularVelocity;
+    }
+    buffer->bodyCount = count;
+    buffer->step = world.GetStepCount();
+
+    buffer->sequence.store(sequence + 2, std::memory_order_release);
+    header->latest.store(nextBuffer, std::memory_order_release);
+    nextBuffer ^= 1u;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "SharedTransformLayout.h"
+
+class PhysicsWorld;
+
+// Publishes body ids, poses and velocities into a POSIX shared-memory region
+// (see SharedTransformLayout.h) so other processes can read them without
+// linking the engine. Attach it with PhysicsWorld::SetTransformExporter to
+// publish after every step.
+class SharedTransformExporter{
+    public:
+        SharedTransformExporter() = default;
+        SharedTransformExporter(const SharedTransformExporter&) = delete;
+        SharedTransformExporter& operator=(const SharedTransformExporter&) = delete;
+        ~SharedTransformExporter() { Close(); }
+
+        // name follows shm_open rules, e.g. "/ngen2d_transforms"
+        bool Open(const char* name, uint32_t capacity);
+        void Close();
+        bool IsOpen() const { return region != nullptr; }
+
+        void Publish(const PhysicsWorld& world);
+
+    private:
+        void* region = nullptr;
+        size_t regionSize = 0;
+        uint32_t capacity = 0;
+        uint32_t nextBuffer = 0;
+        std::string name;
+};
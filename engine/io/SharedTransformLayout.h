@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Memory layout of the shared transform region published by
+// SharedTransformExporter. The region holds two frame buffers that the writer
+// fills alternately, each guarded by its own sequence counter (odd while
+// being written), and a header naming the buffer with the newest frame.
+// Readers never block the writer: they read the latest buffer in place and
+// check its sequence afterwards.
+namespace SharedTransformLayout {
+    constexpr uint32_t Magic = 0x4D53474E; // "NGSM"
+    constexpr uint32_t Version = 1;
+
+    struct BodyTransform{
+        uint32_t id;
+        float positionX, positionY;
+        float orientation;
+        float velocityX, velocityY;
+        float angularVelocity;
+    };
+
+    struct alignas(64) Header{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity; // Bodies per buffer
+        std::atomic<uint32_t> latest; // Index of the newest complete buffer, or NoFrame
+    };
+
+    struct alignas(64) BufferHeader{
+        std::atomic<uint32_t> sequence;
+        uint32_t bodyCount;
+        uint32_t truncated; // Non-zero if the world had more bodies than capacity
+        uint64_t step;
+    };
+
+    constexpr uint32_t NoFrame = 0xFFFFFFFFu;
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared counters must be lock-free");
+    static_assert(sizeof(BodyTransform) == 28, "body transform layout changed");
+
+    inline size_t BufferSize(uint32_t capacity){
+        size_t bytes = sizeof(BufferHeader) + static_cast<size_t>(capacity) * sizeof(BodyTransform);
+        return (bytes + 63) & ~static_cast<size_t>(63);
+    }
+
+    inline size_t RegionSize(uint32_t capacity){
+        return sizeof(Header) + 2 * BufferSize(capacity);
+    }
+
+    inline BufferHeader* GetBuffer(void* region, uint32_t capacity, uint32_t index){
+        return reinterpret_cast<BufferHeader*>(static_cast<unsigned char*>(region) + sizeof(Header) + index * BufferSize(capacity));
+    }
+
+    inline BodyTransform* GetBodies(BufferHeader* buffer){
+        return reinterpret_cast<BodyTransform*>(buffer + 1);
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "SharedTransformLayout.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Header-only reader for regions written by SharedTransformExporter, for
+// processes that don't link the engine. Frames are read in place:
+//
+//     SharedTransformView view;
+//     if(reader.BeginRead(view)){
+//         ... use view.bodies[0 .. view.bodyCount) ...
+//         if(!reader.EndRead()) { the writer overwrote the frame, discard }
+//     }
+struct SharedTransformView{
+    const SharedTransformLayout::BodyTransform* bodies = nullptr;
+    uint32_t bodyCount = 0;
+    uint64_t step = 0;
+    bool truncated = false;
+};
+
+class SharedTransformReader{
+    public:
+        SharedTransformReader() = default;
+        SharedTransformReader(const SharedTransformReader&) = delete;
+        SharedTransformReader& operator=(const SharedTransformReader&) = delete;
+        ~SharedTransformReader() { Close(); }
+
+        bool Open(const char* name){
+            Close();
+#if defined(__unix__) || defined(__APPLE__)
+            int fd = shm_open(name, O_RDONLY, 0);
+            if(fd < 0) return false;
+
+            struct stat info;
+            if(fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SharedTransformLayout::Header)){
+                close(fd);
+                return false;
+            }
+
+            void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if(view == MAP_FAILED) return false;
+
+            region = view;
+            regionSize = static_cast<size_t>(info.st_size);
+
+            const auto* header = static_cast<const SharedTransformLayout::Header*>(region);
+            if(header->magic != SharedTransformLayout::Magic ||
+               header->version != SharedTransformLayout::Version ||
+               SharedTransformLayout::RegionSize(header->capacity) > regionSize){
+                Close();
+                return false;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            capacity = header->capacity;
+            return true;
+#else
+            (void)name;
+            return false;
+#endif
+        }
+
+        void Close(){
+#if defined(__unix__) || defined(__APPLE__)
+            if(region)
+                munmap(region, regionSize);
+#endif
+            region = nullptr;
+            regionSize = 0;
+        }
+
+        bool IsOpen() const { return region != nullptr; }
+
+        // Point view at the newest complete frame. Returns false if nothing has
+        // been published yet or the writer is mid-way through that buffer.
+        bool BeginRead(SharedTransformView& view){
+            if(!region) return false;
+
+            auto* header = static_cast<SharedTransformLayout::Header*>(region);
+            uint32_t latest = header->latest.load(std::memory_order_acquire);
+            if(latest > 1) return false;
+
+            current = SharedTransformLayout::GetBuffer(region, capacity, latest);
+            sequence = current->sequence.load(std::memory_order_acquire);
+            if(sequence & 1u) return false;
+
+            view.bodies = SharedTransformLayout::GetBodies(current);
+            view.bodyCount = current->bodyCount;
+            view.step = current->step;
+            view.truncated = current->truncated != 0;
+            if(view.bodyCount > capacity) return false;
+            return true;
+        }
+
+        // True if the frame returned by BeginRead stayed intact while it was used
+        bool EndRead(){
+            if(!current) return false;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            bool valid = current->sequence.load(std::memory_order_relaxed) == sequence;
+            current = nullptr;
+            return valid;
+        }
+
+    private:
+        void* region = nullptr;
+        size_t regionSize = 0;
+        uint32_t capacity = 0;
+        SharedTransformLayout::BufferHeader* current = nullptr;
+        uint32_t sequence = 0;
+};
@@ -0,0 +1,142 @@
+#include "TransformReader.h"
+
+using namespace TransformRecording;
+
+bool TransformReader::Open(const char* path){
+    Close();
+
+    file = std::fopen(path, "rb");
+    if(!file) return false;
+
+    unsigned char header[FileHeaderSize];
+    if(std::fread(header, 1, sizeof(header), file) != sizeof(header) ||
+       GetU32(header) != FileMagic || GetU32(header + 4) != Version){
+        Close();
+        return false;
+    }
+
+    // Index chunks by walking their headers; payloads are skipped
+    unsigned char chunkHeader[ChunkHeaderSize];
+    while(std::fread(chunkHeader, 1, sizeof(chunkHeader), file) == sizeof(chunkHeader)){
+        if(GetU32(chunkHeader) != ChunkMagic) break;
+
+        ChunkInfo info;
+        info.offset = std::ftell(file);
+        info.stepCount = GetU32(chunkHeader + 4);
+        info.firstStep = GetU64(chunkHeader + 8);
+        info.lastStep = GetU64(chunkHeader + 16);
+        info.payloadBytes = GetU32(chunkHeader + 24);
+        info.idLimit = GetU32(chunkHeader + 28);
+        if(info.idLimit > MaxIdLimit) break;
+
+        // A truncated final chunk (e.g. the process died mid-write) is ignored
+        if(std::fseek(file, static_cast<long>(info.payloadBytes), SEEK_CUR) != 0) break;
+        if(std::ftell(file) != info.offset + static_cast<long>(info.payloadBytes)) break;
+        chunks.push_back(info);
+    }
+
+    return Seek(GetFirstStep());
+}
+
+void TransformReader::Close(){
+    if(file){
+        std::fclose(file);
+        file = nullptr;
+    }
+    chunks.clear();
+    chunkLoaded = false;
+}
+
+bool TransformReader::LoadChunk(size_t index){
+    if(index >= chunks.size()) return false;
+
+    const ChunkInfo& info = chunks[index];
+    payload.resize(info.payloadBytes);
+    if(std::fseek(file, info.offset, SEEK_SET) != 0 ||
+       std::fread(payload.data(), 1, payload.size(), file) != payload.size())
+        return false;
+
+    chunkIndex = index;
+    chunkLoaded = true;
+    framesLeft = info.stepCount;
+    lastStep = info.firstStep;
+    cursor = payload.data();
+    chunkStamp++;
+    if(previous.size() < info.idLimit){
+        previous.resize(info.idLimit);
+        previousStamp.resize(info.idLimit, 0);
+    }
+    return true;
+}
+
+bool TransformReader::Seek(uint64_t step){
+    if(chunks.empty()) return false;
+
+    // Binary search for the first chunk that ends at or after step
+    size_t lo = 0, hi = chunks.size();
+    while(lo < hi){
+        size_t mid = (lo + hi) / 2;
+        if(chunks[mid].lastStep < step) lo = mid + 1;
+        else hi = mid;
+    }
+    if(lo == chunks.size() || !LoadChunk(lo)) return false;
+
+    // Decode forward inside the chunk until the next frame is at or after step.
+    // Each frame starts with its step delta, so it can be peeked without
+    // applying the frame's body deltas.
+    const unsigned char* end = payload.data() + payload.size();
+    uint64_t frameStep;
+    std::vector<RecordedBody> scratch;
+    while(framesLeft > 0){
+        const unsigned char* peek = cursor;
+        uint32_t stepDelta;
+        if(!GetVarint(peek, end, stepDelta)) return false;
+        if(lastStep + stepDelta >= step) break;
+        if(!ReadFrame(frameStep, scratch)) return false;
+    }
+    return true;
+}
+
+bool TransformReader::ReadFrame(uint64_t& step, std::vector<RecordedBody>& frame){
+    frame.clear();
+
+    if(!chunkLoaded) return false;
+    if(framesLeft == 0){
+        if(!LoadChunk(chunkIndex + 1)) return false;
+    }
+
+    const unsigned char* end = payload.data() + payload.size();
+    uint32_t stepDelta, count;
+    if(!GetVarint(cursor, end, stepDelta) || !GetVarint(cursor, end, count))
+        return false;
+
+    step = lastStep + stepDelta;
+    lastStep = step;
+    framesLeft--;
+
+    frame.reserve(count);
+    uint32_t lastId = 0;
+    for(uint32_t i = 0; i < count; i++){
+        uint32_t value;
+        if(!GetVarint(cursor, end, value)) return false;
+        uint32_t id = lastId + static_cast<uint32_t>(UnZigZag(value));
+        lastId = id;
+        if(id >= chunks[chunkIndex].idLimit) return false;
+
+        RecordedBody& prev = previous[id];
+        if(previousStamp[id] != chunkStamp){
+            prev = RecordedBody{id, 0, 0, 0, 0, 0, 0};
+            previousStamp[id] = chunkStamp;
+        }
+
+        int32_t fields[FieldCount];
+        GetFields(prev, fields);
+        for(int k = 0; k < FieldCount; k++){
+            if(!GetVarint(cursor, end, value)) return false;
+            fields[k] = static_cast<int32_t>(static_cast<uint32_t>(fields[k]) + static_cast<uint32_t>(UnZigZag(value)));
+        }
+        SetFields(prev, fields);
+        frame.push_back(prev);
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdio>
+#include <vector>
+#include "TransformRecording.h"
+
+// Reads recordings produced by TransformRecorder. Open() indexes the chunk
+// headers, so seeking to a step only decodes the chunk that contains it.
+// A body id outside its chunk's idLimit fails the read.
+class TransformReader{
+    public:
+        TransformReader() = default;
+        TransformReader(const TransformReader&) = delete;
+        TransformReader& operator=(const TransformReader&) = delete;
+        ~TransformReader() { Close(); }
+
+        bool Open(const char* path);
+        void Close();
+
+        bool IsEmpty() const { return chunks.empty(); }
+        uint64_t GetFirstStep() const { return chunks.empty() ? 0 : chunks.front().firstStep; }
+        uint64_t GetLastStep() const { return chunks.empty() ? 0 : chunks.back().lastStep; }
+        size_t GetChunkCount() const { return chunks.size(); }
+
+        // Position the reader on the first recorded step >= step
+        bool Seek(uint64_t step);
+        // Read the next recorded step: its number and the awake bodies in it
+        bool ReadFrame(uint64_t& step, std::vector<RecordedBody>& frame);
+
+    private:
+        struct ChunkInfo{
+            long offset; // Start of the payload
+            uint32_t payloadBytes;
+            uint32_t stepCount;
+            uint64_t firstStep;
+            uint64_t lastStep;
+            uint32_t idLimit;
+        };
+
+        bool LoadChunk(size_t index);
+
+        std::FILE* file = nullptr;
+        std::vector<ChunkInfo> chunks;
+
+        // Decoding state for the loaded chunk
+        size_t chunkIndex = 0;
+        bool chunkLoaded = false;
+        uint32_t framesLeft = 0;
+        uint64_t lastStep = 0;
+        std::vector<unsigned char> payload;
+        const unsigned char* cursor = nullptr;
+        std::vector<RecordedBody> previous;
+        std::vector<uint32_t> previousStamp;
+        uint32_t chunkStamp = 0;
+};
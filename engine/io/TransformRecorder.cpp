@@ -0,0 +1,162 @@
+#include "TransformRecorder.h"
+#include "../physics/PhysicsWorld.h"
+#include <algorithm>
+
+using namespace TransformRecording;
+
+bool TransformRecorder::Start(const char* path, int stepsPerChunk){
+    Stop();
+
+    file = std::fopen(path, "wb");
+    if(!file) return false;
+
+    unsigned char header[FileHeaderSize];
+    PutU32(header, FileMagic);
+    PutU32(header + 4, Version);
+    std::fwrite(header, 1, sizeof(header), file);
+
+    this->stepsPerChunk = stepsPerChunk > 0 ? stepsPerChunk : 1;
+    droppedChunks = 0;
+    stopping = false;
+    current.Clear();
+    writer = std::thread(&TransformRecorder::WriterLoop, this);
+    return true;
+}
+
+void TransformRecorder::Stop(){
+    if(!file) return;
+
+    if(!current.steps.empty())
+        SubmitCurrent();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+
+    std::fclose(file);
+    file = nullptr;
+}
+
+void TransformRecorder::Record(const PhysicsWorld& world, uint64_t step){
+    if(!file) return;
+
+    uint32_t awake = 0;
+    for(int i = 0; i < world.GetBodyCount(); i++){
+        const RigidBody* body = world.GetBody(i);
+        if(body->isSleeping || body->id >= MaxIdLimit) continue;
+
+        RecordedBody record;
+        record.id = body->id;
+        record.positionX = Quantize(body->position.x, PositionScale);
+        record.positionY = Quantize(body->position.y, PositionScale);
+        record.orientation = Quantize(body->orientation, OrientationScale);
+        record.velocityX = Quantize(body->velocity.x, VelocityScale);
+        record.velocityY = Quantize(body->velocity.y, VelocityScale);
+        record.angularVelocity = Quantize(body->angularVelocity, AngularVelocityScale);
+        current.bodies.push_back(record);
+        awake++;
+    }
+    current.steps.push_back(step);
+    current.frameSizes.push_back(awake);
+
+    if(static_cast<int>(current.steps.size()) >= stepsPerChunk)
+        SubmitCurrent();
+}
+
+// Hand the filled chunk to the writer and pick up recycled storage for the next one
+void TransformRecorder::SubmitCurrent(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(pending.size() >= MaxPendingChunks){
+            droppedChunks++;
+            current.Clear();
+            return;
+        }
+
+        pending.push_back(std::move(current));
+        if(!spare.empty()){
+            current = std::move(spare.back());
+            spare.pop_back();
+        } else {
+            current = Chunk();
+        }
+    }
+    current.Clear();
+    wake.notify_one();
+}
+
+void TransformRecorder::WriterLoop(){
+    std::unique_lock<std::mutex> lock(mutex);
+    for(;;){
+        wake.wait(lock, [this]{ return stopping || !pending.empty(); });
+        if(pending.empty()){
+            if(stopping) return;
+            continue;
+        }
+
+        Chunk chunk = std::move(pending.front());
+        pending.pop_front();
+
+        lock.unlock();
+        WriteChunk(chunk);
+        lock.lock();
+
+        spare.push_back(std::move(chunk));
+    }
+}
+
+void TransformRecorder::WriteChunk(const Chunk& chunk){
+    // Deltas restart in every chunk so chunks decode independently
+    chunkStamp++;
+    encoded.clear();
+
+    uint64_t lastStep = chunk.steps.front();
+    size_t bodyIndex = 0;
+    uint32_t idLimit = 0;
+    for(size_t f = 0; f < chunk.steps.size(); f++){
+        PutVarint(encoded, static_cast<uint32_t>(chunk.steps[f] - lastStep));
+        lastStep = chunk.steps[f];
+
+        uint32_t count = chunk.frameSizes[f];
+        PutVarint(encoded, count);
+
+        uint32_t lastId = 0;
+        for(uint32_t i = 0; i < count; i++, bodyIndex++){
+            const RecordedBody& body = chunk.bodies[bodyIndex];
+            PutVarint(encoded, ZigZag(static_cast<int32_t>(body.id - lastId)));
+            lastId = body.id;
+            idLimit = std::max(idLimit, body.id + 1);
+
+            if(body.id >= previous.size()){
+                previous.resize(body.id + 1);
+                previousStamp.resize(body.id + 1, 0);
+            }
+            RecordedBody& prev = previous[body.id];
+            if(previousStamp[body.id] != chunkStamp){
+                prev = RecordedBody{body.id, 0, 0, 0, 0, 0, 0};
+                previousStamp[body.id] = chunkStamp;
+            }
+
+            int32_t fields[FieldCount], prevFields[FieldCount];
+            GetFields(body, fields);
+            GetFields(prev, prevFields);
+            for(int k = 0; k < FieldCount; k++)
+                PutVarint(encoded, ZigZag(static_cast<int32_t>(static_cast<uint32_t>(fields[k]) - static_cast<uint32_t>(prevFields[k]))));
+            prev = body;
+        }
+    }
+
+    unsigned char header[ChunkHeaderSize] = {};
+    PutU32(header, ChunkMagic);
+    PutU32(header + 4, static_cast<uint32_t>(chunk.steps.size()));
+    PutU64(header + 8, chunk.steps.front());
+    PutU64(header + 16, chunk.steps.back());
+    PutU32(header + 24, static_cast<uint32_t>(encoded.size()));
+    PutU32(header + 28, idLimit);
+
+    std::fwrite(header, 1, sizeof(header), file);
+    std::fwrite(encoded.data(), 1, encoded.size(), file);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TransformRecording.h"
+
+class PhysicsWorld;
+
+// Streams quantized transforms and velocities of awake bodies to disk.
+// Bodies with ids at or above TransformRecording::MaxIdLimit are skipped.
+// Record() only quantizes into an in-memory chunk; encoding and file writes
+// happen on a background thread, one chunk at a time.
+class TransformRecorder{
+    public:
+        TransformRecorder() = default;
+        TransformRecorder(const TransformRecorder&) = delete;
+        TransformRecorder& operator=(const TransformRecorder&) = delete;
+        ~TransformRecorder() { Stop(); }
+
+        bool Start(const char* path, int stepsPerChunk = 60);
+        void Stop();
+        bool IsRecording() const { return file != nullptr; }
+
+        // Call once per world step, after PhysicsWorld::Step
+        void Record(const PhysicsWorld& world, uint64_t step);
+
+        // Chunks discarded because the writer thread fell too far behind
+        int GetDroppedChunkCount() const { return droppedChunks; }
+
+    private:
+        struct Chunk{
+            std::vector<uint64_t> steps;
+            std::vector<uint32_t> frameSizes;
+            std::vector<RecordedBody> bodies;
+
+            void Clear() { steps.clear(); frameSizes.clear(); bodies.clear(); }
+        };
+
+        void SubmitCurrent();
+        void WriterLoop();
+        void WriteChunk(const Chunk& chunk);
+
+        static constexpr size_t MaxPendingChunks = 16;
+
+        std::FILE* file = nullptr;
+        int stepsPerChunk = 60;
+        Chunk current;
+        int droppedChunks = 0;
+
+        std::thread writer;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<Chunk> pending;
+        std::vector<Chunk> spare; // Recycled chunk storage
+        bool stopping = false;
+
+        // Writer thread state
+        std::vector<unsigned char> encoded;
+        std::vector<RecordedBody> previous;
+        std::vector<uint32_t> previousStamp;
+        uint32_t chunkStamp = 0;
+};
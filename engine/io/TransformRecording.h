@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Quantized body state as stored in a transform recording
+struct RecordedBody{
+    uint32_t id;
+    int32_t positionX, positionY;
+    int32_t orientation;
+    int32_t velocityX, velocityY;
+    int32_t angularVelocity;
+};
+
+// Layout of transform recordings written by TransformRecorder.
+// A file is a header followed by self-contained chunks of consecutive steps.
+// Each chunk payload stores, per step, the awake bodies as zigzag varints of
+// the difference to the same body's previous value inside the chunk, so any
+// chunk can be decoded without reading the ones before it. The chunk header
+// bounds the body ids in the chunk, so a reader never sizes anything by an id
+// it hasn't checked.
+namespace TransformRecording {
+    constexpr uint32_t FileMagic = 0x4352474E;  // "NGRC"
+    constexpr uint32_t ChunkMagic = 0x4B4E4843; // "CHNK"
+    constexpr uint32_t Version = 2;             // 2: chunk headers carry idLimit
+
+    // Bodies with larger ids aren't recorded; chunks claiming more are corrupt
+    constexpr uint32_t MaxIdLimit = 1u << 24;
+
+    constexpr int FieldCount = 6;
+
+    // Quantization steps (units per stored integer)
+    constexpr float PositionScale = 1.0f / 64.0f;        // pixels
+    constexpr float VelocityScale = 1.0f / 16.0f;        // pixels per second
+    constexpr float OrientationScale = 1.0f / 10430.0f;  // ~2^16 steps per turn
+    constexpr float AngularVelocityScale = 1.0f / 1024.0f;
+
+    constexpr int FileHeaderSize = 8;   // magic, version
+    constexpr int ChunkHeaderSize = 32; // magic, stepCount, firstStep, lastStep, payloadBytes, idLimit
+
+    // idLimit is one more than the largest body id in the chunk (0 if none)
+
+    inline int32_t Quantize(float value, float scale){
+        float q = value / scale;
+        if(q > 2147483520.0f) return INT32_MAX;
+        if(q < -2147483520.0f) return INT32_MIN;
+        return static_cast<int32_t>(q < 0.0f ? q - 0.5f : q + 0.5f);
+    }
+
+    inline float Dequantize(int32_t value, float scale){
+        return static_cast<float>(value) * scale;
+    }
+
+    inline void GetFields(const RecordedBody& body, int32_t fields[FieldCount]){
+        fields[0] = body.positionX;
+        fields[1] = body.positionY;
+        fields[2] = body.orientation;
+        fields[3] = body.velocityX;
+        fields[4] = body.velocityY;
+        fields[5] = body.angularVelocity;
+    }
+
+    inline void SetFields(RecordedBody& body, const int32_t fields[FieldCount]){
+        body.positionX = fields[0];
+        body.positionY = fields[1];
+        body.orientation = fields[2];
+        body.velocityX = fields[3];
+        body.velocityY = fields[4];
+        body.angularVelocity = fields[5];
+    }
+
+    // ---- byte encoding helpers (little-endian, LEB128 varints) ----
+
+    inline uint32_t ZigZag(int32_t value){
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    inline int32_t UnZigZag(uint32_t value){
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+    }
+
+    inline void PutVarint(std::vector<unsigned char>& out, uint32_t value){
+        while(value >= 0x80){
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    // Returns false if the varint runs past end
+    inline bool GetVarint(const unsigned char*& p, const unsigned char* end, uint32_t& value){
+        value = 0;
+        for(int shift = 0; shift < 35 && p < end; shift += 7){
+            unsigned char byte = *p++;
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    inline void PutU32(unsigned char* out, uint32_t value){
+        for(int i = 0; i < 4; i++) out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    inline void PutU64(unsigned char* out, uint64_t value){
+        for(int i = 0; i < 8; i++) out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    inline uint32_t GetU32(const unsigned char* in){
+        uint32_t value = 0;
+        for(int i = 0; i < 4; i++) value |= static_cast<uint32_t>(in[i]) << (8 * i);
+        return value;
+    }
+
+    inline uint64_t GetU64(const unsigned char* in){
+        uint64_t value = 0;
+        for(int i = 0; i < 8; i++) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+        return value;
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include <cmath>
+
+// Wide float type for processing several values per instruction. The lane
+// count is chosen at build time: 8 with AVX2, 4 with SSE2, otherwise 1 (plain
+// scalar code). Loops written as
+//
+//     for(; i + FloatN::Width <= count; i += FloatN::Width) { ... }
+//
+// work for every width. Arithmetic is plain IEEE per lane (no reciprocal
+// approximations), so results are bit-identical to the same expression on floats.
+// Defining NGEN2D_SIMD_FORCE_SCALAR selects the scalar fallback on any target.
+#if defined(NGEN2D_SIMD_FORCE_SCALAR)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define NGEN2D_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NGEN2D_SIMD_SSE2 1
+#endif
+
+#if defined(NGEN2D_SIMD_AVX2)
+
+struct MaskN{
+    __m256 m;
+
+    MaskN operator&(MaskN o) const { return {_mm256_and_ps(m, o.m)}; }
+    MaskN operator|(MaskN o) const { return {_mm256_or_ps(m, o.m)}; }
+    MaskN operator~() const { return {_mm256_xor_ps(m, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))}; }
+
+    // One bit per lane, lane 0 in bit 0
+    int Bits() const { return _mm256_movemask_ps(m); }
+    bool Any() const { return Bits() != 0; }
+};
+
+struct FloatN{
+    static constexpr int Width = 8;
+    __m256 v;
+
+    FloatN() : v(_mm256_setzero_ps()) {}
+    FloatN(float value) : v(_mm256_set1_ps(value)) {}
+    FloatN(__m256 v) : v(v) {}
+
+    static FloatN Load(const float* p) { return _mm256_loadu_ps(p); }
+    static FloatN Gather(const float* base, const int* index) {
+        return _mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)), 4);
+    }
+    void Store(float* p) const { _mm256_storeu_ps(p, v); }
+
+    FloatN operator+(FloatN o) const { return _mm256_add_ps(v, o.v); }
+    FloatN operator-(FloatN o) const { return _mm256_sub_ps(v, o.v); }
+    FloatN operator*(FloatN o) const { return _mm256_mul_ps(v, o.v); }
+    FloatN operator/(FloatN o) const { return _mm256_div_ps(v, o.v); }
+    FloatN operator-() const { return _mm256_xor_ps(v, _mm256_set1_ps(-0.0f)); }
+
+    MaskN operator<(FloatN o) const { return {_mm256_cmp_ps(v, o.v, _CMP_LT_OQ)}; }
+    MaskN operator<=(FloatN o) const { return {_mm256_cmp_ps(v, o.v, _CMP_LE_OQ)}; }
+    MaskN operator>(FloatN o) const { return {_mm256_cmp_ps(v, o.v, _CMP_GT_OQ)}; }
+    MaskN operator>=(FloatN o) const { return {_mm256_cmp_ps(v, o.v, _CMP_GE_OQ)}; }
+    MaskN operator==(FloatN o) const { return {_mm256_cmp_ps(v, o.v, _CMP_EQ_OQ)}; }
+    MaskN operator!=(FloatN o) const { return {_mm256_cmp_ps(v, o.v, _CMP_NEQ_UQ)}; }
+};
+
+// Min/Max return b on ties and NaN, like std::min(b, a) and std::max(b, a)
+inline FloatN Min(FloatN a, FloatN b) { return _mm256_min_ps(a.v, b.v); }
+inline FloatN Max(FloatN a, FloatN b) { return _mm256_max_ps(a.v, b.v); }
+inline FloatN Sqrt(FloatN a) { return _mm256_sqrt_ps(a.v); }
+inline FloatN Abs(FloatN a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+inline FloatN Select(MaskN mask, FloatN a, FloatN b) { return _mm256_blendv_ps(b.v, a.v, mask.m); }
+
+#elif defined(NGEN2D_SIMD_SSE2)
+
+struct MaskN{
+    __m128 m;
+
+    MaskN operator&(MaskN o) const { return {_mm_and_ps(m, o.m)}; }
+    MaskN operator|(MaskN o) const { return {_mm_or_ps(m, o.m)}; }
+    MaskN operator~() const { return {_mm_xor_ps(m, _mm_castsi128_ps(_mm_set1_epi32(-1)))}; }
+
+    // One bit per lane, lane 0 in bit 0
+    int Bits() const { return _mm_movemask_ps(m); }
+    bool Any() const { return Bits() != 0; }
+};
+
+struct FloatN{
+    static constexpr int Width = 4;
+    __m128 v;
+
+    FloatN() : v(_mm_setzero_ps()) {}
+    FloatN(float value) : v(_mm_set1_ps(value)) {}
+    FloatN(__m128 v) : v(v) {}
+
+    static FloatN Load(const float* p) { return _mm_loadu_ps(p); }
+    static FloatN Gather(const float* base, const int* index) {
+        return _mm_setr_ps(base[index[0]], base[index[1]], base[index[2]], base[index[3]]);
+    }
+    void Store(float* p) const { _mm_storeu_ps(p, v); }
+
+    FloatN operator+(FloatN o) const { return _mm_add_ps(v, o.v); }
+    FloatN operator-(FloatN o) const { return _mm_sub_ps(v, o.v); }
+    FloatN operator*(FloatN o) const { return _mm_mul_ps(v, o.v); }
+    FloatN operator/(FloatN o) const { return _mm_div_ps(v, o.v); }
+    FloatN operator-() const { return _mm_xor_ps(v, _mm_set1_ps(-0.0f)); }
+
+    MaskN operator<(FloatN o) const { return {_mm_cmplt_ps(v, o.v)}; }
+    MaskN operator<=(FloatN o) const { return {_mm_cmple_ps(v, o.v)}; }
+    MaskN operator>(FloatN o) const { return {_mm_cmpgt_ps(v, o.v)}; }
+    MaskN operator>=(FloatN o) const { return {_mm_cmpge_ps(v, o.v)}; }
+    MaskN operator==(FloatN o) const { return {_mm_cmpeq_ps(v, o.v)}; }
+    MaskN operator!=(FloatN o) const { return {_mm_cmpneq_ps(v, o.v)}; }
+};
+
+// Min/Max return b on ties and NaN, like std::min(b, a) and std::max(b, a)
+inline FloatN Min(FloatN a, FloatN b) { return _mm_min_ps(a.v, b.v); }
+inline FloatN Max(FloatN a, FloatN b) { return _mm_max_ps(a.v, b.v); }
+inline FloatN Sqrt(FloatN a) { return _mm_sqrt_ps(a.v); }
+inline FloatN Abs(FloatN a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+inline FloatN Select(MaskN mask, FloatN a, FloatN b) {
+    return _mm_or_ps(_mm_and_ps(mask.m, a.v), _mm_andnot_ps(mask.m, b.v));
+}
+
+#else
+
+struct MaskN{
+    bool m;
+
+    MaskN operator&(MaskN o) const { return {m && o.m}; }
+    MaskN operator|(MaskN o) const { return {m || o.m}; }
+    MaskN operator~() const { return {!m}; }
+
+    int Bits() const { return m ? 1 : 0; }
+    bool Any() const { return m; }
+};
+
+struct FloatN{
+    static constexpr int Width = 1;
+    float v;
+
+    FloatN() : v(0.0f) {}
+    FloatN(float value) : v(value) {}
+
+    static FloatN Load(const float* p) { return *p; }
+    static FloatN Gather(const float* base, const int* index) { return base[*index]; }
+    void Store(float* p) const { *p = v; }
+
+    FloatN operator+(FloatN o) const { return v + o.v; }
+    FloatN operator-(FloatN o) const { return v - o.v; }
+    FloatN operator*(FloatN o) const { return v * o.v; }
+    FloatN operator/(FloatN o) const { return v / o.v; }
+    FloatN operator-() const { return -v; }
+
+    MaskN operator<(FloatN o) const { return {v < o.v}; }
+    MaskN operator<=(FloatN o) const { return {v <= o.v}; }
+    MaskN operator>(FloatN o) const { return {v > o.v}; }
+    MaskN operator>=(FloatN o) const { return {v >= o.v}; }
+    MaskN operator==(FloatN o) const { return {v == o.v}; }
+    MaskN operator!=(FloatN o) const { return {v != o.v}; }
+};
+
+// Min/Max return b on ties and NaN, like std::min(b, a) and std::max(b, a)
+inline FloatN Min(FloatN a, FloatN b) { return a.v < b.v ? a.v : b.v; }
+inline FloatN Max(FloatN a, FloatN b) { return a.v > b.v ? a.v : b.v; }
+inline FloatN Sqrt(FloatN a) { return std::sqrt(a.v); }
+inline FloatN Abs(FloatN a) { return std::fabs(a.v); }
+inline FloatN Select(MaskN mask, FloatN a, FloatN b) { return mask.m ? a : b; }
+
+#endif
+
+// Same lane result as Clamp() in MathUtils.h, NaN and signed zeros included:
+// Min(value, max) is std::min(max, value) and Max(x, min) is std::max(min, x)
+inline FloatN Clamp(FloatN value, FloatN min, FloatN max) { return Max(Min(value, max), min); }
@@ -1,7 +1,36 @@
 #pragma once
 #include <algorithm>
 #include <cfloat>
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 inline float Clamp(float value, float min, float max){
     return std::max(min, std::min(max, value));
-}
\ No newline at end of file
+}
+
+// Interleaves the bits of x and y (x in the even bits), so sorting by the
+// result walks a 2D grid along a Z-order curve
+inline uint64_t MortonCode(uint32_t x, uint32_t y){
+    auto spread = [](uint64_t v){
+        v = (v | v << 16) & 0x0000FFFF0000FFFFull;
+        v = (v | v << 8) & 0x00FF00FF00FF00FFull;
+        v = (v | v << 4) & 0x0F0F0F0F0F0F0F0Full;
+        v = (v | v << 2) & 0x3333333333333333ull;
+        v = (v | v << 1) & 0x5555555555555555ull;
+        return v;
+    };
+    return spread(x) | spread(y) << 1;
+}
+
+// Index of the lowest set bit; v must not be 0
+inline int LowestBit(uint64_t v){
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(v);
+#endif
+}
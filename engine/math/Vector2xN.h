@@ -0,0 +1,54 @@
+#pragma once
+#include "FloatN.h"
+#include "Vector2.h"
+
+// FloatN::Width 2D vectors at once, loaded from and stored to parallel x/y
+// arrays. Each operation evaluates the same expression as its Vector2
+// counterpart, so lanes match scalar results bit for bit.
+struct Vector2xN{
+    FloatN x, y;
+
+    Vector2xN() {}
+    Vector2xN(FloatN x, FloatN y) : x(x), y(y) {}
+    Vector2xN(const Vector2& v) : x(v.x), y(v.y) {}
+
+    static Vector2xN Load(const float* xs, const float* ys) {
+        return Vector2xN(FloatN::Load(xs), FloatN::Load(ys));
+    }
+    static Vector2xN Gather(const float* xs, const float* ys, const int* index) {
+        return Vector2xN(FloatN::Gather(xs, index), FloatN::Gather(ys, index));
+    }
+    void Store(float* xs, float* ys) const {
+        x.Store(xs);
+        y.Store(ys);
+    }
+
+    Vector2xN operator+(const Vector2xN& other) const { return Vector2xN(x + other.x, y + other.y); }
+    Vector2xN operator-(const Vector2xN& other) const { return Vector2xN(x - other.x, y - other.y); }
+    Vector2xN operator*(FloatN scalar) const { return Vector2xN(x * scalar, y * scalar); }
+    Vector2xN operator/(FloatN scalar) const { return Vector2xN(x / scalar, y / scalar); }
+
+    FloatN dot(const Vector2xN& other) const { return x * other.x + y * other.y; }
+    FloatN cross(const Vector2xN& other) const { return x * other.y - y * other.x; }
+    FloatN lengthSquared() const { return x * x + y * y; }
+    FloatN length() const { return Sqrt(lengthSquared()); }
+
+    // Zero for lanes shorter than Vector2::normalize's threshold
+    Vector2xN normalize() const {
+        FloatN mgn = length();
+        MaskN valid = mgn > FloatN(0.00001f);
+        return Vector2xN(Select(valid, x / mgn, FloatN(0.0f)), Select(valid, y / mgn, FloatN(0.0f)));
+    }
+
+    // Rotate by the angle whose cosine and sine are given, and back again
+    Vector2xN Rotate(FloatN cosA, FloatN sinA) const {
+        return Vector2xN(x * cosA - y * sinA, x * sinA + y * cosA);
+    }
+    Vector2xN InverseRotate(FloatN cosA, FloatN sinA) const {
+        return Vector2xN(x * cosA + y * sinA, y * cosA - x * sinA);
+    }
+};
+
+inline Vector2xN Select(MaskN mask, const Vector2xN& a, const Vector2xN& b) {
+    return Vector2xN(Select(mask, a.x, b.x), Select(mask, a.y, b.y));
+}
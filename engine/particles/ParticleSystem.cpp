@@ -0,0 +1,684 @@
+#include "ParticleSystem.h"
+#include "../physics/RigidBody.h"
+#include "../shapes/AABBShape.h"
+#include "../shapes/CircleShape.h"
+#include "../shapes/PolygonShape.h"
+#include "../shapes/TileGridShape.h"
+#include "../shapes/HeightfieldShape.h"
+#include "../collision/Collision.h"
+#include "../math/MathUtils.h"
+#include "../math/Vector2xN.h"
+#include "../core/Config.h"
+
+#include <algorithm>
+
+int ParticleSystem::AddMaterial(const ParticleMaterial& mat){
+    materials.push_back(mat);
+    return static_cast<int>(materials.size()) - 1;
+}
+
+void ParticleSystem::Reserve(int count){
+    posX.reserve(count);
+    posY.reserve(count);
+    velX.reserve(count);
+    velY.reserve(count);
+    radius.reserve(count);
+    inverseMass.reserve(count);
+    material.reserve(count);
+}
+
+void ParticleSystem::Spawn(const Vector2& position, const Vector2& velocity, float r, int mat){
+    float mass = materials[mat].density * 3.14159265f * r * r;
+
+    posX.push_back(position.x);
+    posY.push_back(position.y);
+    velX.push_back(velocity.x);
+    velY.push_back(velocity.y);
+    radius.push_back(r);
+    inverseMass.push_back(mass > 0.0f ? 1.0f / mass : 0.0f);
+    material.push_back(static_cast<uint16_t>(mat));
+}
+
+void ParticleSystem::Clear(){
+    posX.clear();
+    posY.clear();
+    velX.clear();
+    velY.clear();
+    radius.clear();
+    inverseMass.clear();
+    material.clear();
+}
+
+void ParticleSystem::SaveState(State& state) const {
+    state.posX = posX;
+    state.posY = posY;
+    state.velX = velX;
+    state.velY = velY;
+    state.radius = radius;
+    state.inverseMass = inverseMass;
+    state.material = material;
+}
+
+void ParticleSystem::RestoreState(const State& state){
+    posX = state.posX;
+    posY = state.posY;
+    velX = state.velX;
+    velY = state.velY;
+    radius = state.radius;
+    inverseMass = state.inverseMass;
+    material = state.material;
+}
+
+// Bounding radius of a body's shape about its position
+static float BodyReach(const Shape* shape){
+    if(shape->GetType() == ShapeType::Circle) return static_cast<const CircleShape*>(shape)->radius;
+    if(shape->GetType() == ShapeType::Polygon) return static_cast<const PolygonShape*>(shape)->radius;
+    return static_cast<const AABBShape*>(shape)->halfsize.length();
+}
+
+void ParticleSystem::Step(float deltaTime, const std::vector<RigidBody*>& bodies){
+    if(posX.empty()) return;
+
+    Integrate(deltaTime);
+    BuildGrid();
+
+    // Terrain is looked up per particle; other bodies only if they reach the particles
+    terrains.clear();
+    colliders.clear();
+    for(RigidBody* body : bodies){
+        if(!body->collider || !body->collider->shape || body->collider->isSensor) continue;
+        const Shape* shape = body->collider->shape;
+        if(shape->IsTerrain()){
+            terrains.push_back(body);
+            continue;
+        }
+        float reach = BodyReach(shape);
+        if(body->position.x + reach >= boundsMin.x && body->position.x - reach <= boundsMax.x &&
+           body->position.y + reach >= boundsMin.y && body->position.y - reach <= boundsMax.y)
+            colliders.push_back(body);
+    }
+    if(bodyDeltas.size() < colliders.size())
+        bodyDeltas.resize(colliders.size());
+    // Query rebuilds a grid's rectangles when edited; do it before the jobs share the grid
+    for(RigidBody* terrain : terrains){
+        if(terrain->collider->shape->GetType() == ShapeType::TileGrid)
+            static_cast<TileGridShape*>(terrain->collider->shape)->GetRects();
+    }
+
+    const int n = GetCount();
+    const int stripCount = static_cast<int>(stripStart.size()) - 1;
+    for(int it = 0; it < iterations; it++){
+        // Even strips, then odd ones
+        for(int parity = 0; parity < 2; parity++){
+            ParallelFor((stripCount - parity + 1) / 2, 1, [&](int begin, int end){
+                for(int k = begin; k < end; k++)
+                    SolveStrip(2 * k + parity);
+            });
+        }
+
+        if(!terrains.empty()){
+            ParallelFor(n, ParticleGrainSize, [&](int begin, int end){
+                std::vector<int> rects;
+                for(RigidBody* terrain : terrains){
+                    if(terrain->collider->shape->GetType() == ShapeType::TileGrid)
+                        SolveTileGridContacts(*terrain, begin, end, rects);
+                    else
+                        SolveHeightfieldContacts(*terrain, begin, end);
+                }
+            });
+        }
+
+        // Each body is only touched by its own job; the particles it pushes
+        // are corrected afterwards, in body order
+        int colliderCount = static_cast<int>(colliders.size());
+        ParallelFor(colliderCount, 1, [&](int begin, int end){
+            for(int b = begin; b < end; b++)
+                SolveBodyContacts(*colliders[b], bodyDeltas[b]);
+        });
+        for(int b = 0; b < colliderCount; b++){
+            for(const ParticleDelta& delta : bodyDeltas[b]){
+                posX[delta.particle] += delta.position.x;
+                posY[delta.particle] += delta.position.y;
+                velX[delta.particle] += delta.velocity.x;
+                velY[delta.particle] += delta.velocity.y;
+            }
+        }
+    }
+}
+
+void ParticleSystem::Integrate(float deltaTime){
+    const float gx = gravity.x * deltaTime;
+    const float gy = gravity.y * deltaTime;
+
+    float* px = posX.data();
+    float* py = posY.data();
+    float* vx = velX.data();
+    float* vy = velY.data();
+
+    // Plain loops over the arrays; the compiler vectorizes these
+    ParallelFor(GetCount(), ParticleGrainSize, [&](int begin, int end){
+        for(int i = begin; i < end; i++){
+            vx[i] = (vx[i] + gx) * damping;
+            vy[i] = (vy[i] + gy) * damping;
+            px[i] += vx[i] * deltaTime;
+            py[i] += vy[i] * deltaTime;
+        }
+    });
+}
+
+// Counting-sort particles by grid bucket and reorder the arrays to match, then
+// split them into strips for the particle pass
+void ParticleSystem::BuildGrid(){
+    const int n = GetCount();
+
+    float maxRadius = *std::max_element(radius.begin(), radius.end());
+    inverseCell = 1.0f / std::max(cellSize, 2.0f * maxRadius);
+
+    cellX.resize(n);
+    cellY.resize(n);
+    boundsMin = Vector2(posX[0], posY[0]);
+    boundsMax = boundsMin;
+    for(int i = 0; i < n; i++){
+        cellX[i] = CellCoord(posX[i]);
+        cellY[i] = CellCoord(posY[i]);
+        boundsMin = Vector2(std::min(boundsMin.x, posX[i]), std::min(boundsMin.y, posY[i]));
+        boundsMax = Vector2(std::max(boundsMax.x, posX[i]), std::max(boundsMax.y, posY[i]));
+    }
+
+    // A dense grid over the particles when they're packed enough: no cells share
+    // a bucket, and the buckets run along the strips (in rows if the particles
+    // are taller than wide, in columns otherwise), so a strip's particles are
+    // together in memory. Otherwise hash the cells into a table twice the
+    // particle count
+    gridMinX = CellCoord(boundsMin.x);
+    gridMinY = CellCoord(boundsMin.y);
+    long long width = static_cast<long long>(CellCoord(boundsMax.x)) - gridMinX + 1;
+    long long height = static_cast<long long>(CellCoord(boundsMax.y)) - gridMinY + 1;
+    if(width * height <= static_cast<long long>(n) * MaxCellsPerParticle){
+        gridWidth = static_cast<uint32_t>(width);
+        gridHeight = static_cast<uint32_t>(height);
+        bucketCount = gridWidth * gridHeight;
+        gridStrideX = width >= height ? gridHeight : 1;
+        gridStrideY = width >= height ? 1 : gridWidth;
+    } else {
+        gridWidth = 0;
+        bucketCount = 64;
+        while(bucketCount < static_cast<uint32_t>(n) * 2) bucketCount <<= 1;
+    }
+    boundsMin -= Vector2(maxRadius, maxRadius);
+    boundsMax += Vector2(maxRadius, maxRadius);
+
+    // One more, always empty, bucket for cells off the dense grid
+    bucketStart.assign(bucketCount + 2, 0);
+    particleBucket.resize(n);
+    for(int i = 0; i < n; i++){
+        uint32_t b = Bucket(cellX[i], cellY[i]);
+        particleBucket[i] = b;
+        bucketStart[b + 1]++;
+    }
+    for(uint32_t b = 0; b <= bucketCount; b++)
+        bucketStart[b + 1] += bucketStart[b];
+
+    bucketCursor.assign(bucketStart.begin(), bucketStart.end() - 1);
+    order.resize(n);
+    for(int i = 0; i < n; i++)
+        order[bucketCursor[particleBucket[i]]++] = static_cast<uint32_t>(i);
+
+    // Group a bucket shared by several cells by cell, keeping index order.
+    // Buckets are short, so an insertion sort
+    auto cellBefore = [&](uint32_t a, uint32_t c){
+        return cellY[a] != cellY[c] ? cellY[a] < cellY[c] : cellX[a] < cellX[c];
+    };
+    for(uint32_t b = 0; b < bucketCount && !gridWidth; b++){
+        for(uint32_t k = bucketStart[b] + 1; k < bucketStart[b + 1]; k++){
+            uint32_t particle = order[k];
+            uint32_t at = k;
+            for(; at > bucketStart[b] && cellBefore(particle, order[at - 1]); at--)
+                order[at] = order[at - 1];
+            order[at] = particle;
+        }
+    }
+
+    scratch.resize(n);
+    for(std::vector<float>* array : {&posX, &posY, &velX, &velY, &radius, &inverseMass}){
+        const float* from = array->data();
+        ParallelFor(n, ParticleGrainSize, [&](int begin, int end){
+            for(int k = begin; k < end; k++)
+                scratch[k] = from[order[k]];
+        });
+        array->swap(scratch);
+    }
+    scratchMaterial.resize(n);
+    for(int k = 0; k < n; k++)
+        scratchMaterial[k] = material[order[k]];
+    material.swap(scratchMaterial);
+
+    scratchCell.resize(n);
+    for(std::vector<int>* array : {&cellX, &cellY}){
+        for(int k = 0; k < n; k++)
+            scratchCell[k] = (*array)[order[k]];
+        array->swap(scratchCell);
+    }
+
+    // Strips run across the longer side of the particle bounds
+    const std::vector<int>& along = gridWidth ? (gridStrideY == 1 ? cellX : cellY) :
+                                    (boundsMax.x - boundsMin.x >= boundsMax.y - boundsMin.y ? cellX : cellY);
+    int minCell = *std::min_element(along.begin(), along.end());
+    int maxCell = *std::max_element(along.begin(), along.end());
+    int stripCells = std::max(MinStripCells, (maxCell - minCell) / MaxStripCount + 1);
+    int stripCount = (maxCell - minCell) / stripCells + 1;
+
+    stripStart.assign(stripCount + 1, 0);
+    for(int k = 0; k < n; k++)
+        stripStart[(along[k] - minCell) / stripCells + 1]++;
+    for(int s = 0; s < stripCount; s++)
+        stripStart[s + 1] += stripStart[s];
+    bucketCursor.assign(stripStart.begin(), stripStart.end() - 1);
+    stripParticles.resize(n);
+    for(int k = 0; k < n; k++)
+        stripParticles[bucketCursor[(along[k] - minCell) / stripCells]++] = static_cast<uint32_t>(k);
+}
+
+// The particles of one cell: its bucket on the dense grid, else its run within
+// its bucket, which may hold other cells too
+void ParticleSystem::CellRange(int x, int y, int& begin, int& end) const {
+    uint32_t b = Bucket(x, y);
+    begin = static_cast<int>(bucketStart[b]);
+    end = static_cast<int>(bucketStart[b + 1]);
+    if(gridWidth) return;
+    while(begin < end && (cellX[begin] != x || cellY[begin] != y)) begin++;
+    int last = begin;
+    while(last < end && cellX[last] == x && cellY[last] == y) last++;
+    end = last;
+}
+
+// Particles of one strip against their neighbours, in index order, each pair
+// once (from its lower index). The particles a strip can reach are at most one
+// cell outside it, so strips two apart never touch the same particle
+void ParticleSystem::SolveStrip(int strip){
+    for(uint32_t k = stripStart[strip]; k < stripStart[strip + 1]; k++){
+        int i = static_cast<int>(stripParticles[k]);
+        int cx = cellX[i];
+        int cy = cellY[i];
+
+        for(int dy = -1; dy <= 1; dy++){
+            for(int dx = -1; dx <= 1; dx++){
+                int j, runEnd;
+                CellRange(cx + dx, cy + dy, j, runEnd);
+                j = std::max(j, i + 1);
+
+                // Test FloatN::Width candidates at once; only overlapping lanes are resolved
+                for(; j + FloatN::Width <= runEnd; j += FloatN::Width){
+                    Vector2xN delta = Vector2xN::Load(&posX[j], &posY[j]) - Vector2xN(posX[i], posY[i]);
+                    FloatN rs = FloatN::Load(&radius[j]) + FloatN(radius[i]);
+                    int mask = (delta.dot(delta) < rs * rs).Bits();
+                    while(mask){
+                        int lane = 0;
+                        while(!(mask & (1 << lane))) lane++;
+                        ResolvePair(i, j + lane);
+                        mask &= mask - 1;
+                    }
+                }
+                for(; j < runEnd; j++){
+                    float ddx = posX[j] - posX[i];
+                    float ddy = posY[j] - posY[i];
+                    float rs = radius[i] + radius[j];
+                    if(ddx * ddx + ddy * ddy < rs * rs)
+                        ResolvePair(i, j);
+                }
+            }
+        }
+    }
+}
+
+void ParticleSystem::ResolvePair(int i, int j){
+    float dx = posX[j] - posX[i];
+    float dy = posY[j] - posY[i];
+    float distSq = dx * dx + dy * dy;
+    float rs = radius[i] + radius[j];
+    if(distSq >= rs * rs) return; // Moved apart by an earlier contact
+
+    float wi = inverseMass[i];
+    float wj = inverseMass[j];
+    float wSum = wi + wj;
+    if(wSum == 0.0f) return;
+
+    float dist = std::sqrt(distSq);
+    float nx = 1.0f, ny = 0.0f;
+    if(dist > 1e-6f){
+        nx = dx / dist;
+        ny = dy / dist;
+    }
+
+    // Push apart in proportion to inverse mass
+    float correction = (rs - dist) / wSum;
+    posX[i] -= nx * correction * wi;
+    posY[i] -= ny * correction * wi;
+    posX[j] += nx * correction * wj;
+    posY[j] += ny * correction * wj;
+
+    float rvx = velX[j] - velX[i];
+    float rvy = velY[j] - velY[i];
+    float velAlongNormal = rvx * nx + rvy * ny;
+    if(velAlongNormal >= 0.0f) return;
+
+    const ParticleMaterial& mi = materials[material[i]];
+    const ParticleMaterial& mj = materials[material[j]];
+    float restitution = 0.5f * (mi.restitution + mj.restitution);
+    float impulse = -(1.0f + restitution) * velAlongNormal / wSum;
+
+    // Coulomb friction on the tangential part
+    float tx = rvx - velAlongNormal * nx;
+    float ty = rvy - velAlongNormal * ny;
+    float tangentLen = std::sqrt(tx * tx + ty * ty);
+    float frictionX = 0.0f, frictionY = 0.0f;
+    if(tangentLen > 1e-6f){
+        float mu = 0.5f * (mi.friction + mj.friction);
+        float jt = std::min(tangentLen / wSum, mu * impulse);
+        frictionX = -tx / tangentLen * jt;
+        frictionY = -ty / tangentLen * jt;
+    }
+
+    float ix = nx * impulse + frictionX;
+    float iy = ny * impulse + frictionY;
+    velX[i] -= ix * wi;
+    velY[i] -= iy * wi;
+    velX[j] += ix * wj;
+    velY[j] += iy * wj;
+}
+
+// Particles under one body, read from the arrays as they were before the
+// body pass; the body is updated in place and the particles' corrections
+// collected in deltas
+void ParticleSystem::SolveBodyContacts(RigidBody& body, std::vector<ParticleDelta>& deltas){
+    deltas.clear();
+    const Shape* shape = body.collider->shape;
+    const float cosA = std::cos(body.orientation);
+    const float sinA = std::sin(body.orientation);
+
+    Vector2 extent;
+    float bodyRadius = 0.0f;
+    Vector2 halfsize;
+    bool isCircle = shape->GetType() == ShapeType::Circle;
+    const PolygonShape* polygon = shape->GetType() == ShapeType::Polygon ? static_cast<const PolygonShape*>(shape) : nullptr;
+    if(isCircle){
+        bodyRadius = static_cast<const CircleShape*>(shape)->radius;
+        extent = Vector2(bodyRadius, bodyRadius);
+    } else if(polygon){
+        extent = Vector2(polygon->radius, polygon->radius);
+    } else {
+        halfsize = static_cast<const AABBShape*>(shape)->halfsize;
+        extent = Vector2(std::abs(cosA) * halfsize.x + std::abs(sinA) * halfsize.y,
+                         std::abs(sinA) * halfsize.x + std::abs(cosA) * halfsize.y);
+    }
+
+    // One extra cell on each side covers the particle radius (cells are >= 2 radii)
+    int minX = CellCoord(body.position.x - extent.x) - 1;
+    int maxX = CellCoord(body.position.x + extent.x) + 1;
+    int minY = CellCoord(body.position.y - extent.y) - 1;
+    int maxY = CellCoord(body.position.y + extent.y) + 1;
+
+    auto testParticle = [&](int i){
+        Vector2 p(posX[i], posY[i]);
+        float r = radius[i];
+        Vector2 position = p, velocity(velX[i], velY[i]);
+
+        if(isCircle){
+            Vector2 d = p - body.position;
+            float rs = r + bodyRadius;
+            float distSq = d.lengthSquared();
+            if(distSq >= rs * rs) return;
+            float dist = std::sqrt(distSq);
+            Vector2 n = dist > 1e-6f ? d / dist : Vector2(0.0f, -1.0f);
+            ResolveBodyContact(position, velocity, i, body, n, rs - dist, body.position + n * bodyRadius);
+        } else {
+            // Particle centre in body space
+            Vector2 d = p - body.position;
+            Vector2 local(d.x * cosA + d.y * sinA, -d.x * sinA + d.y * cosA);
+            if(polygon){
+                Vector2 localNormal, localPoint;
+                float penetration;
+                if(!Collision::PolygonvsCircleLocal(*polygon, local, r, 0.0f, localNormal, localPoint, penetration) ||
+                   penetration <= 0.0f)
+                    return;
+                Vector2 n(localNormal.x * cosA - localNormal.y * sinA, localNormal.x * sinA + localNormal.y * cosA);
+                Vector2 closest(body.position.x + localPoint.x * cosA - localPoint.y * sinA,
+                                body.position.y + localPoint.x * sinA + localPoint.y * cosA);
+                ResolveBodyContact(position, velocity, i, body, n, penetration, closest);
+            } else {
+                if(std::abs(local.x) >= halfsize.x + r || std::abs(local.y) >= halfsize.y + r) return;
+
+                // Work in box space: world-space differences lose precision far from the origin
+                Vector2 clamped(Clamp(local.x, -halfsize.x, halfsize.x), Clamp(local.y, -halfsize.y, halfsize.y));
+                Vector2 diff = local - clamped;
+                float distSq = diff.lengthSquared();
+
+                if(distSq > 0.0f){
+                    if(distSq >= r * r) return;
+                    float dist = std::sqrt(distSq);
+                    Vector2 localNormal = diff / dist;
+                    Vector2 n(localNormal.x * cosA - localNormal.y * sinA, localNormal.x * sinA + localNormal.y * cosA);
+                    Vector2 closest(body.position.x + clamped.x * cosA - clamped.y * sinA,
+                                    body.position.y + clamped.x * sinA + clamped.y * cosA);
+                    ResolveBodyContact(position, velocity, i, body, n, r - dist, closest);
+                } else {
+                    // Centre inside the box: push out through the nearest face
+                    float penX = halfsize.x - std::abs(local.x);
+                    float penY = halfsize.y - std::abs(local.y);
+                    Vector2 localNormal = penX < penY ? Vector2(local.x < 0.0f ? -1.0f : 1.0f, 0.0f)
+                                                      : Vector2(0.0f, local.y < 0.0f ? -1.0f : 1.0f);
+                    Vector2 n(localNormal.x * cosA - localNormal.y * sinA, localNormal.x * sinA + localNormal.y * cosA);
+                    ResolveBodyContact(position, velocity, i, body, n, r + std::min(penX, penY), p);
+                }
+            }
+        }
+        deltas.push_back({i, position - p, velocity - Vector2(velX[i], velY[i])});
+    };
+
+    // Only the dense grid's cells hold particles
+    if(gridWidth){
+        minX = std::max(minX, gridMinX);
+        minY = std::max(minY, gridMinY);
+        maxX = std::min(maxX, gridMinX + static_cast<int>(gridWidth) - 1);
+        maxY = std::min(maxY, gridMinY + static_cast<int>(gridHeight) - 1);
+    }
+
+    // Bodies larger than the whole table are cheaper to test against every particle
+    long long cellCount = static_cast<long long>(maxX - minX + 1) * (maxY - minY + 1);
+    if(cellCount > static_cast<long long>(bucketCount)){
+        for(int i = 0; i < GetCount(); i++)
+            testParticle(i);
+        return;
+    }
+
+    // Cell by cell in scan order: the order the body takes its impulses in matters
+    for(int cy = minY; cy <= maxY; cy++){
+        for(int cx = minX; cx <= maxX; cx++){
+            int begin, end;
+            CellRange(cx, cy, begin, end);
+            for(int i = begin; i < end; i++)
+                testParticle(i);
+        }
+    }
+}
+
+// Terrain is far larger than a particle, so each particle looks up the
+// rectangles under it instead of the body scanning the grid. Terrain is
+// static, so only the particles [begin, end) change
+void ParticleSystem::SolveTileGridContacts(RigidBody& terrain, int begin, int end, std::vector<int>& rects){
+    TileGridShape& grid = *static_cast<TileGridShape*>(terrain.collider->shape);
+    const Vector2 origin = terrain.position;
+    const float tile = grid.GetTileSize();
+
+    // Clamped before the cast so far particles can't overflow it
+    auto cell = [](float v, int count){ return static_cast<int>(std::floor(std::max(-1.0f, std::min(v, static_cast<float>(count))))); };
+    auto solidAt = [&](const Vector2& p){
+        Vector2 local = p - origin;
+        return grid.IsSolid(static_cast<int>(std::floor(local.x / tile)), static_cast<int>(std::floor(local.y / tile)));
+    };
+
+    for(int i = begin; i < end; i++){
+        float r = radius[i];
+        Vector2 local(posX[i] - origin.x, posY[i] - origin.y);
+        grid.Query(cell((local.x - r) / tile, grid.GetColumns()), cell((local.y - r) / tile, grid.GetRows()),
+                   cell((local.x + r) / tile, grid.GetColumns()), cell((local.y + r) / tile, grid.GetRows()), rects);
+        if(rects.empty()) continue;
+
+        Vector2 position(posX[i], posY[i]), velocity(velX[i], velY[i]);
+        const std::vector<TileGridShape::Rect>& all = grid.GetRects();
+        for(int k : rects){
+            const TileGridShape::Rect& rect = all[k];
+            Vector2 min = origin + Vector2(rect.column * tile, rect.row * tile);
+            Vector2 max = min + Vector2(rect.columns * tile, rect.rows * tile);
+
+            // The previous rectangle may have moved the particle
+            Vector2 p = position;
+            Vector2 closest(Clamp(p.x, min.x, max.x), Clamp(p.y, min.y, max.y));
+            Vector2 diff = p - closest;
+            float distSq = diff.lengthSquared();
+            if(distSq > 0.0f){
+                if(distSq >= r * r) continue;
+                float dist = std::sqrt(distSq);
+                ResolveBodyContact(position, velocity, i, terrain, diff / dist, r - dist, closest);
+                continue;
+            }
+
+            // Centre inside: out through the nearest face that isn't shared with another tile
+            const Vector2 normals[4] = { Vector2(-1, 0), Vector2(1, 0), Vector2(0, -1), Vector2(0, 1) };
+            const float depths[4] = { p.x - min.x, max.x - p.x, p.y - min.y, max.y - p.y };
+            int best = -1;
+            for(int f = 0; f < 4; f++){
+                Vector2 face = p + normals[f] * depths[f];
+                if((best < 0 || depths[f] < depths[best]) && !solidAt(face + normals[f] * (0.5f * tile)))
+                    best = f;
+            }
+            if(best >= 0)
+                ResolveBodyContact(position, velocity, i, terrain, normals[best], r + depths[best], p + normals[best] * depths[best]);
+        }
+        posX[i] = position.x;
+        posY[i] = position.y;
+        velX[i] = velocity.x;
+        velY[i] = velocity.y;
+    }
+}
+
+void ParticleSystem::SolveHeightfieldContacts(RigidBody& terrain, int begin, int end){
+    const HeightfieldShape& field = *static_cast<const HeightfieldShape*>(terrain.collider->shape);
+    const Vector2 origin = terrain.position;
+    const float spacing = field.spacing;
+    const int segments = field.GetSegmentCount();
+    if(segments == 0) return;
+
+    auto vertex = [&](int k){ return origin + Vector2(k * spacing, field.heights[k]); };
+    auto segmentNormal = [&](int k){
+        Vector2 edge = vertex(k + 1) - vertex(k);
+        return Vector2(edge.y, -edge.x).normalize();
+    };
+
+    for(int i = begin; i < end; i++){
+        float r = radius[i];
+        float x = (posX[i] - origin.x) / spacing;
+        float left = x - r / spacing;
+        float right = x + r / spacing;
+        if(right < 0.0f || left >= segments) continue;
+
+        Vector2 position(posX[i], posY[i]), velocity(velX[i], velY[i]);
+        bool below = false;
+
+        // Centre below the segment straight under it: up out of that one
+        // alone, which also covers the valleys between two segments
+        if(x >= 0.0f && x < segments){
+            int s = static_cast<int>(x);
+            Vector2 n = segmentNormal(s);
+            float side = (position - vertex(s)).dot(n);
+            if(side < 0.0f){
+                ResolveBodyContact(position, velocity, i, terrain, n, r - side, position - n * side);
+                below = true;
+            }
+        }
+
+        // Above the surface: against the nearest point of each segment in reach
+        int first = std::max(static_cast<int>(std::floor(left)), 0);
+        int last = std::min(static_cast<int>(std::floor(right)), segments - 1);
+        for(int s = first; s <= last && !below; s++){
+            Vector2 p0 = vertex(s);
+            Vector2 edge = vertex(s + 1) - p0;
+            float length = edge.length();
+            Vector2 t = edge / length;
+
+            Vector2 p = position;
+            float clamped = Clamp((p - p0).dot(t), 0.0f, length);
+            // A shared vertex belongs to the segment that ends there
+            if(clamped == 0.0f && s > first) continue;
+            Vector2 closest = p0 + t * clamped;
+            Vector2 diff = p - closest;
+            float distSq = diff.lengthSquared();
+            if(distSq >= r * r) continue;
+            float dist = std::sqrt(distSq);
+            ResolveBodyContact(position, velocity, i, terrain, dist > 1e-6f ? diff / dist : segmentNormal(s), r - dist, closest);
+        }
+        posX[i] = position.x;
+        posY[i] = position.y;
+        velX[i] = velocity.x;
+        velY[i] = velocity.y;
+    }
+}
+
+// normal points from the body towards the particle. Particle i is read from
+// and written to position and velocity. A sleeping body acts as static unless
+// the hit would change its velocity by more than the sleep threshold, and only
+// such hits wake it or restart its sleep timer
+void ParticleSystem::ResolveBodyContact(Vector2& position, Vector2& velocity, int i, RigidBody& body,
+                                        const Vector2& normal, float penetration, const Vector2& contact) const
+{
+    float wp = inverseMass[i];
+    float wb = body.inverseMass;
+    float wi = body.inverseInertia;
+    if(wp + wb == 0.0f) return;
+
+    const ParticleMaterial& mat = materials[material[i]];
+    Vector2 r = contact - body.position;
+    Vector2 bodyVelocity = body.velocity + Vector2(-body.angularVelocity * r.y, body.angularVelocity * r.x);
+    Vector2 rv = velocity - bodyVelocity;
+    float velAlongNormal = rv.dot(normal);
+
+    // Normal impulse, and whether it's enough to count as a real hit on the body
+    float rn = r.cross(normal);
+    float restitution = 0.5f * (mat.restitution + body.collider->restitution);
+    float j = velAlongNormal < 0.0f ? -(1.0f + restitution) * velAlongNormal / (wp + wb + rn * rn * wi) : 0.0f;
+    bool strong = wb > 0.0f && (j * wb >= Config::SleepVelocityThreshold ||
+                                std::abs(rn * j * wi) >= Config::SleepVelocityThreshold);
+    if(body.isSleeping && !strong){
+        wb = 0.0f;
+        wi = 0.0f;
+        if(wp == 0.0f) return;
+        j = velAlongNormal < 0.0f ? -(1.0f + restitution) * velAlongNormal / wp : 0.0f;
+    }
+
+    float correction = penetration / (wp + wb);
+    position += normal * (correction * wp);
+    body.position -= normal * (correction * wb);
+    if(velAlongNormal >= 0.0f) return;
+
+    Vector2 impulse = normal * j;
+    Vector2 tangent = rv - normal * velAlongNormal;
+    float tangentLen = tangent.length();
+    if(tangentLen > 1e-6f){
+        tangent /= tangentLen;
+        float rt = r.cross(tangent);
+        float mu = std::sqrt(mat.friction * body.collider->dynamicFriction);
+        float jt = std::min(tangentLen / (wp + wb + rt * rt * wi), mu * j);
+        impulse -= tangent * jt;
+    }
+
+    velocity += impulse * wp;
+
+    if(wb > 0.0f){
+        body.velocity -= impulse * wb;
+        body.angularVelocity -= r.cross(impulse) * wi;
+        if(strong){
+            body.isSleeping = false;
+            body.sleepTime = 0.0f;
+        }
+    }
+}
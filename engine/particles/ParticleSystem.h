@@ -0,0 +1,142 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "../math/Vector2.h"
+#include "../core/JobSystem.h"
+
+class RigidBody;
+
+struct ParticleMaterial{
+    float density = 0.005f;   // Mass per square pixel
+    float restitution = 0.3f;
+    float friction = 0.1f;
+};
+
+// Lightweight round particles without rotation, stored as parallel arrays.
+// Each step particles are bucketed into a uniform grid (dense over the
+// particles, or hashed when they're spread out) and sorted by bucket, so neighbours are contiguous in memory and the circle tests run
+// several particles at a time. Particles also collide with rigid bodies and
+// terrain, but they don't appear in the world's body list.
+//
+// Each iteration resolves particle pairs in place, strip by strip: the grid is
+// cut into strips two cells wide, and the even strips run in parallel, then
+// the odd ones. Then particles are resolved against terrain, and each body
+// collects its particle contacts, which are applied in body order. Every pass
+// gives the same result for any number of threads.
+//
+// Particle indices are not stable: the arrays are re-sorted every step.
+class ParticleSystem{
+    public:
+        // cellSize 0 sizes grid cells to the largest particle diameter
+        explicit ParticleSystem(float cellSize = 0.0f) : cellSize(cellSize) {
+            materials.push_back(ParticleMaterial());
+        }
+
+        int AddMaterial(const ParticleMaterial& material);
+        void Reserve(int count);
+        void Spawn(const Vector2& position, const Vector2& velocity, float radius, int material = 0);
+        void Clear();
+
+        // Not owned; null runs everything on the calling thread
+        void SetJobSystem(JobSystem* jobs) { this->jobs = jobs; }
+
+        void Step(float deltaTime, const std::vector<RigidBody*>& bodies);
+
+        // Particles push rigid bodies, so rollback has to save and restore
+        // them along with the bodies
+        struct State{
+            std::vector<float> posX, posY, velX, velY, radius, inverseMass;
+            std::vector<uint16_t> material;
+        };
+        void SaveState(State& state) const;
+        void RestoreState(const State& state);
+
+        int GetCount() const { return static_cast<int>(posX.size()); }
+        Vector2 GetPosition(int index) const { return Vector2(posX[index], posY[index]); }
+        Vector2 GetVelocity(int index) const { return Vector2(velX[index], velY[index]); }
+        float GetRadius(int index) const { return radius[index]; }
+
+        Vector2 gravity;
+        float damping = 0.995f;
+        int iterations = 2;
+
+    private:
+        // A body's correction to one particle, applied after every body has run
+        struct ParticleDelta{
+            int particle;
+            Vector2 position, velocity;
+        };
+
+        void Integrate(float deltaTime);
+        void BuildGrid();
+        void CellRange(int x, int y, int& begin, int& end) const;
+        void SolveStrip(int strip);
+        void SolveBodyContacts(RigidBody& body, std::vector<ParticleDelta>& deltas);
+        void SolveTileGridContacts(RigidBody& terrain, int begin, int end, std::vector<int>& rects);
+        void SolveHeightfieldContacts(RigidBody& terrain, int begin, int end);
+        void ResolvePair(int i, int j);
+        void ResolveBodyContact(Vector2& position, Vector2& velocity, int i, RigidBody& body,
+                                const Vector2& normal, float penetration, const Vector2& contact) const;
+
+        template<typename Body>
+        void ParallelFor(int count, int grainSize, const Body& body){
+            if(jobs)
+                jobs->ParallelFor(count, grainSize, body);
+            else if(count > 0)
+                body(0, count);
+        }
+
+        static constexpr int ParticleGrainSize = 1024;
+        static constexpr int MinStripCells = 2;     // Strips two apart must share no neighbour cell
+        static constexpr int MaxStripCount = 4096;
+        static constexpr int MaxCellsPerParticle = 8;   // Densest grid worth laying out in full
+
+        uint32_t Bucket(int cellX, int cellY) const {
+            if(gridWidth){
+                uint32_t x = static_cast<uint32_t>(cellX) - static_cast<uint32_t>(gridMinX);
+                uint32_t y = static_cast<uint32_t>(cellY) - static_cast<uint32_t>(gridMinY);
+                return x < gridWidth && y < gridHeight ? x * gridStrideX + y * gridStrideY : bucketCount;
+            }
+            uint32_t h = static_cast<uint32_t>(cellX) * 73856093u ^ static_cast<uint32_t>(cellY) * 19349663u;
+            return h & (bucketCount - 1);
+        }
+        int CellCoord(float value) const { return static_cast<int>(std::floor(value * inverseCell)); }
+
+        JobSystem* jobs = nullptr;
+        float cellSize;
+        float inverseCell = 0.0f;
+        std::vector<ParticleMaterial> materials;
+
+        // Particle data (structure of arrays)
+        std::vector<float> posX, posY;
+        std::vector<float> velX, velY;
+        std::vector<float> radius;
+        std::vector<float> inverseMass;
+        std::vector<uint16_t> material;
+
+        // Particles of bucket b are [bucketStart[b], bucketStart[b+1]), grouped by
+        // cell when several cells share a bucket. gridWidth 0 hashes the cells
+        uint32_t bucketCount = 0;
+        uint32_t gridWidth = 0, gridHeight = 0;
+        uint32_t gridStrideX = 0, gridStrideY = 0;
+        int gridMinX = 0, gridMinY = 0;
+        std::vector<uint32_t> bucketStart;
+        std::vector<uint32_t> bucketCursor;
+        std::vector<uint32_t> particleBucket;
+        std::vector<uint32_t> order;
+        std::vector<int> cellX, cellY;   // Each particle's cell when the grid was built
+        std::vector<float> scratch;
+        std::vector<uint16_t> scratchMaterial;
+        std::vector<int> scratchCell;
+        Vector2 boundsMin, boundsMax;   // Of every particle, from BuildGrid
+
+        // Particles of strip s are stripParticles[stripStart[s] .. stripStart[s+1])
+        std::vector<uint32_t> stripStart;
+        std::vector<uint32_t> stripParticles;
+
+        // Colliders near the particles this step, and each body's corrections
+        std::vector<RigidBody*> terrains;
+        std::vector<RigidBody*> colliders;
+        std::vector<std::vector<ParticleDelta>> bodyDeltas;
+};
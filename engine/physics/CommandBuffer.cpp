@@ -0,0 +1,82 @@
+#include "CommandBuffer.h"
+
+CommandBuffer::~CommandBuffer(){
+    for(std::atomic<Node*>& block : blocks)
+        delete[] block.load(std::memory_order_relaxed);
+}
+
+CommandBuffer::Node* CommandBuffer::Allocate(){
+    size_t slot = allocated.fetch_add(1, std::memory_order_acquire);
+
+    // Slot to block and offset: block b starts at FirstBlockSize * (2^b - 1)
+    size_t scaled = slot / FirstBlockSize + 1;
+    int block = 0;
+    while(scaled >> (block + 1)) block++;
+    size_t offset = slot - FirstBlockSize * ((size_t(1) << block) - 1);
+
+    Node* nodes = blocks[block].load(std::memory_order_acquire);
+    if(!nodes){
+        // First use of this block: whoever loses the race frees its copy
+        Node* fresh = new Node[FirstBlockSize << block];
+        if(blocks[block].compare_exchange_strong(nodes, fresh, std::memory_order_acq_rel))
+            nodes = fresh;
+        else
+            delete[] fresh;
+    }
+    return &nodes[offset];
+}
+
+void CommandBuffer::Push(const WorldCommand& command){
+    Node* node = Allocate();
+    node->command = command;
+    node->next = head.load(std::memory_order_relaxed);
+
+    // Only the consumer ever removes nodes, and it takes the whole list at once,
+    // so a plain CAS push is ABA-safe here
+    while(!head.compare_exchange_weak(node->next, node,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed)){
+    }
+}
+
+void CommandBuffer::AddBody(RigidBody* body){
+    Push({WorldCommandType::AddBody, body, Vector2()});
+}
+
+void CommandBuffer::RemoveBody(RigidBody* body){
+    Push({WorldCommandType::RemoveBody, body, Vector2()});
+}
+
+void CommandBuffer::SetVelocity(RigidBody* body, const Vector2& velocity, float angularVelocity){
+    Push({WorldCommandType::SetVelocity, body, velocity, angularVelocity});
+}
+
+void CommandBuffer::ApplyImpulse(RigidBody* body, const Vector2& impulse){
+    Push({WorldCommandType::ApplyImpulse, body, impulse});
+}
+
+void CommandBuffer::Drain(std::vector<WorldCommand>& out){
+    Node* node = head.exchange(nullptr, std::memory_order_acquire);
+    if(!node) return;
+
+    // The stack holds newest first; reverse it to replay in submission order
+    Node* reversed = nullptr;
+    while(node){
+        Node* next = node->next;
+        node->next = reversed;
+        reversed = node;
+        node = next;
+    }
+
+    while(reversed){
+        out.push_back(reversed->command);
+        reversed = reversed->next;
+        drained++;
+    }
+
+    // Rewind only if no producer took a slot that hasn't been drained yet;
+    // one that is still pushing keeps the pool growing until the next Drain
+    size_t expected = drained;
+    if(allocated.compare_exchange_strong(expected, 0, std::memory_order_acq_rel))
+        drained = 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include "../math/Vector2.h"
+
+class RigidBody;
+
+enum class WorldCommandType {
+    AddBody,
+    RemoveBody,
+    SetVelocity,
+    ApplyImpulse
+};
+
+struct WorldCommand{
+    WorldCommandType type;
+    RigidBody* body;
+    Vector2 value;        // Velocity or impulse
+    float angular = 0.0f; // Angular velocity for SetVelocity
+};
+
+// Deferred world mutations that can be recorded from any thread.
+// Producers push without locks (Treiber stack); the world drains the whole
+// batch at the start of Step, in submission order per producer. Add and
+// remove commands apply as if each ran in turn: adding a body that is already
+// in the world, or removing one that isn't, does nothing.
+//
+// Nodes come from blocks that are allocated once and reused: a push takes the
+// next slot with one atomic increment, and Drain rewinds to the first slot
+// once every slot handed out has been drained.
+class CommandBuffer{
+    public:
+        CommandBuffer() = default;
+        CommandBuffer(const CommandBuffer&) = delete;
+        CommandBuffer& operator=(const CommandBuffer&) = delete;
+        ~CommandBuffer();
+
+        void AddBody(RigidBody* body);
+        void RemoveBody(RigidBody* body);
+        void SetVelocity(RigidBody* body, const Vector2& velocity, float angularVelocity = 0.0f);
+        void ApplyImpulse(RigidBody* body, const Vector2& impulse);
+
+        // Consumer side: appends every pending command to out, oldest first
+        void Drain(std::vector<WorldCommand>& out);
+        bool IsEmpty() const { return head.load(std::memory_order_acquire) == nullptr; }
+
+    private:
+        struct Node{
+            WorldCommand command;
+            Node* next;
+        };
+
+        // Block b holds FirstBlockSize << b nodes, so MaxBlocks covers any batch
+        static constexpr size_t FirstBlockSize = 256;
+        static constexpr int MaxBlocks = 40;
+
+        Node* Allocate();
+        void Push(const WorldCommand& command);
+
+        std::atomic<Node*> head{nullptr};
+        std::atomic<Node*> blocks[MaxBlocks] = {};
+        std::atomic<size_t> allocated{0};   // Slots handed out since the last rewind
+        size_t drained = 0;                  // Of those, slots the consumer has drained
+};
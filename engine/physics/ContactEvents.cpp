@@ -0,0 +1,110 @@
+#include "ContactEvents.h"
+#include "RigidBody.h"
+#include <algorithm>
+
+void ContactEventStream::Record(const Contact& contact, float impulse, bool sensor){
+    const CollisionManifold& m = contact.manifold;
+    if(m.contactCount == 0) return;
+    // Speculative and margin contacts only count once the solver had to push
+    if(m.penetration < 0.0f && impulse <= 0.0f) return;
+
+    int deepest = 0;
+    for(int k = 1; k < m.contactCount; k++){
+        if(m.points[k].penetration > m.points[deepest].penetration) deepest = k;
+    }
+
+    // One entry per pair whichever way round the narrowphase found it
+    bool flip = contact.a->id > contact.b->id;
+    RigidBody* a = flip ? contact.b : contact.a;
+    RigidBody* b = flip ? contact.a : contact.b;
+    uint64_t key = static_cast<uint64_t>(a->id) << 32 | b->id;
+
+    auto [it, inserted] = current.try_emplace(key);
+    PairState& pair = it->second;
+    if(inserted){
+        pair.a = a;
+        pair.b = b;
+        pair.impulse = 0.0f;
+    }
+    pair.point = m.points[deepest].position;
+    pair.normal = flip ? m.normal * -1.0f : m.normal;
+    pair.impulse += impulse;
+    pair.sensor = sensor;
+}
+
+void ContactEventStream::EndStep(uint64_t step, bool levelOfDetail){
+    keys.clear();
+    for(const auto& [key, pair] : current)
+        keys.push_back(key);
+    for(const auto& [key, pair] : previous){
+        if(current.find(key) == current.end()) keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::sort(removed.begin(), removed.end());
+
+    auto skipped = [&](const RigidBody* body){
+        return levelOfDetail && body->inverseMass > 0.0f && (step + 1) % body->simulationRate != 0;
+    };
+
+    for(uint64_t key : keys){
+        auto it = current.find(key);
+        if(it != current.end()){
+            Emit(previous.count(key) ? ContactEventType::Persist : ContactEventType::Begin, key, it->second, step);
+            continue;
+        }
+
+        // Gone from this step. Removed bodies may already be deleted, so
+        // their pairs end without looking at them
+        const PairState& pair = previous.find(key)->second;
+        uint32_t idA = static_cast<uint32_t>(key >> 32), idB = static_cast<uint32_t>(key);
+        bool gone = std::binary_search(removed.begin(), removed.end(), idA) ||
+                    std::binary_search(removed.begin(), removed.end(), idB);
+        if(!gone && (skipped(pair.a) || skipped(pair.b) || (pair.a->isSleeping && pair.b->isSleeping))){
+            current.emplace(key, pair);
+            continue;
+        }
+        Emit(ContactEventType::End, key, pair, step);
+    }
+
+    previous.swap(current);
+    current.clear();
+    removed.clear();
+}
+
+void ContactEventStream::Emit(ContactEventType type, uint64_t key, const PairState& pair, uint64_t step){
+    ContactEvent event;
+    event.type = type;
+    event.sensor = pair.sensor;
+    event.bodyA = static_cast<uint32_t>(key >> 32);
+    event.bodyB = static_cast<uint32_t>(key);
+    event.step = step;
+    event.point = pair.point;
+    event.normal = pair.normal;
+    event.impulse = type == ContactEventType::End ? 0.0f : pair.impulse;
+    events.push_back(event);
+}
+
+void ContactEventStream::Clear(){
+    current.clear();
+    previous.clear();
+    removed.clear();
+    events.clear();
+}
+
+void ContactEventStream::SaveState(State& state) const {
+    state.pairs.assign(previous.begin(), previous.end());
+}
+
+void ContactEventStream::RestoreState(const State& state, uint64_t step){
+    previous.clear();
+    previous.insert(state.pairs.begin(), state.pairs.end());
+    current.clear();
+    removed.clear();
+    events.erase(std::remove_if(events.begin(), events.end(), [&](const ContactEvent& event){ return event.step >= step; }),
+                 events.end());
+}
+
+void ContactEventStream::Drain(std::vector<ContactEvent>& out){
+    out.insert(out.end(), events.begin(), events.end());
+    events.clear();
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../collision/Contact.h"
+#include "../math/Vector2.h"
+
+class RigidBody;
+
+enum class ContactEventType : uint8_t {
+    Begin,      // Started touching this step
+    Persist,    // Still touching
+    End         // Stopped touching, or one of the bodies was removed
+};
+
+// One step of contact between two bodies, identified by RigidBody::id with the
+// lower id first. The normal points from bodyA to bodyB.
+struct ContactEvent{
+    ContactEventType type;
+    bool sensor;            // One collider is a sensor: an overlap, nothing was resolved
+    uint32_t bodyA, bodyB;
+    uint64_t step;          // GetStepCount() when the step started
+    Vector2 point;          // Deepest contact point (the last one seen, for End)
+    Vector2 normal;
+    float impulse;          // Normal impulse applied over the whole step; 0 for sensors and End
+};
+
+// Turns the contacts the world resolves into begin / persist / end events.
+// Every solver pass of a step reports its contacts; at the end of the step the
+// pairs that touched are compared with those of the step before. Pairs that
+// drop out because their bodies fell asleep (or, with level of detail, weren't
+// stepped) keep touching silently instead of ending. Events pile up in one flat
+// buffer, in pair order within a step, until the game drains them.
+class ContactEventStream{
+    public:
+        // World side. Record takes a contact of this pass with the normal impulse
+        // the solver applied to it; contacts that neither touch nor push are ignored
+        void Record(const Contact& contact, float impulse, bool sensor);
+        void BodyRemoved(uint32_t id) { removed.push_back(id); }
+        // levelOfDetail: bodies with a simulationRate above 1 may have skipped this step
+        void EndStep(uint64_t step, bool levelOfDetail);
+        // Forget all pairs and pending events
+        void Clear();
+
+        // Consumer side: appends the pending events to out and empties the buffer
+        void Drain(std::vector<ContactEvent>& out);
+        const std::vector<ContactEvent>& GetEvents() const { return events; }
+
+    private:
+        struct PairState{
+            RigidBody* a;
+            RigidBody* b;
+            Vector2 point, normal;
+            float impulse;
+            bool sensor;
+        };
+
+    public:
+        // Which pairs touched decides begin / persist / end on the next step, so
+        // rollback has to save and restore them along with the bodies. Both are
+        // called between steps. Restoring to step drops the pending events of
+        // that step and later ones, which are about to be simulated again
+        struct State{
+            std::vector<std::pair<uint64_t, PairState>> pairs;
+        };
+        void SaveState(State& state) const;
+        void RestoreState(const State& state, uint64_t step);
+
+    private:
+
+        void Emit(ContactEventType type, uint64_t key, const PairState& pair, uint64_t step);
+
+        std::unordered_map<uint64_t, PairState> current;    // Touching this step
+        std::unordered_map<uint64_t, PairState> previous;   // Touching at the end of the last step
+        std::vector<uint64_t> keys;
+        std::vector<uint32_t> removed;                       // Ids removed since the last step
+        std::vector<ContactEvent> events;
+};
@@ -0,0 +1,290 @@
+#include "PartitionedWorld.h"
+#include "../io/PartitionTransport.h"
+#include "../shapes/PolygonShape.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+using namespace PartitionFormat;
+
+static_assert(MaxPolygonVertices == PolygonShape::MaxVertices, "polygon records must hold every vertex");
+
+// Polygon bodies also append their vertices to polygons
+static BodyRecord MakeRecord(const RigidBody& body, std::vector<PolygonRecord>& polygons){
+    BodyRecord record = {};
+    record.id = body.id;
+    record.flags = (body.isSleeping ? BodySleeping : 0u) | (body.isBullet ? BodyBullet : 0u) |
+                   (body.collider && body.collider->isSensor ? BodySensor : 0u);
+    record.mass = body.mass;
+    record.inverseInertia = body.inverseInertia;
+    record.sizeX = body.size.x;
+    record.sizeY = body.size.y;
+    record.positionX = body.position.x;
+    record.positionY = body.position.y;
+    record.velocityX = body.velocity.x;
+    record.velocityY = body.velocity.y;
+    record.forceX = body.force.x;
+    record.forceY = body.force.y;
+    record.orientation = body.orientation;
+    record.angularVelocity = body.angularVelocity;
+    record.torque = body.torque;
+    record.sleepTime = body.sleepTime;
+    record.linearDamping = body.linearDamping;
+    record.angularDamping = body.angularDamping;
+    record.shapeKind = ShapeNone;
+
+    if(body.collider && body.collider->shape){
+        const Collider* collider = body.collider;
+        if(collider->shape->GetType() == ShapeType::Circle){
+            record.shapeKind = ShapeCircle;
+            record.shapeX = static_cast<const CircleShape*>(collider->shape)->radius;
+        }else if(collider->shape->GetType() == ShapeType::Polygon){
+            const PolygonShape* polygon = static_cast<const PolygonShape*>(collider->shape);
+            record.shapeKind = ShapePolygon;
+            PolygonRecord vertices = {};
+            vertices.count = static_cast<uint32_t>(polygon->count);
+            for(int k = 0; k < polygon->count; k++){
+                vertices.x[k] = polygon->vertices[k].x;
+                vertices.y[k] = polygon->vertices[k].y;
+            }
+            polygons.push_back(vertices);
+        }else{
+            const AABBShape* box = static_cast<const AABBShape*>(collider->shape);
+            record.shapeKind = ShapeAABB;
+            record.shapeX = box->halfsize.x;
+            record.shapeY = box->halfsize.y;
+        }
+        record.restitution = collider->restitution;
+        record.staticFriction = collider->staticFriction;
+        record.dynamicFriction = collider->dynamicFriction;
+    }
+    return record;
+}
+
+// Motion state only; the shape and material never change while a body is exchanged
+static void ApplyState(RigidBody& body, const BodyRecord& record){
+    body.position = Vector2(record.positionX, record.positionY);
+    body.velocity = Vector2(record.velocityX, record.velocityY);
+    body.force = Vector2(record.forceX, record.forceY);
+    body.orientation = record.orientation;
+    body.angularVelocity = record.angularVelocity;
+    body.torque = record.torque;
+    body.sleepTime = record.sleepTime;
+    body.isSleeping = (record.flags & BodySleeping) != 0;
+    body.isBullet = (record.flags & BodyBullet) != 0;
+}
+
+PartitionedWorld::PartitionedWorld(int partition, const std::vector<float>& boundaries, PartitionTransport& transport)
+    : transport(transport), partition(partition), boundaries(boundaries) {}
+
+int PartitionedWorld::GetPartitionOf(float x) const {
+    int p = 0;
+    while(p < static_cast<int>(boundaries.size()) && x >= boundaries[p])
+        p++;
+    return p;
+}
+
+bool PartitionedWorld::AddBody(RigidBody* body){
+    if(body->inverseMass == 0.0f){
+        world.AddBody(body);
+        return true;
+    }
+    if(GetPartitionOf(body->position.x) != partition) return false;
+
+    world.AddBody(body);
+    Entry& entry = entries[body->id];
+    entry.body = body;
+    entry.ghost = false;
+    return true;
+}
+
+void PartitionedWorld::GetOwnedBodies(std::vector<RigidBody*>& out) const {
+    out.clear();
+    for(int i = 0; i < world.GetBodyCount(); i++){
+        RigidBody* body = world.GetBody(i);
+        auto it = entries.find(body->id);
+        if(it != entries.end() && !it->second.ghost)
+            out.push_back(body);
+    }
+}
+
+bool PartitionedWorld::IsGhost(const RigidBody* body) const {
+    auto it = entries.find(body->id);
+    return it != entries.end() && it->second.ghost;
+}
+
+bool PartitionedWorld::Step(float deltaTime){
+    const float infinity = std::numeric_limits<float>::infinity();
+    float left = partition > 0 ? boundaries[partition - 1] : -infinity;
+    float right = partition < static_cast<int>(boundaries.size()) ? boundaries[partition] : infinity;
+
+    for(int side = 0; side < 2; side++){
+        migrations[side].clear();
+        ghosts[side].clear();
+        migrationPolygons[side].clear();
+        ghostPolygons[side].clear();
+    }
+    for(auto& item : entries)
+        item.second.refreshed = false;
+
+    // Sort owned bodies into migrations and ghosts. A body handed to a neighbour
+    // stays here as a ghost if it is still inside the band the neighbour mirrors
+    for(int i = 0; i < world.GetBodyCount(); i++){
+        RigidBody* body = world.GetBody(i);
+        if(body->inverseMass == 0.0f) continue;
+        Entry& entry = entries[body->id];
+        if(entry.ghost) continue;
+
+        float x = body->position.x;
+        if(x < left || x >= right){
+            int side = x < left ? 0 : 1;
+            migrations[side].push_back(MakeRecord(*body, migrationPolygons[side]));
+            entry.ghost = true;
+            entry.refreshed = side == 0 ? x >= left - ghostWidth : x < right + ghostWidth;
+            continue;
+        }
+        if(x < left + ghostWidth) ghosts[0].push_back(MakeRecord(*body, ghostPolygons[0]));
+        if(x >= right - ghostWidth) ghosts[1].push_back(MakeRecord(*body, ghostPolygons[1]));
+    }
+
+    if(partition > 0 && !Exchange(0)) return false;
+    if(partition < static_cast<int>(boundaries.size()) && !Exchange(1)) return false;
+
+    // Ghosts the owner no longer mirrors leave at the start of the local step
+    for(auto it = entries.begin(); it != entries.end();){
+        if(it->second.ghost && !it->second.refreshed){
+            world.GetCommandBuffer().RemoveBody(it->second.body);
+            if(it->second.storage)
+                retired.push_back(std::move(it->second.storage));
+            it = entries.erase(it);
+        }else{
+            ++it;
+        }
+    }
+
+    world.Step(deltaTime);
+    retired.clear();
+    stepCount++;
+    return true;
+}
+
+// The lower partition of a pair sends first, so a chain of partitions
+// exchanges without deadlocking however large the messages get
+bool PartitionedWorld::Exchange(int side){
+    int neighbour = side == 0 ? partition - 1 : partition + 1;
+
+    Header header = {};
+    header.magic = Magic;
+    header.version = Version;
+    header.step = stepCount;
+    header.migrationCount = static_cast<uint32_t>(migrations[side].size());
+    header.ghostCount = static_cast<uint32_t>(ghosts[side].size());
+    header.polygonCount = static_cast<uint32_t>(migrationPolygons[side].size() + ghostPolygons[side].size());
+
+    size_t recordBytes = sizeof(BodyRecord);
+    size_t polygonBytes = sizeof(PolygonRecord);
+    outgoing.resize(sizeof(Header) + (migrations[side].size() + ghosts[side].size()) * recordBytes +
+                    header.polygonCount * polygonBytes);
+    unsigned char* out = outgoing.data();
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    auto append = [&](const void* data, size_t bytes){
+        if(bytes == 0) return;
+        std::memcpy(out, data, bytes);
+        out += bytes;
+    };
+    append(migrations[side].data(), migrations[side].size() * recordBytes);
+    append(ghosts[side].data(), ghosts[side].size() * recordBytes);
+    append(migrationPolygons[side].data(), migrationPolygons[side].size() * polygonBytes);
+    append(ghostPolygons[side].data(), ghostPolygons[side].size() * polygonBytes);
+
+    if(neighbour < partition){
+        if(!transport.Receive(neighbour, incoming) || !transport.Send(neighbour, outgoing)) return false;
+    }else{
+        if(!transport.Send(neighbour, outgoing) || !transport.Receive(neighbour, incoming)) return false;
+    }
+    return Apply(incoming);
+}
+
+bool PartitionedWorld::Apply(const std::vector<unsigned char>& message){
+    Header header;
+    if(message.size() < sizeof(header)) return false;
+    std::memcpy(&header, message.data(), sizeof(header));
+    size_t count = static_cast<size_t>(header.migrationCount) + header.ghostCount;
+    if(header.magic != Magic || header.version != Version || header.step != stepCount ||
+       message.size() != sizeof(header) + count * sizeof(BodyRecord) + header.polygonCount * sizeof(PolygonRecord))
+        return false;
+
+    // Every polygon body needs its record, with a vertex count PolygonShape takes
+    const unsigned char* in = message.data() + sizeof(header);
+    const unsigned char* polygons = in + count * sizeof(BodyRecord);
+    size_t polygonCount = 0;
+    for(size_t i = 0; i < count; i++){
+        uint32_t shapeKind;
+        std::memcpy(&shapeKind, in + i * sizeof(BodyRecord) + offsetof(BodyRecord, shapeKind), sizeof(shapeKind));
+        if(shapeKind != ShapePolygon) continue;
+        uint32_t vertexCount;
+        std::memcpy(&vertexCount, polygons + polygonCount * sizeof(PolygonRecord), sizeof(vertexCount));
+        if(polygonCount == header.polygonCount || vertexCount < 3 || vertexCount > MaxPolygonVertices)
+            return false;
+        polygonCount++;
+    }
+    if(polygonCount != header.polygonCount)
+        return false;
+
+    polygonCount = 0;
+    for(size_t i = 0; i < count; i++){
+        BodyRecord record;
+        PolygonRecord polygon;
+        std::memcpy(&record, in + i * sizeof(BodyRecord), sizeof(record));
+        if(record.shapeKind == ShapePolygon)
+            std::memcpy(&polygon, polygons + polygonCount++ * sizeof(PolygonRecord), sizeof(polygon));
+        Receive(record, record.shapeKind == ShapePolygon ? &polygon : nullptr, i >= header.migrationCount);
+    }
+    return true;
+}
+
+void PartitionedWorld::Receive(const BodyRecord& record, const PolygonRecord* polygon, bool ghost){
+    Entry& entry = entries[record.id];
+    if(!entry.body){
+        // New here: build the body, it joins the local world at the next step
+        entry.storage.reset(new RemoteBody());
+        RemoteBody& remote = *entry.storage;
+        RigidBody& body = remote.body;
+        body.id = record.id;
+        body.mass = record.mass;
+        body.inverseMass = record.mass > 0.0f ? 1.0f / record.mass : 0.0f;
+        body.inverseInertia = record.inverseInertia;
+        body.size = Vector2(record.sizeX, record.sizeY);
+        body.linearDamping = record.linearDamping;
+        body.angularDamping = record.angularDamping;
+
+        if(record.shapeKind != ShapeNone){
+            if(record.shapeKind == ShapeCircle){
+                remote.circle.radius = record.shapeX;
+                remote.collider.shape = &remote.circle;
+            }else if(polygon){
+                Vector2 points[MaxPolygonVertices];
+                for(uint32_t k = 0; k < polygon->count; k++)
+                    points[k] = Vector2(polygon->x[k], polygon->y[k]);
+                remote.polygon.reset(new PolygonShape(points, static_cast<int>(polygon->count)));
+                remote.collider.shape = remote.polygon.get();
+            }else{
+                remote.box.halfsize = Vector2(record.shapeX, record.shapeY);
+                remote.collider.shape = &remote.box;
+            }
+            remote.collider.restitution = record.restitution;
+            remote.collider.staticFriction = record.staticFriction;
+            remote.collider.dynamicFriction = record.dynamicFriction;
+            remote.collider.isSensor = (record.flags & BodySensor) != 0;
+            body.collider = &remote.collider;
+        }
+        entry.body = &body;
+        world.GetCommandBuffer().AddBody(&body);
+    }
+
+    ApplyState(*entry.body, record);
+    entry.ghost = ghost;
+    entry.refreshed = true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "PhysicsWorld.h"
+#include "../io/PartitionFormat.h"
+#include "../shapes/AABBShape.h"
+#include "../shapes/CircleShape.h"
+#include "../shapes/PolygonShape.h"
+
+class PartitionTransport;
+
+// One strip of a world split along x between processes (or machines), each
+// simulating its own strip in a local PhysicsWorld. Every step a partition
+// sends its neighbours the bodies it owns within the ghost width of their
+// shared boundary, which they simulate as read-only ghosts and overwrite with
+// the owner's state each step, and hands over bodies that crossed into a
+// neighbour's strip. Contacts between bodies of different partitions are
+// therefore approximate, while bodies that stay clear of the boundaries step
+// exactly as in a single world, given:
+//   - the same settings and force generators in every partition
+//   - SetResidualTolerance(0) and body reordering left off (the default), as
+//     early exits and the body order otherwise depend on the whole world
+//   - no focus points and no job system in the local worlds
+//   - body ids unique across partitions, set before AddBody, with bodies
+//     added in ascending id order
+// Static bodies are never exchanged: add each to every partition it reaches.
+class PartitionedWorld{
+    public:
+        // boundaries: ascending x where each strip ends, one fewer than the
+        // number of partitions. The transport must connect this partition to
+        // partition - 1 and partition + 1 and outlive the world
+        PartitionedWorld(int partition, const std::vector<float>& boundaries, PartitionTransport& transport);
+
+        // Configure the local world (iterations, forces, solver mode) through this
+        PhysicsWorld& GetWorld() { return world; }
+
+        // Static bodies are always added; dynamic ones only if their position
+        // lies in this strip, otherwise this returns false. A body added here is
+        // updated only while it stays in this partition; bodies that migrate
+        // in are allocated and owned by the partition
+        bool AddBody(RigidBody* body);
+
+        // Exchange ghosts and migrations with both neighbours, then step the
+        // local world. Every partition must call this with the same deltaTime;
+        // returns false if the transport failed or a neighbour is out of step
+        bool Step(float deltaTime);
+
+        // Width of the band on each side of a boundary whose bodies are mirrored
+        // to the neighbour. Should exceed the largest body plus how far bodies move per step
+        void SetGhostWidth(float width) { ghostWidth = width; }
+
+        int GetPartition() const { return partition; }
+        int GetPartitionOf(float x) const;
+        // Dynamic bodies owned here, in world order
+        void GetOwnedBodies(std::vector<RigidBody*>& out) const;
+        bool IsGhost(const RigidBody* body) const;
+
+    private:
+        // Storage for bodies created from records
+        struct RemoteBody{
+            RigidBody body;
+            Collider collider{nullptr};
+            CircleShape circle{0.0f};
+            AABBShape box{Vector2()};
+            std::unique_ptr<PolygonShape> polygon;
+        };
+
+        struct Entry{
+            RigidBody* body = nullptr;
+            std::unique_ptr<RemoteBody> storage;
+            bool ghost = false;
+            bool refreshed = false;
+        };
+
+        bool Exchange(int side);
+        bool Apply(const std::vector<unsigned char>& message);
+        // polygon: the body's vertices if its shape is ShapePolygon
+        void Receive(const PartitionFormat::BodyRecord& record, const PartitionFormat::PolygonRecord* polygon, bool ghost);
+
+        PhysicsWorld world;
+        PartitionTransport& transport;
+        int partition;
+        std::vector<float> boundaries;
+        float ghostWidth = Config::PartitionGhostWidth;
+        uint32_t stepCount = 0;
+
+        std::unordered_map<uint32_t, Entry> entries; // Dynamic bodies by id
+        std::vector<std::unique_ptr<RemoteBody>> retired;
+        std::vector<PartitionFormat::BodyRecord> migrations[2], ghosts[2]; // Left, right
+        std::vector<PartitionFormat::PolygonRecord> migrationPolygons[2], ghostPolygons[2];
+        std::vector<unsigned char> outgoing, incoming;
+};
@@ -1,77 +1,657 @@
 #include "PhysicsWorld.h"
 
 #include "../core/Config.h"
-#include "../collision/Collision.h"
+#include "../core/Time.h"
+#include "../io/SharedTransformExporter.h"
 #include "../collision/CollisionResolver.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
 
+// Give new bodies a stable id, keeping ids that were set by the caller
+void PhysicsWorld::AssignId(RigidBody* body){
+    if(body->id == InvalidBodyId)
+        body->id = nextBodyId++;
+    else if(body->id >= nextBodyId)
+        nextBodyId = body->id + 1;
+}
+
+// A body already in the world is not added again
 void PhysicsWorld::AddBody(RigidBody* body){
+    if(!members.insert(body).second) return;
+    AssignId(body);
     bodies.push_back(body);
+    snapshots.Reset();
+}
+
+void PhysicsWorld::AddBodies(RigidBody* const* newBodies, int count){
+    bodies.reserve(bodies.size() + count);
+    for(int i = 0; i < count; i++){
+        if(!members.insert(newBodies[i]).second) continue;
+        AssignId(newBodies[i]);
+        bodies.push_back(newBodies[i]);
+    }
+    snapshots.Reset();
+}
+
+void PhysicsWorld::RemoveBody(RigidBody* body){
+    if(!members.erase(body)) return;
+    if(contactEventsEnabled)
+        contactEvents.BodyRemoved(body->id);
+    bodies.erase(std::remove(bodies.begin(), bodies.end(), body), bodies.end());
+    snapshots.Reset();
+}
+
+// The substep solver's warm-start cache, the particles and the contact event
+// pairs are saved next to each body snapshot
+int PhysicsWorld::SaveState(){
+    int tick = snapshots.Save(bodies, stepCount);
+    solverStates.resize(snapshots.GetCapacity());
+    particleStates.resize(snapshots.GetCapacity());
+    contactEventStates.resize(snapshots.GetCapacity());
+    substepSolver.SaveCache(solverStates[tick % solverStates.size()]);
+    particles.SaveState(particleStates[tick % particleStates.size()]);
+    contactEvents.SaveState(contactEventStates[tick % contactEventStates.size()]);
+    return tick;
+}
+
+bool PhysicsWorld::RestoreState(int tick){
+    if(!snapshots.Restore(tick, bodies, stepCount))
+        return false;
+    substepSolver.RestoreCache(solverStates[tick % solverStates.size()]);
+    particles.RestoreState(particleStates[tick % particleStates.size()]);
+    contactEvents.RestoreState(contactEventStates[tick % contactEventStates.size()], stepCount);
+    return true;
+}
+
+// Apply every command queued since the last step as one batch
+void PhysicsWorld::FlushCommands(){
+    commandBuffer.Drain(pendingCommands);
+    if(pendingCommands.empty()) return;
+
+    // members follows every command in turn. Adds of bodies already present
+    // and removals of bodies that aren't are ignored. A body that was in the
+    // list before the batch and is removed and added again keeps its slot
+    for(const WorldCommand& cmd : pendingCommands){
+        switch(cmd.type){
+            case WorldCommandType::AddBody:
+                if(!members.insert(cmd.body).second) break;
+                if(!pendingRemovals.erase(cmd.body)){
+                    pendingAdds.push_back(cmd.body);
+                    pendingAddSet.insert(cmd.body);
+                }
+                break;
+            case WorldCommandType::RemoveBody:
+                if(!members.erase(cmd.body)) break;
+                if(!pendingAddSet.erase(cmd.body))
+                    pendingRemovals.insert(cmd.body);
+                break;
+            case WorldCommandType::SetVelocity:
+                cmd.body->velocity = cmd.value;
+                cmd.body->angularVelocity = cmd.angular;
+                cmd.body->isSleeping = false;
+                cmd.body->sleepTime = 0.0f;
+                break;
+            case WorldCommandType::ApplyImpulse:
+                cmd.body->ApplyImpulse(cmd.value);
+                break;
+        }
+    }
+    pendingCommands.clear();
+
+    if(!pendingAddSet.empty() || !pendingRemovals.empty())
+        snapshots.Reset();
+
+    // Removals take effect at the end of the batch, in a single compaction
+    // pass; the net effect matches applying the commands in submission order
+    if(!pendingRemovals.empty()){
+        if(contactEventsEnabled){
+            for(RigidBody* body : bodies){
+                if(pendingRemovals.count(body)) contactEvents.BodyRemoved(body->id);
+            }
+        }
+        bodies.erase(std::remove_if(bodies.begin(), bodies.end(), [this](RigidBody* body){
+            return pendingRemovals.count(body) != 0;
+        }), bodies.end());
+        pendingRemovals.clear();
+    }
+
+    // Bodies still added at the end of the batch, in the order of their first add
+    bodies.reserve(bodies.size() + pendingAddSet.size());
+    for(RigidBody* body : pendingAdds){
+        if(!pendingAddSet.erase(body)) continue;
+        AssignId(body);
+        bodies.push_back(body);
+    }
+    pendingAdds.clear();
+    pendingAddSet.clear();
+
+    spatialHash.Reserve(bodies.size());
 }
 
 void PhysicsWorld::AddForceGenerator(ForceGenerator* fg){
     forceGenerators.push_back(fg);
 }
 
-void PhysicsWorld::Step(float deltaTime){
-    // Apply Force Generators
-    for(ForceGenerator* fg : forceGenerators){
-        for(auto body : bodies){
-            if(!body->isSleeping)
-                fg->Apply(*body);
-        }
-    }
-
-    // Integrate motion
-    for(auto body : bodies){
-        if(body->isSleeping) continue;
-        body->Integrate(deltaTime);
-
-        // Sleep detection (use lengthSquared to avoid sqrt)
-        float sleepThresholdSq = Config::SleepVelocityThreshold * Config::SleepVelocityThreshold;
-        if(body->velocity.lengthSquared() < sleepThresholdSq){
-            body->sleepTime += deltaTime;
-            if(body->sleepTime >= Config::SleepTimeThreshold){
-                body->isSleeping = true;
-                body->velocity = Vector2(0,0);
+void PhysicsWorld::SetContactEvents(bool enabled){
+    contactEventsEnabled = enabled;
+    if(!enabled)
+        contactEvents.Clear();
+}
+
+void PhysicsWorld::SetWorkerThreads(int count){
+    std::unique_ptr<JobSystem> created(count > 0 ? new JobSystem(count) : nullptr);
+    SetJobSystem(created.get());
+    ownedJobs = std::move(created);
+}
+
+void PhysicsWorld::SetJobSystem(JobSystem* jobs){
+    this->jobs = jobs;
+    solver.SetJobSystem(jobs);
+    narrowphase.SetJobSystem(jobs);
+    particles.SetJobSystem(jobs);
+    if(jobs != ownedJobs.get())
+        ownedJobs.reset();
+}
+
+// Broadphase: candidate pairs from the spatial hash, or every pair when it's disabled.
+// margins (optional, one per body) grow each body's bounds
+void PhysicsWorld::FindPairs(const float* margins){
+    if(useSpatialHash){
+        // Bounds in parallel, then one thread fills the grid in body order
+        int count = static_cast<int>(bodies.size());
+        bodyBounds.resize(count);
+        ParallelFor(count, [&](int begin, int end){
+            for(int i = begin; i < end; i++)
+                bodyBounds[i] = SpatialHash::GetBodyAABB(bodies[i], margins ? margins[i] : 0.0f);
+        });
+
+        spatialHash.Clear();
+        for(int i = 0; i < count; i++){
+            spatialHash.Insert(bodyBounds[i], i);
+        }
+        spatialHash.GetPotentialCollisions(pairs);
+    } else {
+        pairs.clear();
+        int count = static_cast<int>(bodies.size());
+        for(int i = 0; i < count; i++){
+            for(int j = i + 1; j < count; j++){
+                pairs.emplace_back(i, j);
             }
+        }
+    }
+}
+
+// Contacts for the current pairs, then between dynamic bodies and terrain.
+// Those involving a sensor move to sensorContacts, in order, so the solver,
+// waking and sleeping never see them
+void PhysicsWorld::FindContacts(const float* margins){
+    narrowphase.Run(bodies, pairs, contacts, margins);
+    CollideTerrain(margins);
+
+    sensorContacts.clear();
+    size_t kept = 0;
+    for(size_t i = 0; i < contacts.size(); i++){
+        if(contacts[i].a->collider->isSensor || contacts[i].b->collider->isSensor){
+            sensorContacts.push_back(contacts[i]);
         } else {
-            body->sleepTime = 0.0f;
+            if(kept != i) contacts[kept] = contacts[i];
+            kept++;
         }
     }
+    contacts.resize(kept);
+}
+
+// Hand one pass of contacts (with the normal impulse of each, if known) and
+// the sensor overlaps to the event stream
+void PhysicsWorld::RecordContactEvents(const float* impulses){
+    for(size_t i = 0; i < contacts.size(); i++)
+        contactEvents.Record(contacts[i], impulses ? impulses[i] : 0.0f, false);
+    for(const Contact& contact : sensorContacts)
+        contactEvents.Record(contact, 0.0f, true);
+}
+
+void PhysicsWorld::FindTerrainBodies(){
+    terrainBodies.clear();
+    for(int i = 0; i < static_cast<int>(bodies.size()); i++){
+        const RigidBody* body = bodies[i];
+        if(body->inverseMass == 0.0f && body->collider && body->collider->shape->IsTerrain())
+            terrainBodies.push_back(i);
+    }
+}
+
+// Terrain is kept out of the broadphase, so every dynamic body is checked
+// against every terrain body; each test only reads the terrain under the body
+void PhysicsWorld::CollideTerrain(const float* margins){
+    FindTerrainBodies();
+    if(terrainBodies.empty()) return;
+
+    for(int i = 0; i < static_cast<int>(bodies.size()); i++){
+        RigidBody* body = bodies[i];
+        if(body->inverseMass == 0.0f || !body->collider || body->collider->shape->IsTerrain()) continue;
+        for(int t : terrainBodies){
+            if(body->isSleeping && bodies[t]->isSleeping) continue;
+            terrainCollision.Collide(bodies[t], t, body, i, margins ? margins[i] : 0.0f, contacts);
+        }
+    }
+}
+
+// Sort the body list by the Morton code of each body's hash cell once enough
+// neighbours in the list are out of order. Bodies are owned by the caller, so
+// only the list moves; what it buys is locality in everything indexed by it
+// (narrowphase arrays, broadphase pairs, solver colouring). Ties keep the
+// current order, so the result only depends on the world state
+void PhysicsWorld::ReorderBodies(){
+    int count = static_cast<int>(bodies.size());
+    if(count < 2) return;
+
+    bodyOrder.resize(count);
+    int outOfOrder = 0;
+    for(int i = 0; i < count; i++){
+        bodyOrder[i] = {spatialHash.GetCellCode(bodies[i]->position), i};
+        if(i > 0 && bodyOrder[i].first < bodyOrder[i - 1].first) outOfOrder++;
+    }
+    if(outOfOrder <= Config::BodyReorderThreshold * (count - 1)) return;
+
+    std::sort(bodyOrder.begin(), bodyOrder.end());
+    reorderedBodies.resize(count);
+    newBodyIndex.resize(count);
+    for(int i = 0; i < count; i++){
+        reorderedBodies[i] = bodies[bodyOrder[i].second];
+        newBodyIndex[bodyOrder[i].second] = i;
+    }
+    bodies.swap(reorderedBodies);
+    snapshots.Remap(newBodyIndex);
+}
 
-    // Collision detection and resolution
-    for(int it = 0; it < iterations; it++){
-        if (useSpatialHash) { // Use spatial hashing
-            spatialHash.Clear();
-            
-            for(int i = 0; i < bodies.size(); i++){
-                spatialHash.Insert(bodies[i], i);
+// How far any point of the body can travel this step at its current velocity
+static float SpeculativeMargin(const RigidBody& body, float deltaTime){
+    if(body.isSleeping || body.inverseMass == 0.0f || !body.collider) return 0.0f;
+    const Shape* shape = body.collider->shape;
+    float extent = shape->GetType() == ShapeType::Circle ? 0.0f
+                 : shape->GetType() == ShapeType::Polygon ? static_cast<const PolygonShape*>(shape)->radius
+                 : static_cast<const AABBShape*>(shape)->halfsize.length();
+    return (body.velocity.length() + std::abs(body.angularVelocity) * extent) * deltaTime;
+}
+
+// Wake the sleeping dynamic bodies touched by an awake one; true if any woke
+bool PhysicsWorld::WakeContacts(){
+    bool woke = false;
+    for(const Contact& contact : contacts){
+        RigidBody* a = contact.a;
+        RigidBody* b = contact.b;
+        if(a->isSleeping == b->isSleeping) continue;
+        RigidBody* sleeper = a->isSleeping ? a : b;
+        if(sleeper->inverseMass == 0.0f) continue;
+        sleeper->isSleeping = false;
+        woke = true;
+    }
+    return woke;
+}
+
+// Sweep each bullet from where it started the step to where it ended, against
+// the non-bullet bodies near its path. A bullet that would have passed through
+// something is moved back to the time of impact, and the touching contact
+// there is resolved so it leaves the step already bouncing off. The rest of
+// its motion for the step is dropped.
+void PhysicsWorld::SolveContinuous(float deltaTime){
+    const float target = 0.25f; // Gap left between the bullet and what it hits (pixels)
+    FindTerrainBodies();
+
+    for(auto& [index, sweep] : bulletSweeps){
+        RigidBody* bullet = bodies[index];
+        const Shape& shape = *bullet->collider->shape;
+        sweep.position1 = bullet->position;
+        sweep.angle1 = bullet->orientation;
+
+        float minExtent, maxExtent;
+        if(shape.GetType() == ShapeType::Circle){
+            minExtent = maxExtent = static_cast<const CircleShape&>(shape).radius;
+        } else if(shape.GetType() == ShapeType::Polygon){
+            // Nearest edge and farthest vertex from the centroid
+            const PolygonShape& polygon = static_cast<const PolygonShape&>(shape);
+            minExtent = std::numeric_limits<float>::max();
+            for(int i = 0; i < polygon.count; i++)
+                minExtent = std::min(minExtent, polygon.normals[i].dot(polygon.vertices[i]));
+            maxExtent = polygon.radius;
+        } else {
+            Vector2 halfsize = static_cast<const AABBShape&>(shape).halfsize;
+            minExtent = std::min(halfsize.x, halfsize.y);
+            maxExtent = halfsize.length();
+        }
+
+        // Moved less than half its size: the discrete contacts can't miss anything
+        Vector2 translation = sweep.position1 - sweep.position0;
+        float travel = translation.length() + std::abs(sweep.angle1 - sweep.angle0) * maxExtent;
+        if(travel < 0.5f * minExtent) continue;
+
+        AABB bounds;
+        bounds.min = Vector2(std::min(sweep.position0.x, sweep.position1.x) - maxExtent,
+                             std::min(sweep.position0.y, sweep.position1.y) - maxExtent);
+        bounds.max = Vector2(std::max(sweep.position0.x, sweep.position1.x) + maxExtent,
+                             std::max(sweep.position0.y, sweep.position1.y) + maxExtent);
+        if(useSpatialHash){
+            spatialHash.Query(bounds, candidates);
+        } else {
+            candidates.resize(bodies.size());
+            for(int i = 0; i < static_cast<int>(bodies.size()); i++) candidates[i] = i;
+        }
+
+        float firstT = 1.0f;
+        RigidBody* firstHit = nullptr;
+        DistanceOutput firstContact;
+        // Terrain stays out of the broadphase; it is swept piece by piece below
+        for(int j : candidates){
+            RigidBody* other = bodies[j];
+            if(j == index || other->isBullet || !other->collider || !other->collider->shape ||
+               other->collider->shape->IsTerrain() || other->collider->isSensor) continue;
+
+            float t;
+            DistanceOutput contact;
+            if(TimeOfImpact::Compute(shape, sweep, *other->collider->shape, other->position, other->orientation,
+                                     target, t, contact) && t < firstT){
+                firstT = t;
+                firstHit = other;
+                firstContact = contact;
             }
-            
-            auto pairs = spatialHash.GetPotentialCollisions(bodies);
-            
-            for(const auto& pair : pairs){
-                RigidBody* bodyA = bodies[pair.first];
-                RigidBody* bodyB = bodies[pair.second];
-                
-                if(bodyA->isSleeping && bodyB->isSleeping) continue;
-                if(bodyA->inverseMass == 0.0f && bodyB->inverseMass == 0.0f) continue;
-                
-                Collision::CheckCollision(*bodyA, *bodyB);
+        }
+        for(int j : terrainBodies){
+            float t;
+            DistanceOutput contact;
+            if(terrainCollision.ComputeTimeOfImpact(bodies[j], shape, sweep, bounds, target, t, contact) && t < firstT){
+                firstT = t;
+                firstHit = bodies[j];
+                firstContact = contact;
             }
-        } else { // Brute-force check
-            for(int i = 0; i < bodies.size(); i++){
-                RigidBody* bodyA = bodies[i];
-                
-                for(int j = i + 1; j < bodies.size(); j++){
-                    RigidBody* bodyB = bodies[j];
-                    
-                    if(bodyA->isSleeping && bodyB->isSleeping) continue;
-                    if(bodyA->inverseMass == 0.0f && bodyB->inverseMass == 0.0f) continue;
-                    
-                    Collision::CheckCollision(*bodyA, *bodyB);
-                }
+        }
+        if(!firstHit) continue;
+
+        bullet->position = sweep.Position(firstT);
+        bullet->orientation = sweep.Angle(firstT);
+
+        CollisionManifold manifold;
+        manifold.normal = firstContact.normal;
+        manifold.penetration = 0.0f;
+        manifold.AddPoint((firstContact.pointA + firstContact.pointB) * 0.5f, 0.0f);
+        CollisionResolver::Resolve(*bullet, *firstHit, manifold, deltaTime);
+    }
+}
+
+void PhysicsWorld::Step(float deltaTime){
+    Simulate(deltaTime, substeps > 0 ? substeps : iterations);
+}
+
+AdvanceStats PhysicsWorld::Advance(float frameTime){
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+
+    int passes = substeps > 0 ? substeps : iterations;
+    advanceStats = AdvanceStats();
+    advanceStats.iterationCap = passes;
+
+    accumulator += std::min(frameTime, Time::MaxFrameTime);
+    while(accumulator >= Time::FixedDeltaTime){
+        int cap = passes;
+        if(frameBudget > 0.0f && passCost > 0.0f){
+            float remaining = frameBudget - std::chrono::duration<float>(Clock::now() - start).count();
+            int owed = static_cast<int>(accumulator / Time::FixedDeltaTime);
+
+            // Drop the steps that wouldn't fit even at one pass each, rather
+            // than falling further behind every frame
+            int affordable = std::max(static_cast<int>(remaining / passCost), 0);
+            if(affordable < owed){
+                float dropped = (owed - affordable) * Time::FixedDeltaTime;
+                accumulator -= dropped;
+                advanceStats.droppedTime += dropped;
+                advanceStats.degraded = true;
+                owed = affordable;
             }
+            if(owed == 0){
+                advanceStats.iterationCap = 0;
+                break;
+            }
+
+            // Share what is left of the budget between the steps still owed
+            cap = std::clamp(static_cast<int>(remaining / (owed * passCost)), 1, passes);
+            if(cap < passes) advanceStats.degraded = true;
+            advanceStats.iterationCap = std::min(advanceStats.iterationCap, cap);
         }
+
+        auto stepStart = Clock::now();
+        Simulate(Time::FixedDeltaTime, cap);
+        float stepTime = std::chrono::duration<float>(Clock::now() - stepStart).count();
+        passCost = stepTime / std::max(stepStats.iterations, 1);
+
+        accumulator -= Time::FixedDeltaTime;
+        advanceStats.steps++;
     }
+
+    advanceStats.elapsed = std::chrono::duration<float>(Clock::now() - start).count();
+    return advanceStats;
+}
+
+// One step with at most maxPasses solver passes (or substeps)
+void PhysicsWorld::Simulate(float deltaTime, int maxPasses){
+    FlushCommands();
+    stepStats = StepStats();
+
+    if(reorderBodies && useSpatialHash && stepCount % Config::BodyReorderInterval == 0)
+        ReorderBodies();
+
+    if(focusPoints.empty() || !useSpatialHash){
+        SimulateBodies(deltaTime, maxPasses);
+    } else {
+        // Level of detail: each rate whose window ends this step simulates its
+        // bodies (and the static ones) over the whole window. Rates change only
+        // when every window starts together, so no body ever owes time
+        if(stepCount % Config::LodMaxRate == 0)
+            AssignRates(deltaTime);
+
+        StepStats total;
+        for(int rate = 1; rate <= Config::LodMaxRate; rate *= 2){
+            if((stepCount + 1) % rate != 0) continue;
+
+            lodBodies.clear();
+            for(RigidBody* body : bodies){
+                if(body->simulationRate == rate || body->inverseMass == 0.0f)
+                    lodBodies.push_back(body);
+            }
+            bodies.swap(lodBodies);
+            stepStats = StepStats();
+            SimulateBodies(deltaTime * rate, maxPasses, rate > 1);
+            bodies.swap(lodBodies);
+
+            total.iterations += stepStats.iterations;
+            total.residual = std::max(total.residual, stepStats.residual);
+            total.contactCount += stepStats.contactCount;
+        }
+        stepStats = total;
+    }
+
+    if(contactEventsEnabled)
+        contactEvents.EndStep(stepCount, !focusPoints.empty() && useSpatialHash);
+
+    particles.Step(deltaTime, bodies);
+
+    stepCount++;
+
+    if(transformExporter)
+        transformExporter->Publish(*this);
+}
+
+// Pick each body's rate from its distance to the nearest focus point, then
+// give every group of bodies that could touch before the next reassignment
+// the fastest rate among them. Groups come from a broadphase pass with each
+// body grown by its reach over the window; static bodies don't join groups,
+// so the ground doesn't tie a whole map to one rate
+void PhysicsWorld::AssignRates(float deltaTime){
+    int count = static_cast<int>(bodies.size());
+    float halfSq = lodHalfRateDistance * lodHalfRateDistance;
+    float quarterSq = lodQuarterRateDistance * lodQuarterRateDistance;
+
+    margins.resize(count);
+    lodGroup.resize(count);
+    lodGroupRate.resize(count);
+    ParallelFor(count, [&](int begin, int end){
+        for(int i = begin; i < end; i++){
+            RigidBody* body = bodies[i];
+            float nearestSq = std::numeric_limits<float>::max();
+            for(const Vector2& focus : focusPoints)
+                nearestSq = std::min(nearestSq, (body->position - focus).lengthSquared());
+
+            lodGroup[i] = i;
+            lodGroupRate[i] = nearestSq > quarterSq ? 4 : nearestSq > halfSq ? 2 : 1;
+            margins[i] = SpeculativeMargin(*body, deltaTime * Config::LodMaxRate);
+        }
+    });
+    static_assert(Config::LodMaxRate == 4, "rates above assume 1, 2 and 4");
+
+    // Union-find over the padded pairs, keeping the lowest index as the root
+    auto find = [this](int i){
+        while(lodGroup[i] != i){
+            lodGroup[i] = lodGroup[lodGroup[i]];
+            i = lodGroup[i];
+        }
+        return i;
+    };
+    FindPairs(margins.data());
+    for(const auto& pair : pairs){
+        if(bodies[pair.first]->inverseMass == 0.0f || bodies[pair.second]->inverseMass == 0.0f) continue;
+        int a = find(pair.first);
+        int b = find(pair.second);
+        if(a == b) continue;
+        if(b < a) std::swap(a, b);
+        lodGroup[b] = a;
+        lodGroupRate[a] = std::min(lodGroupRate[a], lodGroupRate[b]);
+    }
+
+    for(int i = 0; i < count; i++)
+        bodies[i]->simulationRate = lodGroupRate[find(i)];
+}
+
+// Everything in a step that works on the body list: forces, integration,
+// collisions, bullets and sleep. forceSpeculative is for the long steps of
+// coarse LOD rates, where fast bodies would otherwise tunnel
+void PhysicsWorld::SimulateBodies(float deltaTime, int maxPasses, bool forceSpeculative){
+    // Apply Force Generators. Each body takes them in order, so the sums match
+    // the serial loop; different bodies may be handled on different threads
+    int bodyCount = static_cast<int>(bodies.size());
+    if(!forceGenerators.empty()){
+        ParallelFor(bodyCount, [&](int begin, int end){
+            for(int i = begin; i < end; i++){
+                RigidBody* body = bodies[i];
+                if(body->isSleeping) continue;
+                for(ForceGenerator* fg : forceGenerators)
+                    fg->Apply(*body);
+            }
+        });
+    }
+
+    // Bullets remember where they started so SolveContinuous can sweep them
+    bulletSweeps.clear();
+    for(int i = 0; i < static_cast<int>(bodies.size()); i++){
+        const RigidBody* body = bodies[i];
+        if(!body->isBullet || body->isSleeping || body->inverseMass == 0.0f || !body->collider ||
+           body->collider->isSensor) continue;
+        bulletSweeps.emplace_back(i, Sweep{body->position, body->position, body->orientation, body->orientation});
+    }
+
+    if(substeps > 0){
+        // Soft step: one collision pass, then integrate and solve in substeps.
+        // Contacts are only found once, so bodies woken by a contact need their
+        // own contacts (e.g. with the sleeping ground) found before solving
+        FindPairs();
+        FindContacts();
+        while(WakeContacts())
+            FindContacts();
+        stepStats.iterations = std::min(substeps, maxPasses);
+        stepStats.contactCount = static_cast<int>(contacts.size());
+        substepSolver.Step(bodies, contacts, deltaTime, stepStats.iterations);
+        if(contactEventsEnabled){
+            contactImpulses.resize(contacts.size());
+            for(size_t i = 0; i < contacts.size(); i++)
+                contactImpulses[i] = substepSolver.GetNormalImpulse(static_cast<int>(i));
+            RecordContactEvents(contactImpulses.data());
+        }
+    } else if(speculative || forceSpeculative){
+        // Speculative contacts: update velocities first, then find contacts at the
+        // current positions with each body's reach over the step as margin, so
+        // the solver can stop bodies before they pass through each other. One
+        // broadphase pass; the narrowphase reruns to see the position corrections
+        margins.resize(bodies.size());
+        ParallelFor(bodyCount, [&](int begin, int end){
+            for(int i = begin; i < end; i++){
+                bodies[i]->IntegrateVelocity(deltaTime);
+                margins[i] = SpeculativeMargin(*bodies[i], deltaTime);
+            }
+        });
+        FindPairs(margins.data());
+
+        int passes = std::min(iterations, maxPasses);
+        for(int it = 0; it < passes; it++){
+            FindContacts(margins.data());
+            float* impulses = nullptr;
+            if(contactEventsEnabled){
+                contactImpulses.resize(contacts.size());
+                impulses = contactImpulses.data();
+            }
+            stepStats.residual = solver.Solve(contacts, static_cast<int>(bodies.size()), deltaTime, impulses);
+            if(contactEventsEnabled) RecordContactEvents(impulses);
+            stepStats.iterations++;
+            stepStats.contactCount = static_cast<int>(contacts.size());
+            if(residualTolerance > 0.0f && stepStats.residual <= residualTolerance) break;
+        }
+
+        ParallelFor(bodyCount, [&](int begin, int end){
+            for(int i = begin; i < end; i++)
+                bodies[i]->IntegratePosition(deltaTime);
+        });
+    } else {
+        // Integrate motion
+        ParallelFor(bodyCount, [&](int begin, int end){
+            for(int i = begin; i < end; i++)
+                bodies[i]->Integrate(deltaTime);
+        });
+
+        // Collision detection and resolution, until the contacts stop changing
+        int passes = std::min(iterations, maxPasses);
+        for(int it = 0; it < passes; it++){
+            FindPairs();
+            FindContacts();
+            float* impulses = nullptr;
+            if(contactEventsEnabled){
+                contactImpulses.resize(contacts.size());
+                impulses = contactImpulses.data();
+            }
+            stepStats.residual = solver.Solve(contacts, static_cast<int>(bodies.size()), deltaTime, impulses);
+            if(contactEventsEnabled) RecordContactEvents(impulses);
+            stepStats.iterations++;
+            stepStats.contactCount = static_cast<int>(contacts.size());
+            if(residualTolerance > 0.0f && stepStats.residual <= residualTolerance) break;
+        }
+    }
+
+    if(!bulletSweeps.empty())
+        SolveContinuous(deltaTime);
+
+    // Sleep detection on the solved velocities, so bodies held still by
+    // contacts count as resting (use lengthSquared to avoid sqrt)
+    float sleepThresholdSq = Config::SleepVelocityThreshold * Config::SleepVelocityThreshold;
+    ParallelFor(bodyCount, [&](int begin, int end){
+        for(int i = begin; i < end; i++){
+            RigidBody* body = bodies[i];
+            if(body->isSleeping) continue;
+            if(body->velocity.lengthSquared() < sleepThresholdSq &&
+               std::abs(body->angularVelocity) < Config::SleepVelocityThreshold){
+                body->sleepTime += deltaTime;
+                if(body->sleepTime >= Config::SleepTimeThreshold){
+                    body->isSleeping = true;
+                    body->velocity = Vector2(0,0);
+                    body->angularVelocity = 0.0f;
+                }
+            } else {
+                body->sleepTime = 0.0f;
+            }
+        }
+    });
 }
\ No newline at end of file
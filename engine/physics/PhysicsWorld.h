@@ -1,28 +1,206 @@
 #pragma once
+#include<memory>
+#include<unordered_set>
 #include<vector>
 #include "RigidBody.h"
 #include "../forces/ForceGenerator.h"
 #include "SpatialHash.h"
+#include "CommandBuffer.h"
+#include "SnapshotRing.h"
+#include "../collision/Narrowphase.h"
+#include "../collision/TerrainCollision.h"
+#include "../collision/ContactSolver.h"
+#include "SubstepSolver.h"
+#include "ContactEvents.h"
+#include "../collision/TimeOfImpact.h"
+#include "../particles/ParticleSystem.h"
+#include "../core/Config.h"
+#include "../core/JobSystem.h"
+
+class SharedTransformExporter;
+
+// What the last Step did
+struct StepStats{
+    int iterations = 0;     // Solver passes run (substeps in substep mode)
+    float residual = 0.0f;  // Largest normal velocity change in the last pass, pixels/s
+    int contactCount = 0;
+};
+
+// What the last Advance did. When the frame budget runs short the world first
+// lowers the solver passes per step, then drops simulated time outright.
+struct AdvanceStats{
+    int steps = 0;
+    int iterationCap = 0;       // Fewest passes a step was allowed, the configured count if not degraded
+    float droppedTime = 0.0f;   // Simulated seconds skipped to stay within the budget
+    float elapsed = 0.0f;       // Wall-clock seconds spent
+    bool degraded = false;
+};
 
 class PhysicsWorld{
     public:
         void AddBody(RigidBody* body);
+        void AddBodies(RigidBody* const* newBodies, int count);
+        void RemoveBody(RigidBody* body);
         void AddForceGenerator(class ForceGenerator* fg);
         void Step(float deltaTime);
+        // Fixed-timestep driver: accumulates frameTime (clamped to Time::MaxFrameTime)
+        // and runs as many Time::FixedDeltaTime steps as fit, within the frame budget if set
+        AdvanceStats Advance(float frameTime);
         int GetBodyCount() const { return bodies.size(); }
+        // Bodies stay in the order they were added (removals close the gap),
+        // unless SetBodyReordering is on
         RigidBody* GetBody(int index) const { return bodies[index]; }
+        uint64_t GetStepCount() const { return stepCount; }
+        int GetForceGeneratorCount() const { return forceGenerators.size(); }
+        ForceGenerator* GetForceGenerator(int index) const { return forceGenerators[index]; }
+
+        // Thread-safe queue of mutations, applied at the start of the next Step
+        CommandBuffer& GetCommandBuffer() { return commandBuffer; }
+
+        // Rollback support: SaveState returns a tick that RestoreState can return to.
+        // Adding or removing bodies starts a new history. Particles, the substep
+        // solver's warm-start cache and the contact event pairs are saved along
+        // with the bodies; undrained events of the steps rolled back are dropped.
+        void SetSnapshotCapacity(int count) { snapshots.SetCapacity(count); }
+        int SaveState();
+        bool RestoreState(int tick);
+
+        // Lightweight round particles stepped after the rigid bodies
+        ParticleSystem& GetParticles() { return particles; }
+        const ParticleSystem& GetParticles() const { return particles; }
+
+        // Contact events (off by default): begin / persist / end for every pair of
+        // bodies that touch, including sensor overlaps, collected each step until
+        // drained. Turning them off forgets the pairs and any undrained events
+        void SetContactEvents(bool enabled);
+        void DrainContactEvents(std::vector<ContactEvent>& out) { contactEvents.Drain(out); }
+        const std::vector<ContactEvent>& GetContactEvents() const { return contactEvents.GetEvents(); }
+
+        // Optional: publish body transforms to shared memory after every Step
+        void SetTransformExporter(SharedTransformExporter* exporter) { transformExporter = exporter; }
         
         // Performance settings
         void SetIterations(int iterations) { this->iterations = iterations; }
         void SetUseSpatialHash(bool use) { useSpatialHash = use; }
+        // Keep the body list sorted along a Morton curve of the hash cells, so
+        // bodies that are close in space are close in the per-body arrays. Off by
+        // default: once on, GetBody(i) and WorldBatch rows change order over time
+        void SetBodyReordering(bool enabled) { reorderBodies = enabled; }
+        // Worker threads for forces, integration, broadphase bounds, the narrowphase,
+        // the graph-coloured parallel solver and particles; 0 runs everything on the caller
+        void SetWorkerThreads(int count);
+        // Share a job system owned elsewhere (e.g. with the game's own jobs) instead
+        // of starting threads; must outlive its use here. Null runs serially
+        void SetJobSystem(JobSystem* jobs);
+        JobSystem* GetJobSystem() const { return jobs; }
+        // Above zero, detects contacts once per step and solves them with soft
+        // constraints over this many substeps instead of the iterations loop
+        void SetSubsteps(int count) { substeps = count; }
+        int GetSubsteps() const { return substeps; }
+        // Find contacts before bodies move, padded by how far they can travel, and
+        // only act on the gaps that would close this step. Stops tunnelling without
+        // substeps or sweeps; ignored in substep mode
+        void SetSpeculativeContacts(bool enabled) { speculative = enabled; }
+        // Level of detail: while there are focus points (cameras, players), bodies
+        // farther than halfRate from all of them are stepped every 2nd step and
+        // beyond quarterRate every 4th, each time over the steps they skipped
+        // (with speculative contacts, as those steps are long). Bodies that
+        // could touch share the fastest rate of their group
+        void SetFocusPoints(const std::vector<Vector2>& points) { focusPoints = points; }
+        void SetLodDistances(float halfRate, float quarterRate) { lodHalfRateDistance = halfRate; lodQuarterRateDistance = quarterRate; }
+        // Solver passes stop early once the residual falls to this (pixels/s); 0 always runs them all
+        void SetResidualTolerance(float tolerance) { residualTolerance = tolerance; }
+        // Wall-clock seconds Advance may spend per call; 0 means unlimited
+        void SetFrameBudget(float seconds) { frameBudget = seconds; }
+        const StepStats& GetStepStats() const { return stepStats; }
+        const AdvanceStats& GetAdvanceStats() const { return advanceStats; }
+        // Simulated time waiting in the Advance accumulator, for render interpolation
+        float GetAccumulator() const { return accumulator; }
         
     private:
+        void FlushCommands();
+        void Simulate(float deltaTime, int maxPasses);
+        void SimulateBodies(float deltaTime, int maxPasses, bool forceSpeculative = false);
+        void AssignRates(float deltaTime);
+        void FindPairs(const float* margins = nullptr);
+        void FindContacts(const float* margins = nullptr);
+        void FindTerrainBodies();
+        void CollideTerrain(const float* margins);
+        void RecordContactEvents(const float* impulses);
+        void ReorderBodies();
+        bool WakeContacts();
+        void SolveContinuous(float deltaTime);
+        void AssignId(RigidBody* body);
+
+        // Runs body(begin, end) over [0, count) on the job system, or inline without
+        // one (without wrapping it in a std::function). Used for per-body work, so
+        // results don't depend on the thread count
+        template<class Body>
+        void ParallelFor(int count, const Body& body){
+            if(jobs)
+                jobs->ParallelFor(count, BodyGrainSize, body);
+            else if(count > 0)
+                body(0, count);
+        }
+
         // Internal data structures for physics bodies would go here
         std::vector<RigidBody*> bodies;
         std::vector<ForceGenerator*> forceGenerators;
         SpatialHash spatialHash;
+        Narrowphase narrowphase;
+        TerrainCollision terrainCollision;
+        std::vector<int> terrainBodies;
+        ContactSolver solver;
+        SubstepSolver substepSolver;
+        std::vector<std::pair<int, int>> pairs;
+        std::vector<Contact> contacts;
+        std::vector<Contact> sensorContacts;    // Overlaps with sensors, kept out of the solver
+        std::vector<float> contactImpulses;
+        ContactEventStream contactEvents;
+        std::vector<std::pair<int, Sweep>> bulletSweeps;
+        std::vector<int> candidates;
+        std::vector<float> margins;
+        std::vector<AABB> bodyBounds;
+        std::vector<std::pair<uint64_t, int>> bodyOrder;
+        std::vector<RigidBody*> reorderedBodies;
+        std::vector<int> newBodyIndex;
+        std::vector<Vector2> focusPoints;
+        std::vector<RigidBody*> lodBodies;
+        std::vector<int> lodGroup;
+        std::vector<int> lodGroupRate;
+        CommandBuffer commandBuffer;
+        SnapshotRing snapshots;
+        std::vector<SubstepSolver::CacheState> solverStates;   // Per snapshot slot
+        std::vector<ParticleSystem::State> particleStates;     // Per snapshot slot
+        std::vector<ContactEventStream::State> contactEventStates;  // Per snapshot slot
+        ParticleSystem particles;
+        uint32_t nextBodyId = 0;
+        uint64_t stepCount = 0;
+        SharedTransformExporter* transformExporter = nullptr;
+        std::unique_ptr<JobSystem> ownedJobs;
+        JobSystem* jobs = nullptr;
+        std::vector<WorldCommand> pendingCommands;
+        std::unordered_set<const RigidBody*> members;          // Everything in bodies
+        std::unordered_set<const RigidBody*> pendingRemovals;  // In bodies, removed by this batch
+        std::vector<RigidBody*> pendingAdds;
+        std::unordered_set<const RigidBody*> pendingAddSet;    // pendingAdds still added
         
         // Performance settings
         int iterations = 4; // Reduced from 8
         bool useSpatialHash = true;
+        bool reorderBodies = false;
+        float lodHalfRateDistance = Config::LodHalfRateDistance;
+        float lodQuarterRateDistance = Config::LodQuarterRateDistance;
+        int substeps = 0;
+        bool speculative = false;
+        bool contactEventsEnabled = false;
+        float residualTolerance = Config::SolverResidualTolerance;
+        float frameBudget = 0.0f;
+        static constexpr int BodyGrainSize = 128;
+
+        // Fixed-timestep state
+        float accumulator = 0.0f;
+        float passCost = 0.0f;  // Seconds per solver pass measured on the last advanced step
+        StepStats stepStats;
+        AdvanceStats advanceStats;
 };
\ No newline at end of file
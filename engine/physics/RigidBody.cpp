@@ -1,5 +1,6 @@
 #include "RigidBody.h"
 #include "../shapes/CircleShape.h"
+#include "../shapes/PolygonShape.h"
 
 RigidBody::RigidBody(float m):mass(m), position(), velocity(), force(){
     if(mass > 0)
@@ -14,7 +15,18 @@ void RigidBody::ApplyForce(const Vector2& f){
     force += f;
 }
 
+void RigidBody::ApplyImpulse(const Vector2& impulse){
+    sleepTime = 0.0f;
+    isSleeping = false;
+    velocity += impulse * inverseMass;
+}
+
 void RigidBody::Integrate(float deltaTime){
+    IntegrateVelocity(deltaTime);
+    IntegratePosition(deltaTime);
+}
+
+void RigidBody::IntegrateVelocity(float deltaTime){
     if(inverseMass<=0.0f) return;
 
     if(isSleeping) return;
@@ -31,17 +43,23 @@ void RigidBody::Integrate(float deltaTime){
     const float angularEpsilon = 0.05f; // Increased threshold
     if (std::abs(angularVelocity) < angularEpsilon)
         angularVelocity = 0.0f;
-    
-    orientation += angularVelocity * deltaTime;
 
     // Update velocity
     Vector2 acceleration = force * inverseMass;
     velocity += acceleration * deltaTime;
-    position += velocity * deltaTime;
     // Clear force
     ClearForces();
 }
 
+void RigidBody::IntegratePosition(float deltaTime){
+    if(inverseMass<=0.0f) return;
+
+    if(isSleeping) return;
+
+    orientation += angularVelocity * deltaTime;
+    position += velocity * deltaTime;
+}
+
 void RigidBody::ClearForces() { 
     force = Vector2(0,0); 
     torque = 0.0f; 
@@ -76,6 +94,13 @@ void RigidBody::SetInverseInertia(ShapeType type){
             inverseInertia = 1.0f / I;
         else
             inverseInertia = 0.0f;
+    } else if(type == ShapeType::Polygon){
+        auto* polygon = static_cast<PolygonShape*>(collider->shape);
+        float I = mass * polygon->unitInertia;
+        if(I > 0)
+            inverseInertia = 1.0f / I;
+        else
+            inverseInertia = 0.0f;
     } else {
         inverseInertia = 0.0f;
     }
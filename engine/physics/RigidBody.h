@@ -1,9 +1,13 @@
 #pragma once
 #include "../math/Vector2.h"
 #include "../collision/Collider.h"
+#include <cstdint>
+
+constexpr uint32_t InvalidBodyId = 0xFFFFFFFFu;
 
 class RigidBody{
     public:
+    uint32_t id = InvalidBodyId; // Assigned by PhysicsWorld when the body is added
     Vector2 size;
     Vector2 position;
     Vector2 velocity;
@@ -20,6 +24,12 @@ class RigidBody{
     bool isSleeping = false;
     float sleepTime = 0.0f;
 
+    // Fast body: swept against the world each step so it can't tunnel (see TimeOfImpact.h)
+    bool isBullet = false;
+
+    // Steps between updates under level of detail (1, 2 or 4), set by the world
+    int simulationRate = 1;
+
     float linearDamping = 0.995f;
     float angularDamping = 0.96f; // Stronger damping to stop spinning faster
 
@@ -28,9 +38,13 @@ class RigidBody{
     RigidBody(float m=1.0f);
 
     void ApplyForce(const Vector2& f);
+    void ApplyImpulse(const Vector2& impulse);
     void ApplyForceAtPoint(const Vector2& f, const Vector2& point);
     void ApplyTorque(float t);
     void Integrate(float deltaTime);
+    // The two halves of Integrate, for solvers that work on velocities between them
+    void IntegrateVelocity(float deltaTime);
+    void IntegratePosition(float deltaTime);
     void SetInverseInertia(ShapeType type);
     void ClearForces();
 };
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "SnapshotRing.h"
+#include <algorithm>
+#include <cstring>
+
+static_assert(sizeof(BodyState) == 48, "BodyState must not contain padding");
+
+BodyState BodyState::Capture(const RigidBody& body){
+    BodyState state;
+    state.position = body.position;
+    state.velocity = body.velocity;
+    state.force = body.force;
+    state.orientation = body.orientation;
+    state.angularVelocity = body.angularVelocity;
+    state.torque = body.torque;
+    state.sleepTime = body.sleepTime;
+    state.isSleeping = body.isSleeping ? 1u : 0u;
+    state.simulationRate = static_cast<uint32_t>(body.simulationRate);
+    return state;
+}
+
+void BodyState::Apply(RigidBody& body) const{
+    body.position = position;
+    body.velocity = velocity;
+    body.force = force;
+    body.orientation = orientation;
+    body.angularVelocity = angularVelocity;
+    body.torque = torque;
+    body.sleepTime = sleepTime;
+    body.isSleeping = isSleeping != 0;
+    body.simulationRate = static_cast<int>(simulationRate);
+}
+
+// Sleeping bodies are frozen, so a body asleep in both places at the same
+// pose, sleep time and rate is identical without a full comparison
+static bool SameSleepingBody(const RigidBody& body, const BodyState& state){
+    return body.isSleeping && state.isSleeping &&
+           static_cast<uint32_t>(body.simulationRate) == state.simulationRate &&
+           std::memcmp(&body.position, &state.position, sizeof(Vector2)) == 0 &&
+           std::memcmp(&body.orientation, &state.orientation, sizeof(float)) == 0 &&
+           std::memcmp(&body.sleepTime, &state.sleepTime, sizeof(float)) == 0;
+}
+
+void SnapshotRing::SetCapacity(int snapshotCount){
+    slots.assign(std::max(snapshotCount, 1), Snapshot());
+    Reset();
+}
+
+void SnapshotRing::Reset(){
+    count = 0;
+    latest.clear();
+}
+
+int SnapshotRing::Save(const std::vector<RigidBody*>& bodies, uint64_t stepCount){
+    if(slots.empty())
+        SetCapacity(8);
+
+    int tick = latestTick + 1;
+    Snapshot& slot = SlotFor(tick);
+    slot.changes.clear();
+    slot.orderBefore.clear();
+    slot.stepCount = stepCount;
+
+    if(count == 0 || latest.size() != bodies.size()){
+        // First snapshot, or bodies were added/removed: start a new history
+        count = 0;
+        latest.resize(bodies.size());
+        for(size_t i = 0; i < bodies.size(); i++)
+            latest[i] = BodyState::Capture(*bodies[i]);
+        latestOrder = bodies;
+    } else {
+        // Reordered since the last snapshot (Remap has already moved latest)
+        if(bodies != latestOrder){
+            slot.orderBefore = latestOrder;
+            latestOrder = bodies;
+        }
+
+        for(size_t i = 0; i < bodies.size(); i++){
+            const RigidBody& body = *bodies[i];
+            if(SameSleepingBody(body, latest[i])) continue;
+
+            BodyState state = BodyState::Capture(body);
+            if(std::memcmp(&state, &latest[i], sizeof(BodyState)) != 0){
+                slot.changes.push_back({static_cast<int>(i), latest[i], state});
+                latest[i] = state;
+            }
+        }
+    }
+
+    latestTick = tick;
+    count = std::min(count + 1, static_cast<int>(slots.size()));
+    return tick;
+}
+
+bool SnapshotRing::Restore(int tick, std::vector<RigidBody*>& bodies, uint64_t& stepCount){
+    if(count == 0 || tick < GetOldestTick() || tick > latestTick)
+        return false;
+    if(latest.size() != bodies.size())
+        return false;
+
+    // Undo newer snapshots, newest first. The oldest reorder undone gives
+    // the list order at tick (the world may also have reordered since the
+    // latest Save)
+    bool reordered = bodies != latestOrder;
+    if(reordered)
+        restoredOrder = latestOrder;
+    for(int t = latestTick; t > tick; t--){
+        const Snapshot& slot = SlotFor(t);
+        for(auto it = slot.changes.rbegin(); it != slot.changes.rend(); ++it)
+            latest[it->index] = it->before;
+        if(!slot.orderBefore.empty()){
+            restoredOrder = slot.orderBefore;
+            reordered = true;
+        }
+    }
+
+    count -= latestTick - tick;
+    latestTick = tick;
+    stepCount = SlotFor(tick).stepCount;
+
+    if(reordered){
+        // Move the remaining history and the list back to the old order
+        int n = static_cast<int>(bodies.size());
+        positions.resize(n);
+        for(int i = 0; i < n; i++)
+            positions[i] = {bodies[i], i};
+        std::sort(positions.begin(), positions.end());
+        newIndex.resize(n);
+        for(int i = 0; i < n; i++){
+            auto it = std::lower_bound(positions.begin(), positions.end(), std::make_pair(restoredOrder[i], 0));
+            newIndex[it->second] = i;
+        }
+        Remap(newIndex);
+        bodies = restoredOrder;
+        latestOrder = restoredOrder;
+    }
+
+    for(size_t i = 0; i < bodies.size(); i++){
+        if(SameSleepingBody(*bodies[i], latest[i])) continue;
+        latest[i].Apply(*bodies[i]);
+    }
+    return true;
+}
+
+void SnapshotRing::Remap(const std::vector<int>& newIndex){
+    if(count == 0 || latest.size() != newIndex.size())
+        return;
+
+    remapped.resize(latest.size());
+    for(size_t i = 0; i < latest.size(); i++)
+        remapped[newIndex[i]] = latest[i];
+    latest.swap(remapped);
+
+    for(int t = GetOldestTick(); t <= latestTick; t++){
+        for(Change& change : SlotFor(t).changes)
+            change.index = newIndex[change.index];
+    }
+}
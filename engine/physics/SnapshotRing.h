@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "RigidBody.h"
+
+// Everything Step reads back from a body. All fields are 32-bit so states can
+// be compared bit-for-bit with memcmp.
+struct BodyState{
+    Vector2 position;
+    Vector2 velocity;
+    Vector2 force;
+    float orientation;
+    float angularVelocity;
+    float torque;
+    float sleepTime;
+    uint32_t isSleeping;
+    uint32_t simulationRate;
+
+    static BodyState Capture(const RigidBody& body);
+    void Apply(RigidBody& body) const;
+};
+
+// Fixed-capacity history of world states for rollback. Each snapshot stores only
+// the bodies that changed since the previous one, with their old and new state,
+// so restoring walks back from the latest snapshot undoing changes. The order
+// of the body list and the world's step count are part of the state too: the
+// world re-sorts its list, and contact order depends on it.
+class SnapshotRing{
+    public:
+        void SetCapacity(int snapshotCount);
+        void Reset();
+
+        // Record the current state and return its tick number
+        int Save(const std::vector<RigidBody*>& bodies, uint64_t stepCount);
+        // Put every body, the list order and the step count back to the state
+        // saved at tick. Snapshots newer than tick are discarded, so
+        // resimulation can Save over them again.
+        bool Restore(int tick, std::vector<RigidBody*>& bodies, uint64_t& stepCount);
+        // The world reordered its bodies: body i now sits at newIndex[i]
+        void Remap(const std::vector<int>& newIndex);
+
+        int GetCapacity() const { return static_cast<int>(slots.size()); }
+        int GetOldestTick() const { return count > 0 ? latestTick - count + 1 : -1; }
+        int GetLatestTick() const { return count > 0 ? latestTick : -1; }
+
+    private:
+        struct Change{
+            int index;
+            BodyState before;
+            BodyState after;
+        };
+
+        struct Snapshot{
+            std::vector<Change> changes;
+            std::vector<RigidBody*> orderBefore;    // List order before this tick, if it changed
+            uint64_t stepCount = 0;
+        };
+
+        Snapshot& SlotFor(int tick) { return slots[tick % slots.size()]; }
+
+        std::vector<Snapshot> slots;
+        std::vector<BodyState> latest; // World state at latestTick
+        std::vector<BodyState> remapped;
+        std::vector<RigidBody*> latestOrder;   // Body list at latestTick
+        std::vector<RigidBody*> restoredOrder;
+        std::vector<std::pair<RigidBody*, int>> positions;
+        std::vector<int> newIndex;
+        int latestTick = -1;
+        int count = 0;
+};
@@ -1,25 +1,41 @@
 #pragma once
-#include <unordered_map>
 #include <vector>
 #include <cmath>
 #include <algorithm>
 #include "RigidBody.h"
+#include "../math/MathUtils.h"
 #include "../collision/AABBCollider.h"
 #include "../shapes/AABBShape.h"
 #include "../shapes/CircleShape.h"
+#include "../shapes/PolygonShape.h"
 
-// Simple spatial hash for broad-phase collision detection
+// Uniform grid for broad-phase collision detection. Insert records one
+// (cell, body) entry per cell a body's bounds touch, and the entries are
+// sorted by cell before pairs or queries are read from them. The entry list
+// keeps its storage across Clear, so a hash rebuilt every step stops
+// allocating once it has grown to the scene.
 class SpatialHash {
 public:
     SpatialHash(float cellSize = 100.0f) : cellSize(cellSize) {}
 
     void Clear() {
-        grid.clear();
+        entries.clear();
+        sorted = true;
     }
 
-    void Insert(RigidBody* body, int index) {
-        AABB bounds = GetBodyAABB(body);
-        
+    // Pre-size the entry list for a known body count so bulk inserts don't grow it
+    void Reserve(size_t bodyCount) {
+        entries.reserve(bodyCount * 2);
+    }
+
+    // margin grows the body's bounds on every side (speculative contacts)
+    void Insert(RigidBody* body, int index, float margin = 0.0f) {
+        Insert(GetBodyAABB(body, margin), index);
+    }
+
+    // Insert bounds computed ahead of time, e.g. in parallel with GetBodyAABB
+    void Insert(const AABB& bounds, int index) {
+        if (bounds.min.x > bounds.max.x) return;    // Empty (terrain)
         int minX = static_cast<int>(std::floor(bounds.min.x / cellSize));
         int minY = static_cast<int>(std::floor(bounds.min.y / cellSize));
         int maxX = static_cast<int>(std::floor(bounds.max.x / cellSize));
@@ -27,20 +43,25 @@ public:
 
         for (int y = minY; y <= maxY; y++) {
             for (int x = minX; x <= maxX; x++) {
-                long long key = GetKey(x, y);
-                grid[key].push_back(index);
+                entries.push_back({GetKey(x, y), index});
             }
         }
+        sorted = false;
     }
 
-    std::vector<std::pair<int, int>> GetPotentialCollisions(const std::vector<RigidBody*>& bodies) {
-        std::vector<std::pair<int, int>> pairs;
-        
-        for (auto& [key, indices] : grid) {
-            for (size_t i = 0; i < indices.size(); i++) {
-                for (size_t j = i + 1; j < indices.size(); j++) {
-                    int idxA = indices[i];
-                    int idxB = indices[j];
+    // Every pair of bodies sharing a cell, each once, sorted (into pairs)
+    void GetPotentialCollisions(std::vector<std::pair<int, int>>& pairs) {
+        Sort();
+        pairs.clear();
+
+        for (size_t begin = 0; begin < entries.size();) {
+            size_t end = begin + 1;
+            while (end < entries.size() && entries[end].key == entries[begin].key) end++;
+
+            for (size_t i = begin; i < end; i++) {
+                for (size_t j = i + 1; j < end; j++) {
+                    int idxA = entries[i].index;
+                    int idxB = entries[j].index;
                     
                     // Ensure we don't duplicate pairs
                     if (idxA < idxB) {
@@ -48,28 +69,66 @@ public:
                     }
                 }
             }
+            begin = end;
         }
         
         // Remove duplicates (bodies in multiple cells)
         std::sort(pairs.begin(), pairs.end());
         pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
-        
-        return pairs;
     }
 
-private:
-    float cellSize;
-    std::unordered_map<long long, std::vector<int>> grid;
+    // Indices of the bodies inserted into any cell that bounds touches, each once
+    void Query(const AABB& bounds, std::vector<int>& indices) {
+        Sort();
+        indices.clear();
 
-    long long GetKey(int x, int y) const {
-        return (static_cast<long long>(x) << 32) | (static_cast<long long>(y) & 0xFFFFFFFF);
+        int minX = static_cast<int>(std::floor(bounds.min.x / cellSize));
+        int minY = static_cast<int>(std::floor(bounds.min.y / cellSize));
+        int maxX = static_cast<int>(std::floor(bounds.max.x / cellSize));
+        int maxY = static_cast<int>(std::floor(bounds.max.y / cellSize));
+
+        // Long sweeps can cover more cells than there are entries; walk whichever is smaller
+        double cellCount = (static_cast<double>(maxX) - minX + 1) * (static_cast<double>(maxY) - minY + 1);
+        if (cellCount > static_cast<double>(entries.size())) {
+            for (const Entry& entry : entries) {
+                int x = static_cast<int>(entry.key >> 32);
+                int y = static_cast<int>(entry.key & 0xFFFFFFFF);
+                if (x >= minX && x <= maxX && y >= minY && y <= maxY)
+                    indices.push_back(entry.index);
+            }
+        } else {
+            for (int y = minY; y <= maxY; y++) {
+                for (int x = minX; x <= maxX; x++) {
+                    Entry probe{GetKey(x, y), 0};
+                    auto it = std::lower_bound(entries.begin(), entries.end(), probe);
+                    for (; it != entries.end() && it->key == probe.key; ++it)
+                        indices.push_back(it->index);
+                }
+            }
+        }
+
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    }
+
+    // Morton code of the cell holding point; nearby cells get nearby codes
+    uint64_t GetCellCode(const Vector2& point) const {
+        // Bias to unsigned so negative cells sort before positive ones
+        uint32_t x = static_cast<uint32_t>(static_cast<int>(std::floor(point.x / cellSize))) ^ 0x80000000u;
+        uint32_t y = static_cast<uint32_t>(static_cast<int>(std::floor(point.y / cellSize))) ^ 0x80000000u;
+        return MortonCode(x, y);
     }
 
-    AABB GetBodyAABB(RigidBody* body) {
+    static AABB GetBodyAABB(const RigidBody* body, float margin = 0.0f) {
         AABB aabb;
         
         if (body->collider && body->collider->shape) {
-            if (body->collider->shape->GetType() == ShapeType::AABB) {
+            if (body->collider->shape->IsTerrain()) {
+                // Terrain stays out of the grid; the world collides it separately
+                aabb.min = Vector2(1, 1);
+                aabb.max = Vector2(-1, -1);
+                return aabb;
+            } else if (body->collider->shape->GetType() == ShapeType::AABB) {
                 auto* shape = static_cast<AABBShape*>(body->collider->shape);
                 aabb.min = body->position - shape->halfsize;
                 aabb.max = body->position + shape->halfsize;
@@ -78,6 +137,12 @@ private:
                 Vector2 radius(shape->radius, shape->radius);
                 aabb.min = body->position - radius;
                 aabb.max = body->position + radius;
+            } else if (body->collider->shape->GetType() == ShapeType::Polygon) {
+                // Bounding circle, so the bounds hold at any orientation
+                auto* shape = static_cast<PolygonShape*>(body->collider->shape);
+                Vector2 radius(shape->radius, shape->radius);
+                aabb.min = body->position - radius;
+                aabb.max = body->position + radius;
             }
         } else {
             // Fallback to body.size
@@ -85,7 +150,33 @@ private:
             aabb.min = body->position - halfSize;
             aabb.max = body->position + halfSize;
         }
-        
+
+        aabb.min -= Vector2(margin, margin);
+        aabb.max += Vector2(margin, margin);
         return aabb;
     }
+
+private:
+    struct Entry {
+        long long key;
+        int index;
+
+        bool operator<(const Entry& other) const {
+            return key != other.key ? key < other.key : index < other.index;
+        }
+    };
+
+    void Sort() {
+        if (!sorted)
+            std::sort(entries.begin(), entries.end());
+        sorted = true;
+    }
+
+    float cellSize;
+    std::vector<Entry> entries;
+    bool sorted = true;
+
+    long long GetKey(int x, int y) const {
+        return (static_cast<long long>(x) << 32) | (static_cast<long long>(y) & 0xFFFFFFFF);
+    }
 };
@@ -0,0 +1,286 @@
+#include "SubstepSolver.h"
+#include "RigidBody.h"
+#include "../collision/Collider.h"
+#include "../core/Config.h"
+#include <algorithm>
+#include <cmath>
+
+static const float Pi = 3.14159265f;
+
+// Velocity of the material point at offset r from the centre
+static Vector2 PointVelocity(const RigidBody& body, const Vector2& r){
+    return body.velocity + Vector2(-body.angularVelocity * r.y, body.angularVelocity * r.x);
+}
+
+SubstepSolver::ImpulseCacheKey SubstepSolver::CacheKey(const Contact& contact){
+    return {static_cast<uint64_t>(contact.a->id) << 32 | contact.b->id, contact.part};
+}
+
+static void ApplyImpulseAt(RigidBody& body, const Vector2& impulse, const Vector2& r){
+    if(body.inverseMass == 0.0f) return;
+    body.velocity += impulse * body.inverseMass;
+    body.angularVelocity += r.cross(impulse) * body.inverseInertia;
+}
+
+void SubstepSolver::Prepare(const std::vector<RigidBody*>& bodies, const std::vector<Contact>& contacts){
+    constraints.resize(contacts.size());
+    motion.assign(bodies.size(), BodyMotion{Vector2(), 0.0f, 1.0f, 0.0f});
+
+    for(size_t i = 0; i < contacts.size(); i++){
+        const Contact& contact = contacts[i];
+        const RigidBody& a = *contact.a;
+        const RigidBody& b = *contact.b;
+        Constraint& c = constraints[i];
+
+        c.indexA = contact.indexA;
+        c.indexB = contact.indexB;
+        c.normal = contact.manifold.normal;
+        c.friction = std::sqrt(a.collider->dynamicFriction * b.collider->dynamicFriction);
+        c.restitution = (a.collider->restitution + b.collider->restitution) / 2.0f;
+        c.pointCount = contact.manifold.contactCount;
+
+        // Contacts wake sleeping bodies, as in CollisionResolver
+        if(a.inverseMass > 0.0f) contact.a->isSleeping = false;
+        if(b.inverseMass > 0.0f) contact.b->isSleeping = false;
+
+        // Only contacts that also existed last step are warm started
+        const ImpulseCacheEntry* cached = nullptr;
+        auto found = impulseCache.find(CacheKey(contact));
+        if(found != impulseCache.end() && found->second.lastStep == step - 1)
+            cached = &found->second;
+
+        Vector2 tangent(c.normal.y, -c.normal.x);
+        for(int k = 0; k < c.pointCount; k++){
+            const ContactPoint& cp = contact.manifold.points[k];
+            Point& p = c.points[k];
+            p = Point();
+            for(int j = 0; cached && j < cached->pointCount; j++){
+                if(cached->ids[j] == cp.id){
+                    p.normalImpulse = cached->normalImpulse[j];
+                    p.tangentImpulse = cached->tangentImpulse[j];
+                }
+            }
+            p.anchorA = cp.position - a.position;
+            p.anchorB = cp.position - b.position;
+            p.baseSeparation = -cp.penetration - (p.anchorB - p.anchorA).dot(c.normal);
+
+            float rnA = p.anchorA.cross(c.normal);
+            float rnB = p.anchorB.cross(c.normal);
+            float kNormal = a.inverseMass + b.inverseMass + rnA * rnA * a.inverseInertia + rnB * rnB * b.inverseInertia;
+            p.normalMass = kNormal > 0.0f ? 1.0f / kNormal : 0.0f;
+
+            float rtA = p.anchorA.cross(tangent);
+            float rtB = p.anchorB.cross(tangent);
+            float kTangent = a.inverseMass + b.inverseMass + rtA * rtA * a.inverseInertia + rtB * rtB * b.inverseInertia;
+            p.tangentMass = kTangent > 0.0f ? 1.0f / kTangent : 0.0f;
+
+            p.relativeVelocity = (PointVelocity(b, p.anchorB) - PointVelocity(a, p.anchorA)).dot(c.normal);
+        }
+    }
+}
+
+// Re-apply the impulses accumulated so far, so each substep starts near the solution
+void SubstepSolver::WarmStart(const std::vector<RigidBody*>& bodies){
+    for(Constraint& c : constraints){
+        RigidBody& a = *bodies[c.indexA];
+        RigidBody& b = *bodies[c.indexB];
+        Vector2 tangent(c.normal.y, -c.normal.x);
+        for(int k = 0; k < c.pointCount; k++){
+            const Point& p = c.points[k];
+            Vector2 impulse = c.normal * p.normalImpulse + tangent * p.tangentImpulse;
+            ApplyImpulseAt(a, impulse * -1.0f, p.anchorA);
+            ApplyImpulseAt(b, impulse, p.anchorB);
+        }
+    }
+}
+
+void SubstepSolver::Solve(const std::vector<RigidBody*>& bodies, float inverseH, bool useBias){
+    for(Constraint& c : constraints){
+        RigidBody& a = *bodies[c.indexA];
+        RigidBody& b = *bodies[c.indexB];
+        const BodyMotion& ma = motion[c.indexA];
+        const BodyMotion& mb = motion[c.indexB];
+        Vector2 tangent(c.normal.y, -c.normal.x);
+
+        for(int k = 0; k < c.pointCount; k++){
+            Point& p = c.points[k];
+
+            // Current separation from the motion since detection
+            Vector2 rotatedA(p.anchorA.x * ma.cosDelta - p.anchorA.y * ma.sinDelta,
+                             p.anchorA.x * ma.sinDelta + p.anchorA.y * ma.cosDelta);
+            Vector2 rotatedB(p.anchorB.x * mb.cosDelta - p.anchorB.y * mb.sinDelta,
+                             p.anchorB.x * mb.sinDelta + p.anchorB.y * mb.cosDelta);
+            Vector2 d = (mb.deltaPosition - ma.deltaPosition) + (rotatedB - rotatedA);
+            float separation = d.dot(c.normal) + p.baseSeparation;
+
+            float bias = 0.0f;
+            float mass = 1.0f;
+            float scale = 0.0f;
+            if(separation > 0.0f){
+                // Not touching yet: allow closing the gap within this substep
+                bias = separation * inverseH;
+            } else if(useBias){
+                bias = std::max(biasRate * std::min(separation + linearSlop, 0.0f), -maxPushVelocity);
+                mass = massScale;
+                scale = impulseScale;
+            }
+
+            float vn = (PointVelocity(b, p.anchorB) - PointVelocity(a, p.anchorA)).dot(c.normal);
+            float impulse = -p.normalMass * mass * (vn + bias) - scale * p.normalImpulse;
+            float newImpulse = std::max(p.normalImpulse + impulse, 0.0f);
+            impulse = newImpulse - p.normalImpulse;
+            p.normalImpulse = newImpulse;
+            p.maxNormalImpulse = std::max(p.maxNormalImpulse, impulse);
+            // Each substep applies the whole accumulated impulse (warm start
+            // plus corrections); the relax pass has the final value
+            if(!useBias) p.totalNormalImpulse += newImpulse;
+
+            ApplyImpulseAt(a, c.normal * -impulse, p.anchorA);
+            ApplyImpulseAt(b, c.normal * impulse, p.anchorB);
+        }
+
+        for(int k = 0; k < c.pointCount; k++){
+            Point& p = c.points[k];
+            float vt = (PointVelocity(b, p.anchorB) - PointVelocity(a, p.anchorA)).dot(tangent);
+            float impulse = -p.tangentMass * vt;
+
+            float maxFriction = c.friction * p.normalImpulse;
+            float newImpulse = std::clamp(p.tangentImpulse + impulse, -maxFriction, maxFriction);
+            impulse = newImpulse - p.tangentImpulse;
+            p.tangentImpulse = newImpulse;
+
+            ApplyImpulseAt(a, tangent * -impulse, p.anchorA);
+            ApplyImpulseAt(b, tangent * impulse, p.anchorB);
+        }
+    }
+}
+
+// Bounce once at the end of the step, only for contacts that were closing fast
+void SubstepSolver::ApplyRestitution(const std::vector<RigidBody*>& bodies){
+    for(Constraint& c : constraints){
+        if(c.restitution == 0.0f) continue;
+        RigidBody& a = *bodies[c.indexA];
+        RigidBody& b = *bodies[c.indexB];
+        for(int k = 0; k < c.pointCount; k++){
+            Point& p = c.points[k];
+            if(p.relativeVelocity > -Config::RestitutionVelocityThreshold || p.maxNormalImpulse == 0.0f)
+                continue;
+
+            float vn = (PointVelocity(b, p.anchorB) - PointVelocity(a, p.anchorA)).dot(c.normal);
+            float impulse = -p.normalMass * (vn + c.restitution * p.relativeVelocity);
+            float newImpulse = std::max(p.normalImpulse + impulse, 0.0f);
+            impulse = newImpulse - p.normalImpulse;
+            p.normalImpulse = newImpulse;
+            p.totalNormalImpulse += impulse;
+
+            ApplyImpulseAt(a, c.normal * -impulse, p.anchorA);
+            ApplyImpulseAt(b, c.normal * impulse, p.anchorB);
+        }
+    }
+}
+
+float SubstepSolver::GetNormalImpulse(int contact) const {
+    const Constraint& c = constraints[contact];
+    float total = 0.0f;
+    for(int k = 0; k < c.pointCount; k++)
+        total += c.points[k].totalNormalImpulse;
+    return total;
+}
+
+void SubstepSolver::SaveCache(CacheState& state) const {
+    state.entries.assign(impulseCache.begin(), impulseCache.end());
+    state.step = step;
+}
+
+// Lookups are by key only, so the map's iteration order doesn't matter
+void SubstepSolver::RestoreCache(const CacheState& state){
+    impulseCache.clear();
+    impulseCache.insert(state.entries.begin(), state.entries.end());
+    step = state.step;
+}
+
+void SubstepSolver::StoreImpulses(const std::vector<Contact>& contacts){
+    for(size_t i = 0; i < contacts.size(); i++){
+        const Constraint& c = constraints[i];
+        ImpulseCacheEntry& entry = impulseCache[CacheKey(contacts[i])];
+        entry.pointCount = c.pointCount;
+        entry.lastStep = step;
+        for(int k = 0; k < c.pointCount; k++){
+            entry.ids[k] = contacts[i].manifold.points[k].id;
+            entry.normalImpulse[k] = c.points[k].normalImpulse;
+            entry.tangentImpulse[k] = c.points[k].tangentImpulse;
+        }
+    }
+
+    // Drop pairs that stopped touching
+    if(step % ImpulseCacheSweepInterval == 0){
+        for(auto it = impulseCache.begin(); it != impulseCache.end();){
+            if(step - it->second.lastStep >= ImpulseCacheSweepInterval)
+                it = impulseCache.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+void SubstepSolver::Step(const std::vector<RigidBody*>& bodies, const std::vector<Contact>& contacts,
+                         float deltaTime, int substeps)
+{
+    if(substeps < 1) substeps = 1;
+    float h = deltaTime / substeps;
+    float inverseH = 1.0f / h;
+
+    // Soft constraint coefficients (spring-damper with the given stiffness and damping)
+    float hertz = std::min(contactHertz, 0.25f * inverseH);
+    float omega = 2.0f * Pi * hertz;
+    float a1 = 2.0f * dampingRatio + h * omega;
+    float a2 = h * omega * a1;
+    float a3 = 1.0f / (1.0f + a2);
+    biasRate = omega / a1;
+    massScale = a2 * a3;
+    impulseScale = a3;
+
+    step++;
+    Prepare(bodies, contacts);
+
+    // Damping is applied once per step, as in RigidBody::Integrate
+    for(RigidBody* body : bodies){
+        if(body->isSleeping || body->inverseMass == 0.0f) continue;
+        body->velocity *= body->linearDamping;
+        body->angularVelocity *= body->angularDamping;
+    }
+
+    for(int substep = 0; substep < substeps; substep++){
+        for(RigidBody* body : bodies){
+            if(body->isSleeping || body->inverseMass == 0.0f) continue;
+            body->velocity += body->force * (body->inverseMass * h);
+            body->angularVelocity += body->torque * (body->inverseInertia * h);
+        }
+
+        WarmStart(bodies);
+        Solve(bodies, inverseH, true);
+
+        for(size_t i = 0; i < bodies.size(); i++){
+            RigidBody* body = bodies[i];
+            if(body->isSleeping || body->inverseMass == 0.0f) continue;
+            Vector2 dx = body->velocity * h;
+            float dAngle = body->angularVelocity * h;
+            body->position += dx;
+            body->orientation += dAngle;
+
+            BodyMotion& m = motion[i];
+            m.deltaPosition += dx;
+            m.deltaAngle += dAngle;
+            m.cosDelta = std::cos(m.deltaAngle);
+            m.sinDelta = std::sin(m.deltaAngle);
+        }
+
+        Solve(bodies, inverseH, false);
+    }
+
+    ApplyRestitution(bodies);
+    StoreImpulses(contacts);
+
+    for(RigidBody* body : bodies)
+        body->ClearForces();
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../collision/Contact.h"
+#include "../math/Vector2.h"
+
+class RigidBody;
+
+// Soft-step solver: contacts are detected once per step, then velocities
+// and positions are advanced in several small substeps. Each substep solves
+// the contacts as soft (spring-damper) constraints, integrates positions,
+// then runs a relax pass without the position bias so that pushing bodies
+// apart doesn't add energy. Separation is re-evaluated every substep from
+// how far the bodies moved since detection. Accumulated impulses carry over
+// to the next step by body pair, terrain part (Contact::part) and contact
+// feature id, which is what keeps piles stiff.
+class SubstepSolver{
+    public:
+        // Replaces integration and contact resolution for one step
+        void Step(const std::vector<RigidBody*>& bodies, const std::vector<Contact>& contacts,
+                  float deltaTime, int substeps);
+
+        // Normal impulse the last Step applied to contacts[contact] in total
+        float GetNormalImpulse(int contact) const;
+
+        // Contact stiffness in Hz (capped at a quarter of the substep rate) and damping ratio
+        float contactHertz = 30.0f;
+        float dampingRatio = 10.0f;
+        // Fastest speed (pixels/s) at which overlapping bodies are pushed apart
+        float maxPushVelocity = 150.0f;
+        // Overlap (pixels) left in resting contacts so they are still detected next step
+        float linearSlop = 0.25f;
+
+    private:
+        struct Point{
+            Vector2 anchorA, anchorB;   // Contact point relative to the body centres at detection
+            float baseSeparation;       // Separation at detection, minus the anchor offset along the normal
+            float normalMass, tangentMass;
+            float normalImpulse = 0.0f;
+            float tangentImpulse = 0.0f;
+            float maxNormalImpulse = 0.0f;
+            float totalNormalImpulse = 0.0f;    // Over all substeps
+            float relativeVelocity;     // Normal velocity before the step, for restitution
+        };
+        struct Constraint{
+            int indexA, indexB;
+            Vector2 normal;
+            float friction, restitution;
+            int pointCount;
+            Point points[2];
+        };
+        // Impulses of one body pair from the previous step, matched by feature id
+        struct ImpulseCacheEntry{
+            uint32_t ids[2];
+            float normalImpulse[2];
+            float tangentImpulse[2];
+            int pointCount = 0;
+            uint32_t lastStep = 0;
+        };
+        static constexpr uint32_t ImpulseCacheSweepInterval = 64;
+
+        // Body pair and terrain part: a body on terrain has one contact per part
+        struct ImpulseCacheKey{
+            uint64_t pair;
+            uint32_t part;
+            bool operator==(const ImpulseCacheKey& other) const { return pair == other.pair && part == other.part; }
+        };
+        struct ImpulseCacheKeyHash{
+            size_t operator()(const ImpulseCacheKey& key) const {
+                return std::hash<uint64_t>()(key.pair ^ static_cast<uint64_t>(key.part) * 0x9E3779B97F4A7C15ull);
+            }
+        };
+
+    public:
+        // The warm-start cache carries over between steps, so rollback has to
+        // save and restore it along with the bodies
+        struct CacheState{
+            std::vector<std::pair<ImpulseCacheKey, ImpulseCacheEntry>> entries;
+            uint32_t step = 0;
+        };
+        void SaveCache(CacheState& state) const;
+        void RestoreCache(const CacheState& state);
+
+    private:
+
+        struct BodyMotion{
+            Vector2 deltaPosition;
+            float deltaAngle;
+            float cosDelta, sinDelta;
+        };
+
+        void Prepare(const std::vector<RigidBody*>& bodies, const std::vector<Contact>& contacts);
+        void WarmStart(const std::vector<RigidBody*>& bodies);
+        void Solve(const std::vector<RigidBody*>& bodies, float inverseH, bool useBias);
+        void ApplyRestitution(const std::vector<RigidBody*>& bodies);
+        void StoreImpulses(const std::vector<Contact>& contacts);
+        static ImpulseCacheKey CacheKey(const Contact& contact);
+
+        std::vector<Constraint> constraints;
+        std::vector<BodyMotion> motion;
+        std::unordered_map<ImpulseCacheKey, ImpulseCacheEntry, ImpulseCacheKeyHash> impulseCache;
+        uint32_t step = 0;
+
+        // Soft constraint coefficients for the current substep size
+        float biasRate = 0.0f;
+        float massScale = 1.0f;
+        float impulseScale = 0.0f;
+};
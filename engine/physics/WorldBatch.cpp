@@ -0,0 +1,76 @@
+#include "WorldBatch.h"
+#include "PhysicsWorld.h"
+#include <algorithm>
+#include <chrono>
+
+void WorldBatch::SetWorkerThreads(int count){
+    std::unique_ptr<JobSystem> created(count > 0 ? new JobSystem(count) : nullptr);
+    SetJobSystem(created.get());
+    ownedJobs = std::move(created);
+}
+
+void WorldBatch::SetJobSystem(JobSystem* jobs){
+    this->jobs = jobs;
+    if(jobs != ownedJobs.get())
+        ownedJobs.reset();
+}
+
+void WorldBatch::Step(float deltaTime, int steps){
+    auto start = std::chrono::steady_clock::now();
+
+    auto stepRange = [&](int begin, int end){
+        for(int w = begin; w < end; w++){
+            for(int s = 0; s < steps; s++)
+                worlds[w]->Step(deltaTime);
+        }
+    };
+    int count = static_cast<int>(worlds.size());
+    if(jobs)
+        jobs->ParallelFor(count, 1, stepRange);
+    else
+        stepRange(0, count);
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stepsPerSecond = elapsed > 0.0 ? static_cast<double>(count) * steps / elapsed : 0.0;
+}
+
+int WorldBatch::GetFloatsPerBody(uint32_t fields){
+    int floats = 0;
+    if(fields & ObservePosition) floats += 2;
+    if(fields & ObserveOrientation) floats += 1;
+    if(fields & ObserveVelocity) floats += 2;
+    if(fields & ObserveAngularVelocity) floats += 1;
+    if(fields & ObserveSleeping) floats += 1;
+    return floats;
+}
+
+void WorldBatch::Extract(uint32_t fields, int bodiesPerWorld, float* out, uint32_t* ids){
+    int floatsPerBody = GetFloatsPerBody(fields);
+    size_t worldStride = static_cast<size_t>(bodiesPerWorld) * floatsPerBody;
+
+    auto extractRange = [&](int begin, int end){
+        for(int w = begin; w < end; w++){
+            const PhysicsWorld& world = *worlds[w];
+            float* o = out + w * worldStride;
+            uint32_t* id = ids ? ids + static_cast<size_t>(w) * bodiesPerWorld : nullptr;
+            int count = std::min(world.GetBodyCount(), bodiesPerWorld);
+
+            for(int i = 0; i < count; i++){
+                const RigidBody* body = world.GetBody(i);
+                if(fields & ObservePosition){ *o++ = body->position.x; *o++ = body->position.y; }
+                if(fields & ObserveOrientation) *o++ = body->orientation;
+                if(fields & ObserveVelocity){ *o++ = body->velocity.x; *o++ = body->velocity.y; }
+                if(fields & ObserveAngularVelocity) *o++ = body->angularVelocity;
+                if(fields & ObserveSleeping) *o++ = body->isSleeping ? 1.0f : 0.0f;
+                if(id) id[i] = body->id;
+            }
+            std::fill(o, out + (w + 1) * worldStride, 0.0f);
+            if(id) std::fill(id + count, id + bodiesPerWorld, InvalidBodyId);
+        }
+    };
+    int count = static_cast<int>(worlds.size());
+    if(jobs)
+        jobs->ParallelFor(count, 16, extractRange);
+    else
+        extractRange(0, count);
+}
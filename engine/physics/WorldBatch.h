@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../core/JobSystem.h"
+
+class PhysicsWorld;
+
+// Which body fields Extract writes, in this order
+enum ObservationField : uint32_t {
+    ObservePosition = 1,        // x, y
+    ObserveOrientation = 2,
+    ObserveVelocity = 4,        // x, y
+    ObserveAngularVelocity = 8,
+    ObserveSleeping = 16,       // 1 or 0
+};
+
+// Steps many independent worlds at once, e.g. for parameter sweeps or agent
+// training. Each job steps one whole world, so worlds added here should run
+// without their own job system; the batch spreads worlds over cores instead.
+// Worlds are not owned and must outlive the batch.
+class WorldBatch{
+    public:
+        void Add(PhysicsWorld* world) { worlds.push_back(world); }
+        void Clear() { worlds.clear(); }
+        int GetWorldCount() const { return static_cast<int>(worlds.size()); }
+        PhysicsWorld* GetWorld(int index) const { return worlds[index]; }
+
+        // Worker threads to spread the worlds over; 0 steps them one by one
+        void SetWorkerThreads(int count);
+        // Share a job system owned elsewhere; must outlive its use here
+        void SetJobSystem(JobSystem* jobs);
+
+        // Advance every world by steps fixed steps of deltaTime. A world runs
+        // all its steps in one job, so larger counts mean less synchronisation
+        void Step(float deltaTime, int steps = 1);
+
+        // Floats written per body for a set of ObservationFields
+        static int GetFloatsPerBody(uint32_t fields);
+
+        // Write the chosen fields of the first bodiesPerWorld bodies of every
+        // world into out, world after world: world w starts at
+        // out + w * bodiesPerWorld * GetFloatsPerBody(fields). Worlds with fewer
+        // bodies are padded with zeros. Bodies are in world order (which can
+        // change, see PhysicsWorld::GetBody); ids can be extracted alongside
+        void Extract(uint32_t fields, int bodiesPerWorld, float* out, uint32_t* ids = nullptr);
+
+        // World steps per second over the last Step call
+        double GetStepsPerSecond() const { return stepsPerSecond; }
+
+    private:
+        std::vector<PhysicsWorld*> worlds;
+        std::unique_ptr<JobSystem> ownedJobs;
+        JobSystem* jobs = nullptr;
+        double stepsPerSecond = 0.0;
+};
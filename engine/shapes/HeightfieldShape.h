@@ -0,0 +1,20 @@
+#pragma once
+#include "Shape.h"
+#include <utility>
+#include <vector>
+
+// Static ground as surface heights at even spacing: sample i lies at
+// (i * spacing, heights[i]) from the body's position, and everything below the
+// line through the samples (larger y) is solid. Orientation is ignored. Like
+// TileGridShape it stays out of the broadphase; bodies collide with the
+// segments under them.
+class HeightfieldShape : public Shape {
+    public:
+        std::vector<float> heights;
+        float spacing;
+
+        HeightfieldShape(std::vector<float> heights, float spacing)
+            : Shape(ShapeType::Heightfield), heights(std::move(heights)), spacing(spacing) {}
+
+        int GetSegmentCount() const { return heights.size() < 2 ? 0 : static_cast<int>(heights.size()) - 1; }
+};
@@ -0,0 +1,98 @@
+#include "PolygonShape.h"
+#include "../math/FloatN.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+static_assert(PolygonShape::MaxVertices % FloatN::Width == 0, "support search loads whole FloatN");
+
+PolygonShape::PolygonShape(const Vector2* points, int pointCount) : Shape(ShapeType::Polygon) {
+    // Convex hull of every point by monotone chain; collinear points are dropped
+    int n = std::max(pointCount, 0);
+    std::vector<Vector2> sorted(points, points + n);
+    std::sort(sorted.begin(), sorted.end(), [](const Vector2& a, const Vector2& b){
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+
+    std::vector<Vector2> hull(2 * n + 1);
+    int h = 0;
+    for(int pass = 0; pass < 2; pass++){
+        int start = h;
+        for(int k = 0; k < n; k++){
+            const Vector2& p = sorted[pass == 0 ? k : n - 1 - k];
+            while(h >= start + 2 && (hull[h - 1] - hull[h - 2]).cross(p - hull[h - 2]) <= 0.0f)
+                h--;
+            hull[h++] = p;
+        }
+        h--;    // Last point of each chain starts the other
+    }
+    h = std::max(h, 0);
+
+    // Too many corners: drop the one whose triangle with its neighbours is
+    // smallest, until MaxVertices are left (the lowest index on ties)
+    while(h > MaxVertices){
+        int drop = 0;
+        float smallest = FLT_MAX;
+        for(int i = 0; i < h; i++){
+            const Vector2& prev = hull[(i + h - 1) % h];
+            float loss = std::fabs((hull[i] - prev).cross(hull[(i + 1) % h] - prev));
+            if(loss < smallest){
+                smallest = loss;
+                drop = i;
+            }
+        }
+        hull.erase(hull.begin() + drop);
+        h--;
+    }
+    count = h;
+
+    // Area, centroid and second moment, relative to the first vertex for precision
+    float area = 0.0f, moment = 0.0f;
+    Vector2 centroid;
+    for(int i = 0; i < count; i++){
+        Vector2 e1 = hull[i] - hull[0];
+        Vector2 e2 = hull[(i + 1) % count] - hull[0];
+        float cross = e1.cross(e2);
+        area += 0.5f * cross;
+        centroid += (e1 + e2) * (cross / 6.0f);
+        moment += cross * (e1.dot(e1) + e1.dot(e2) + e2.dot(e2)) / 12.0f;
+    }
+    if(area > FLT_EPSILON){
+        this->area = area;
+        centroid /= area;
+        // Parallel axis theorem: from the first vertex to the centroid
+        unitInertia = moment / area - centroid.dot(centroid);
+    }
+    centroid += hull[0];
+
+    localMin = Vector2(FLT_MAX, FLT_MAX);
+    localMax = Vector2(-FLT_MAX, -FLT_MAX);
+    for(int i = 0; i < count; i++){
+        vertices[i] = hull[i] - centroid;
+        localMin = Vector2(std::min(localMin.x, vertices[i].x), std::min(localMin.y, vertices[i].y));
+        localMax = Vector2(std::max(localMax.x, vertices[i].x), std::max(localMax.y, vertices[i].y));
+        radius = std::max(radius, vertices[i].length());
+    }
+    for(int i = 0; i < count; i++){
+        Vector2 edge = vertices[(i + 1) % count] - vertices[i];
+        normals[i] = Vector2(edge.y, -edge.x).normalize();
+    }
+    for(int i = 0; i < MaxVertices; i++){
+        vertexX[i] = vertices[i < count ? i : 0].x;
+        vertexY[i] = vertices[i < count ? i : 0].y;
+    }
+}
+
+int PolygonShape::Support(const Vector2& direction) const {
+    float dots[MaxVertices];
+    FloatN dx(direction.x), dy(direction.y);
+    for(int i = 0; i < MaxVertices; i += FloatN::Width)
+        (FloatN::Load(vertexX + i) * dx + FloatN::Load(vertexY + i) * dy).Store(dots + i);
+
+    int best = 0;
+    for(int i = 1; i < count; i++){
+        if(dots[i] > dots[best]) best = i;
+    }
+    return best;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "Shape.h"
+#include "../math/Vector2.h"
+
+// Convex polygon of up to MaxVertices vertices. The constructor takes any
+// points (at least three, not all on one line), keeps their convex hull in
+// counter-clockwise order (the order of Collision::GetOBBCorners) and moves it
+// so its centroid is the origin: the body's position is its centre of mass.
+// A hull with more corners loses the flattest ones until MaxVertices remain.
+// Edge normals, bounds and inertia are computed once here.
+class PolygonShape : public Shape {
+    public:
+        static constexpr int MaxVertices = 8;
+
+        PolygonShape(const Vector2* points, int count);
+
+        int count = 0;
+        Vector2 vertices[MaxVertices];  // Local space
+        Vector2 normals[MaxVertices];   // Outward normal of the edge from vertex i to i + 1
+        Vector2 localMin, localMax;     // Bounds of the vertices in local space
+        float radius = 0.0f;            // Distance from the centroid to the farthest vertex
+        float unitInertia = 0.0f;       // Moment of inertia about the centroid per unit mass
+        float area = 0.0f;              // Zero if the points were all on one line
+
+        bool IsDegenerate() const { return area <= 0.0f; }
+
+        // Index of the vertex farthest along a local-space direction, the
+        // lowest index on ties. All vertices are projected at once (FloatN)
+        int Support(const Vector2& direction) const;
+
+    private:
+        // Vertices as coordinate arrays, padded with vertex 0 for the wide loads
+        float vertexX[MaxVertices];
+        float vertexY[MaxVertices];
+};
@@ -2,7 +2,10 @@
 
 enum class ShapeType {
     Circle,
-    AABB
+    AABB,
+    Polygon,    // Convex, see PolygonShape.h
+    TileGrid,   // Static terrain, see TileGridShape.h
+    Heightfield // Static terrain, see HeightfieldShape.h
 };
 
 class Shape{
@@ -10,6 +13,8 @@ class Shape{
         Shape(ShapeType type) : type(type) {}
         virtual ~Shape() = default;
         ShapeType GetType() const { return type; }
+        // Terrain never enters the broadphase; the world looks it up under each body
+        bool IsTerrain() const { return type == ShapeType::TileGrid || type == ShapeType::Heightfield; }
 
     private:
         ShapeType type;
@@ -0,0 +1,180 @@
+#include "TileGridShape.h"
+#include "../math/MathUtils.h"
+#include <algorithm>
+
+// Bits [begin, end) of one word, 0 <= begin < end <= 64
+static uint64_t BitRange(int begin, int end){
+    uint64_t bits = end - begin == 64 ? ~0ull : (1ull << (end - begin)) - 1;
+    return bits << begin;
+}
+
+// Whether every bit in [begin, end) of a row is set
+static bool AllSet(const uint64_t* row, int begin, int end){
+    for(int w = begin >> 6; w <= (end - 1) >> 6; w++){
+        uint64_t mask = BitRange(std::max(begin - w * 64, 0), std::min(end - w * 64, 64));
+        if((row[w] & mask) != mask) return false;
+    }
+    return true;
+}
+
+static void SetRange(uint64_t* row, int begin, int end, bool set){
+    for(int w = begin >> 6; w <= (end - 1) >> 6; w++){
+        uint64_t mask = BitRange(std::max(begin - w * 64, 0), std::min(end - w * 64, 64));
+        row[w] = set ? row[w] | mask : row[w] & ~mask;
+    }
+}
+
+// count <= 64 bits of a stream of words words, starting at bit offset
+static uint64_t ReadBits(const uint32_t* bits, size_t words, size_t offset, int count){
+    size_t i = offset >> 5;
+    int shift = static_cast<int>(offset & 31);
+    uint64_t value = bits[i];
+    if(i + 1 < words) value |= static_cast<uint64_t>(bits[i + 1]) << 32;
+    value >>= shift;
+    if(shift > 0 && i + 2 < words) value |= static_cast<uint64_t>(bits[i + 2]) << (64 - shift);
+    return count == 64 ? value : value & ((1ull << count) - 1);
+}
+
+// ORs count <= 64 bits of value into the stream at bit offset
+static void WriteBits(uint32_t* bits, size_t offset, int count, uint64_t value){
+    size_t i = offset >> 5;
+    int shift = static_cast<int>(offset & 31);
+    bits[i] |= static_cast<uint32_t>(value << shift);
+    if(shift + count > 32) bits[i + 1] |= static_cast<uint32_t>(value >> (32 - shift));
+    if(shift + count > 64) bits[i + 2] |= static_cast<uint32_t>(value >> (64 - shift));
+}
+
+TileGridShape::TileGridShape(int columns, int rows, float tileSize)
+    : Shape(ShapeType::TileGrid), columns(columns), rows(rows), tileSize(tileSize),
+      wordsPerRow((columns + 63) / 64), solid(static_cast<size_t>(wordsPerRow) * rows, 0) {}
+
+bool TileGridShape::IsSolid(int column, int row) const {
+    if(column < 0 || row < 0 || column >= columns || row >= rows) return false;
+    return (solid[static_cast<size_t>(row) * wordsPerRow + (column >> 6)] >> (column & 63)) & 1;
+}
+
+void TileGridShape::SetSolid(int column, int row, bool value){
+    Fill(column, row, 1, 1, value);
+}
+
+void TileGridShape::Fill(int column, int row, int columnCount, int rowCount, bool value){
+    int begin = std::max(column, 0), end = std::min(column + columnCount, columns);
+    if(begin >= end) return;
+    for(int r = std::max(row, 0); r < std::min(row + rowCount, rows); r++)
+        SetRange(&solid[static_cast<size_t>(r) * wordsPerRow], begin, end, value);
+    dirty = true;
+}
+
+// A row at a time, one grid word per stream read
+void TileGridShape::SetTiles(const uint32_t* bits){
+    size_t words = (static_cast<size_t>(columns) * rows + 31) / 32;
+    for(int r = 0; r < rows; r++){
+        size_t start = static_cast<size_t>(r) * columns;
+        for(int w = 0; w < wordsPerRow; w++){
+            int count = std::min(columns - w * 64, 64);
+            solid[static_cast<size_t>(r) * wordsPerRow + w] = ReadBits(bits, words, start + w * 64, count);
+        }
+    }
+    dirty = true;
+}
+
+void TileGridShape::GetTiles(uint32_t* bits) const {
+    std::fill(bits, bits + (static_cast<size_t>(columns) * rows + 31) / 32, 0u);
+    for(int r = 0; r < rows; r++){
+        size_t start = static_cast<size_t>(r) * columns;
+        for(int w = 0; w < wordsPerRow; w++)
+            WriteBits(bits, start + w * 64, std::min(columns - w * 64, 64), solid[static_cast<size_t>(r) * wordsPerRow + w]);
+    }
+}
+
+const std::vector<TileGridShape::Rect>& TileGridShape::GetRects(){
+    if(dirty) Rebuild();
+    return rects;
+}
+
+// Greedy merge: take the first solid tile left in row order, extend it along
+// the row, then down while every tile below the run is solid and unclaimed
+void TileGridShape::Rebuild(){
+    dirty = false;
+    rects.clear();
+
+    std::vector<uint64_t> remaining = solid;
+    for(int r = 0; r < rows; r++){
+        uint64_t* row = &remaining[static_cast<size_t>(r) * wordsPerRow];
+        for(int w = 0; w < wordsPerRow; w++){
+            while(row[w]){
+                int begin = w * 64 + LowestBit(row[w]);
+
+                int end = begin;
+                for(int x = begin >> 6; x < wordsPerRow; x++){
+                    uint64_t clear = ~row[x] & (x == begin >> 6 ? ~0ull << (begin & 63) : ~0ull);
+                    if(clear){
+                        end = x * 64 + LowestBit(clear);
+                        break;
+                    }
+                    end = (x + 1) * 64;
+                }
+                end = std::min(end, columns);
+
+                int height = 1;
+                while(r + height < rows && AllSet(&remaining[static_cast<size_t>(r + height) * wordsPerRow], begin, end))
+                    height++;
+                for(int y = r; y < r + height; y++)
+                    SetRange(&remaining[static_cast<size_t>(y) * wordsPerRow], begin, end, false);
+
+                rects.push_back({begin, r, end - begin, height});
+            }
+        }
+    }
+
+    // Chunk index, counted then filled
+    chunkColumns = (columns + ChunkSize - 1) / ChunkSize;
+    chunkRows = (rows + ChunkSize - 1) / ChunkSize;
+    chunkStart.assign(static_cast<size_t>(chunkColumns) * chunkRows + 1, 0);
+    for(int pass = 0; pass < 2; pass++){
+        for(int i = 0; i < static_cast<int>(rects.size()); i++){
+            const Rect& rect = rects[i];
+            for(int cy = rect.row / ChunkSize; cy <= (rect.row + rect.rows - 1) / ChunkSize; cy++){
+                for(int cx = rect.column / ChunkSize; cx <= (rect.column + rect.columns - 1) / ChunkSize; cx++){
+                    size_t chunk = static_cast<size_t>(cy) * chunkColumns + cx;
+                    if(pass == 0) chunkStart[chunk + 1]++;
+                    else chunkRects[chunkStart[chunk]++] = i;
+                }
+            }
+        }
+        if(pass == 0){
+            for(size_t c = 1; c < chunkStart.size(); c++)
+                chunkStart[c] += chunkStart[c - 1];
+            chunkRects.resize(chunkStart.back());
+        }
+    }
+    // Filling advanced each start to the next chunk's; shift them back
+    for(size_t c = chunkStart.size() - 1; c > 0; c--)
+        chunkStart[c] = chunkStart[c - 1];
+    chunkStart[0] = 0;
+}
+
+void TileGridShape::Query(int minColumn, int minRow, int maxColumn, int maxRow, std::vector<int>& out){
+    out.clear();
+    if(dirty) Rebuild();
+
+    minColumn = std::max(minColumn, 0);
+    minRow = std::max(minRow, 0);
+    maxColumn = std::min(maxColumn, columns - 1);
+    maxRow = std::min(maxRow, rows - 1);
+    if(minColumn > maxColumn || minRow > maxRow) return;
+
+    for(int cy = minRow / ChunkSize; cy <= maxRow / ChunkSize; cy++){
+        for(int cx = minColumn / ChunkSize; cx <= maxColumn / ChunkSize; cx++){
+            size_t chunk = static_cast<size_t>(cy) * chunkColumns + cx;
+            for(int k = chunkStart[chunk]; k < chunkStart[chunk + 1]; k++){
+                const Rect& rect = rects[chunkRects[k]];
+                if(rect.column <= maxColumn && rect.column + rect.columns > minColumn &&
+                   rect.row <= maxRow && rect.row + rect.rows > minRow)
+                    out.push_back(chunkRects[k]);
+            }
+        }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
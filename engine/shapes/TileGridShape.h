@@ -0,0 +1,59 @@
+#pragma once
+#include "Shape.h"
+#include <cstdint>
+#include <vector>
+
+// Static level geometry as a grid of solid or empty square tiles. Tile (0, 0)
+// has its top-left corner at the body's position; orientation is ignored.
+// Solid tiles are merged into rectangles (runs along a row first, then grown
+// down while the rows below match), so a body sliding along a floor or wall
+// meets one long edge rather than the seams between tiles. The world collides
+// bodies with the rectangles under them, found through a coarse chunk index,
+// so a large map costs nothing where no body is near it.
+class TileGridShape : public Shape {
+    public:
+        // Solid tiles merged into one box, in tiles
+        struct Rect{
+            int column, row;
+            int columns, rows;
+        };
+
+        TileGridShape(int columns, int rows, float tileSize);
+
+        int GetColumns() const { return columns; }
+        int GetRows() const { return rows; }
+        float GetTileSize() const { return tileSize; }
+
+        // Tiles outside the grid are empty
+        bool IsSolid(int column, int row) const;
+        // Edits take effect (and the tiles are merged again) at the next query
+        void SetSolid(int column, int row, bool solid);
+        void Fill(int column, int row, int columnCount, int rowCount, bool solid);
+        // Every tile at once as a bit stream in row order, 32 bits per word from
+        // the low bit: tile (column, row) is bit row * columns + column. Both
+        // take (columns * rows + 31) / 32 words
+        void SetTiles(const uint32_t* bits);
+        void GetTiles(uint32_t* bits) const;
+
+        const std::vector<Rect>& GetRects();
+        // Indices of the rectangles overlapping tiles [minColumn, maxColumn] x
+        // [minRow, maxRow], each once, in ascending order
+        void Query(int minColumn, int minRow, int maxColumn, int maxRow, std::vector<int>& out);
+
+    private:
+        void Rebuild();
+
+        // Rectangles are indexed by the chunks of ChunkSize x ChunkSize tiles they touch
+        static constexpr int ChunkSize = 16;
+
+        int columns, rows;
+        float tileSize;
+        int wordsPerRow;
+        std::vector<uint64_t> solid;    // One bit per tile, rows padded to whole words
+        bool dirty = true;
+
+        std::vector<Rect> rects;
+        int chunkColumns = 0, chunkRows = 0;
+        std::vector<int> chunkStart;    // Rects of chunk c are chunkRects[chunkStart[c] .. chunkStart[c + 1])
+        std::vector<int> chunkRects;
+};
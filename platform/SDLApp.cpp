@@ -3,6 +3,10 @@
 #include <iostream>
 #include "../engine/shapes/AABBShape.h"
 #include "../engine/shapes/CircleShape.h"
+#include "../engine/shapes/PolygonShape.h"
+#include "../engine/shapes/TileGridShape.h"
+#include "../engine/shapes/HeightfieldShape.h"
+#include "../demo/Spawns.h"
 
 bool SDLApp::Init()
 {
@@ -44,25 +48,23 @@ void SDLApp::HandleEvents(PhysicsWorld &world)
         {
             isRunning = false;
         }
+        else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_RIGHT)
+        {
+            // Spawn a burst of debris particles
+            Spawns::Burst(world, Vector2(event.button.x, event.button.y));
+        }
+        else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_MIDDLE)
+        {
+            // Drop a hexagon
+            Spawns::Hexagon(world, Vector2(event.button.x, event.button.y));
+        }
         else if (event.type == SDL_MOUSEBUTTONDOWN)
         {
             float mouseX = static_cast<float>(event.button.x);
             float mouseY = static_cast<float>(event.button.y);
 
             std::cout << "Mouse Clicked at: (" << mouseX << ", " << mouseY << ")\n";
-            RigidBody *entity = new RigidBody(1.0f);
-            entity->position = Vector2(mouseX, mouseY);
-            entity->size = Vector2(30.0f, 30.0f);
-
-            // entity->collider = new Collider(new AABBShape(entity->size/2));
-            entity->collider = new Collider(new CircleShape(entity->size.x / 2));
-            entity->collider->restitution = 0.9f; // Set some bounciness
-            entity->collider->staticFriction = 0.2f;
-            entity->collider->dynamicFriction = 0.1f;
-            entity->velocity = Vector2(400.0f, 0.0f);
-            entity->SetInverseInertia(entity->collider->shape->GetType());
-
-            world.AddBody(entity);
+            Spawns::Ball(world, Vector2(mouseX, mouseY));
         }
     }
 }
@@ -174,6 +176,52 @@ void SDLApp::Paint(PhysicsWorld &world)
             auto *circle = static_cast<CircleShape *>(body->collider->shape);
             DrawCircleWithIndicator(body->position.x, body->position.y, static_cast<int>(circle->radius), body->orientation, {255, 255, 255, 255});
         }
+        else if (body->collider->shape->GetType() == ShapeType::Polygon)
+        {
+            auto *polygon = static_cast<PolygonShape *>(body->collider->shape);
+            float cosA = std::cos(body->orientation);
+            float sinA = std::sin(body->orientation);
+            SDL_Point points[PolygonShape::MaxVertices + 1];
+            for (int k = 0; k <= polygon->count; k++)
+            {
+                const Vector2 &v = polygon->vertices[k % polygon->count];
+                points[k] = {static_cast<int>(body->position.x + v.x * cosA - v.y * sinA),
+                             static_cast<int>(body->position.y + v.x * sinA + v.y * cosA)};
+            }
+            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+            SDL_RenderDrawLines(renderer, points, polygon->count + 1);
+        }
+        else if (body->collider->shape->GetType() == ShapeType::TileGrid)
+        {
+            // One outline per merged rectangle
+            auto *grid = static_cast<TileGridShape *>(body->collider->shape);
+            float tile = grid->GetTileSize();
+            for (const TileGridShape::Rect &rect : grid->GetRects())
+            {
+                float w = rect.columns * tile;
+                float h = rect.rows * tile;
+                DrawRotatedRect(body->position.x + rect.column * tile + w / 2, body->position.y + rect.row * tile + h / 2,
+                                static_cast<int>(w), static_cast<int>(h), 0.0f, {160, 160, 160, 255});
+            }
+        }
+        else if (body->collider->shape->GetType() == ShapeType::Heightfield)
+        {
+            auto *field = static_cast<HeightfieldShape *>(body->collider->shape);
+            SDL_SetRenderDrawColor(renderer, 160, 160, 160, 255);
+            for (int s = 0; s < field->GetSegmentCount(); s++)
+            {
+                SDL_RenderDrawLine(renderer,
+                                   static_cast<int>(body->position.x + s * field->spacing), static_cast<int>(body->position.y + field->heights[s]),
+                                   static_cast<int>(body->position.x + (s + 1) * field->spacing), static_cast<int>(body->position.y + field->heights[s + 1]));
+            }
+        }
+    }
+
+    const ParticleSystem &particles = world.GetParticles();
+    for (int i = 0; i < particles.GetCount(); i++)
+    {
+        Vector2 p = particles.GetPosition(i);
+        DrawCircle(p.x, p.y, static_cast<int>(particles.GetRadius(i)), {200, 200, 80, 255});
     }
 
     SDL_RenderPresent(renderer);
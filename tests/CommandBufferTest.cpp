@@ -0,0 +1,86 @@
+#include "physics/PhysicsWorld.h"
+#include "shapes/CircleShape.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// World commands apply as if each ran in turn (CommandBuffer.h), and pushes
+// from several threads all arrive across repeated drains
+static int failures = 0;
+
+static int CountOf(const PhysicsWorld& world, const RigidBody* body){
+    int count = 0;
+    for(int i = 0; i < world.GetBodyCount(); i++)
+        count += world.GetBody(i) == body;
+    return count;
+}
+
+static void Expect(const char* name, int value, int expected){
+    if(value == expected) return;
+    std::printf("%s: %d, expected %d\n", name, value, expected);
+    failures++;
+}
+
+int main(){
+    CircleShape shape(5.0f);
+    Collider collider(&shape);
+    RigidBody a(1.0f), b(1.0f), c(1.0f), d(1.0f);
+    for(RigidBody* body : {&a, &b, &c, &d}) body->collider = &collider;
+
+    PhysicsWorld world;
+    world.AddBody(&a);
+    world.AddBody(&b);
+    CommandBuffer& commands = world.GetCommandBuffer();
+
+    commands.RemoveBody(&a);    // In the world: removed, then back
+    commands.AddBody(&a);
+    commands.AddBody(&b);       // Already there: ignored, then removed
+    commands.RemoveBody(&b);
+    commands.RemoveBody(&c);    // Not in the world: ignored, then added
+    commands.AddBody(&c);
+    commands.AddBody(&d);       // Added twice, once
+    commands.AddBody(&d);
+    world.Step(1.0f / 60.0f);
+    Expect("remove, add a present body", CountOf(world, &a), 1);
+    Expect("add, remove a present body", CountOf(world, &b), 0);
+    Expect("remove, add a new body", CountOf(world, &c), 1);
+    Expect("add a new body twice", CountOf(world, &d), 1);
+
+    commands.AddBody(&b);       // Added and removed in the same batch
+    commands.RemoveBody(&b);
+    commands.RemoveBody(&d);
+    world.Step(1.0f / 60.0f);
+    Expect("add, remove a new body", CountOf(world, &b), 0);
+    Expect("remove", CountOf(world, &d), 0);
+    Expect("body count", world.GetBodyCount(), 2);
+
+    // Four producers racing the consumer; the node pool rewinds between drains
+    CommandBuffer buffer;
+    std::vector<WorldCommand> drained;
+    const int producers = 4, perProducer = 20000;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < producers; t++){
+        threads.emplace_back([&buffer, t]{
+            for(int i = 0; i < perProducer; i++)
+                buffer.ApplyImpulse(nullptr, Vector2(static_cast<float>(t), static_cast<float>(i)));
+        });
+    }
+    while(static_cast<int>(drained.size()) < producers * perProducer)
+        buffer.Drain(drained);
+    for(std::thread& thread : threads) thread.join();
+    buffer.Drain(drained);
+
+    // Every command once, each producer's in submission order
+    std::vector<int> next(producers, 0);
+    bool ordered = true;
+    for(const WorldCommand& command : drained){
+        int t = static_cast<int>(command.value.x);
+        ordered &= static_cast<int>(command.value.y) == next[t]++;
+    }
+    Expect("commands drained", static_cast<int>(drained.size()), producers * perProducer);
+    Expect("producer order kept", ordered ? 1 : 0, 1);
+
+    std::printf("CommandBuffer: %s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+#include "physics/PhysicsWorld.h"
+#include "forces/GravityForce.h"
+#include "shapes/AABBShape.h"
+#include "shapes/CircleShape.h"
+#include "core/Config.h"
+#include "core/Time.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Drops bodies onto the ground in waves, saves the world between waves and
+// checks that the contact events after a restore are the ones the first run
+// gave: same begin / persist / end sequence, bodies, points and impulses
+static int failures = 0;
+
+static void Expect(const char* what, bool ok){
+    if(ok) return;
+    std::printf("%s\n", what);
+    failures++;
+}
+
+static bool SameBits(float a, float b){
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+static bool Same(const ContactEvent& a, const ContactEvent& b){
+    return a.type == b.type && a.sensor == b.sensor && a.bodyA == b.bodyA && a.bodyB == b.bodyB && a.step == b.step &&
+           SameBits(a.point.x, b.point.x) && SameBits(a.point.y, b.point.y) &&
+           SameBits(a.normal.x, b.normal.x) && SameBits(a.normal.y, b.normal.y) && SameBits(a.impulse, b.impulse);
+}
+
+static int Count(const std::vector<ContactEvent>& events, ContactEventType type){
+    int count = 0;
+    for(const ContactEvent& event : events)
+        count += event.type == type;
+    return count;
+}
+
+static std::vector<ContactEvent> Run(PhysicsWorld& world, int steps){
+    std::vector<ContactEvent> events;
+    for(int s = 0; s < steps; s++){
+        world.Step(Time::FixedDeltaTime);
+        world.DrainContactEvents(events);
+    }
+    return events;
+}
+
+int main(){
+    PhysicsWorld world;
+    GravityForce gravity(Vector2(0.0f, Config::GRAVITY));
+    world.AddForceGenerator(&gravity);
+    world.SetContactEvents(true);
+
+    AABBShape groundShape(Vector2(400.0f, 20.0f));
+    AABBShape boxShape(Vector2(10.0f, 10.0f));
+    CircleShape circleShape(10.0f);
+    Collider groundCollider(&groundShape), boxCollider(&boxShape), circleCollider(&circleShape);
+    groundCollider.restitution = 0.0f;
+    circleCollider.restitution = 0.6f;
+
+    std::vector<std::unique_ptr<RigidBody>> bodies;
+    bodies.push_back(std::make_unique<RigidBody>(0.0f));
+    bodies.back()->position = Vector2(400.0f, 500.0f);
+    bodies.back()->collider = &groundCollider;
+    world.AddBody(bodies.back().get());
+    // Higher rows land later; the bouncing circles end and begin contacts again
+    for(int i = 0; i < 30; i++){
+        bodies.push_back(std::make_unique<RigidBody>(1.0f));
+        RigidBody& body = *bodies.back();
+        body.position = Vector2(100.0f + (i % 10) * 60.0f, 460.0f - (i / 10) * 150.0f);
+        body.collider = i % 2 ? &circleCollider : &boxCollider;
+        body.SetInverseInertia(body.collider->shape->GetType());
+        world.AddBody(&body);
+    }
+
+    Run(world, 20);
+    int tick = world.SaveState();
+    std::vector<ContactEvent> first = Run(world, 90);
+    Expect("begin events after the save", Count(first, ContactEventType::Begin) > 0);
+    Expect("persist events after the save", Count(first, ContactEventType::Persist) > 0);
+    Expect("end events after the save", Count(first, ContactEventType::End) > 0);
+
+    Expect("restore", world.RestoreState(tick));
+    std::vector<ContactEvent> second = Run(world, 90);
+    Expect("same number of events after restore", first.size() == second.size());
+    size_t matched = 0;
+    while(matched < first.size() && matched < second.size() && Same(first[matched], second[matched]))
+        matched++;
+    Expect("same events after restore", matched == first.size() && matched == second.size());
+
+    // Undrained events of the steps rolled back are dropped
+    for(int s = 0; s < 10; s++)
+        world.Step(Time::FixedDeltaTime);
+    Expect("undrained events", !world.GetContactEvents().empty());
+    Expect("restore again", world.RestoreState(tick));
+    Expect("events of rolled back steps dropped", world.GetContactEvents().empty());
+
+    std::printf("ContactEventRollback: %s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
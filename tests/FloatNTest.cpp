@@ -0,0 +1,207 @@
+#include "math/FloatN.h"
+#include "math/MathUtils.h"
+#include "math/Vector2xN.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Checks every FloatN and Vector2xN operation lane by lane against the same
+// expression on floats and Vector2. Built once per SIMD backend (see
+// CMakeLists.txt). Exits 1 if any lane differs, 77 (skipped) if the CPU
+// can't run the instructions this build was compiled for.
+static const char* BackendName(){
+#if defined(NGEN2D_SIMD_AVX2)
+    return "AVX2";
+#elif defined(NGEN2D_SIMD_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+static int failures = 0;
+
+static uint32_t Bits(float value){
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Bit for bit, except that any NaN matches any NaN: the payload of a NaN
+// made from non-NaN inputs differs between libm and the vector instructions
+static void Check(const char* op, int index, float wide, float scalar){
+    if(Bits(wide) == Bits(scalar) || (std::isnan(wide) && std::isnan(scalar))) return;
+    if(failures++ < 20)
+        std::printf("%s, element %d: wide %g (%08x), scalar %g (%08x)\n", op, index,
+                    wide, static_cast<unsigned>(Bits(wide)), scalar, static_cast<unsigned>(Bits(scalar)));
+}
+
+static void CheckMask(const char* op, int index, MaskN mask, int lane, bool scalar){
+    if(((mask.Bits() >> lane) & 1) == (scalar ? 1 : 0)) return;
+    if(failures++ < 20)
+        std::printf("%s, element %d: wide %d, scalar %d\n", op, index, (mask.Bits() >> lane) & 1, scalar ? 1 : 0);
+}
+
+// Zeros, signed zeros, denormals, infinities, NaN, the normalize threshold,
+// then random values over several orders of magnitude
+static std::vector<float> MakeInputs(int count, int stride, uint32_t seed){
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float infinity = std::numeric_limits<float>::infinity();
+    const float specials[] = { 0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 3.0f, 1e-40f, -1e-40f, FLT_MIN, FLT_MAX, -FLT_MAX,
+                               infinity, -infinity, nan, 0.00001f, 0.000005f, -0.000007f };
+    const int specialCount = static_cast<int>(sizeof(specials) / sizeof(specials[0]));
+
+    std::vector<float> values(count);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_int_distribution<int> exponent(-6, 6);
+    for(int i = 0; i < count; i++){
+        if(i < specialCount * specialCount) values[i] = specials[(i * stride + i / specialCount) % specialCount];
+        else values[i] = unit(rng) * std::pow(10.0f, static_cast<float>(exponent(rng)));
+    }
+    return values;
+}
+
+static void TestFloatN(const std::vector<float>& a, const std::vector<float>& b, const std::vector<float>& c){
+    const int W = FloatN::Width;
+    float out[W];
+    int index[W];
+
+    for(int i = 0; i + W <= static_cast<int>(a.size()); i += W){
+        FloatN x = FloatN::Load(&a[i]);
+        FloatN y = FloatN::Load(&b[i]);
+        FloatN z = FloatN::Load(&c[i]);
+
+        auto lanes = [&](const char* op, FloatN wide, auto scalar){
+            wide.Store(out);
+            for(int k = 0; k < W; k++)
+                Check(op, i + k, out[k], scalar(i + k));
+        };
+        lanes("Load/Store", x, [&](int j){ return a[j]; });
+        lanes("FloatN()", FloatN(), [&](int){ return 0.0f; });
+        lanes("FloatN(float)", FloatN(a[i]), [&](int){ return a[i]; });
+        lanes("+", x + y, [&](int j){ return a[j] + b[j]; });
+        lanes("-", x - y, [&](int j){ return a[j] - b[j]; });
+        lanes("*", x * y, [&](int j){ return a[j] * b[j]; });
+        lanes("/", x / y, [&](int j){ return a[j] / b[j]; });
+        lanes("unary -", -x, [&](int j){ return -a[j]; });
+        lanes("Min", Min(x, y), [&](int j){ return std::min(b[j], a[j]); });
+        lanes("Max", Max(x, y), [&](int j){ return std::max(b[j], a[j]); });
+        lanes("Sqrt", Sqrt(x), [&](int j){ return std::sqrt(a[j]); });
+        lanes("Abs", Abs(x), [&](int j){ return std::fabs(a[j]); });
+        lanes("Clamp", Clamp(x, y, z), [&](int j){ return Clamp(a[j], b[j], c[j]); });
+        lanes("Clamp ordered", Clamp(x, Min(y, z), Max(y, z)), [&](int j){
+            return Clamp(a[j], std::min(c[j], b[j]), std::max(c[j], b[j]));
+        });
+
+        // Gather in reverse, wrapping to the start of the arrays
+        for(int k = 0; k < W; k++)
+            index[k] = (static_cast<int>(a.size()) - 1 - i - k * 3 + static_cast<int>(a.size())) % static_cast<int>(a.size());
+        lanes("Gather", FloatN::Gather(a.data(), index), [&](int j){ return a[index[j - i]]; });
+
+        for(int k = 0; k < W; k++){
+            int j = i + k;
+            CheckMask("<", j, x < y, k, a[j] < b[j]);
+            CheckMask("<=", j, x <= y, k, a[j] <= b[j]);
+            CheckMask(">", j, x > y, k, a[j] > b[j]);
+            CheckMask(">=", j, x >= y, k, a[j] >= b[j]);
+            CheckMask("==", j, x == y, k, a[j] == b[j]);
+            CheckMask("!=", j, x != y, k, a[j] != b[j]);
+            CheckMask("&", j, (x < y) & (y < z), k, a[j] < b[j] && b[j] < c[j]);
+            CheckMask("|", j, (x < y) | (y < z), k, a[j] < b[j] || b[j] < c[j]);
+            CheckMask("~", j, ~(x < y), k, !(a[j] < b[j]));
+        }
+        bool any = false;
+        for(int k = 0; k < W; k++) any |= a[i + k] < b[i + k];
+        if((x < y).Any() != any && failures++ < 20)
+            std::printf("Any, elements %d..%d: wide %d, scalar %d\n", i, i + W - 1, (x < y).Any() ? 1 : 0, any ? 1 : 0);
+
+        lanes("Select", Select(x < y, y, z), [&](int j){ return a[j] < b[j] ? b[j] : c[j]; });
+    }
+}
+
+static void TestVector2xN(const std::vector<float>& a, const std::vector<float>& b, const std::vector<float>& c,
+                          const std::vector<float>& d, const std::vector<float>& e)
+{
+    const int W = FloatN::Width;
+    float outX[W], outY[W], out[W];
+    int index[W];
+
+    for(int i = 0; i + W <= static_cast<int>(a.size()); i += W){
+        Vector2xN u = Vector2xN::Load(&a[i], &b[i]);
+        Vector2xN v = Vector2xN::Load(&c[i], &d[i]);
+        FloatN s = FloatN::Load(&e[i]);
+        auto U = [&](int j){ return Vector2(a[j], b[j]); };
+        auto V = [&](int j){ return Vector2(c[j], d[j]); };
+
+        auto vectorLanes = [&](const char* op, const Vector2xN& wide, auto scalar){
+            wide.Store(outX, outY);
+            for(int k = 0; k < W; k++){
+                Vector2 expected = scalar(i + k);
+                Check(op, i + k, outX[k], expected.x);
+                Check(op, i + k, outY[k], expected.y);
+            }
+        };
+        auto floatLanes = [&](const char* op, FloatN wide, auto scalar){
+            wide.Store(out);
+            for(int k = 0; k < W; k++)
+                Check(op, i + k, out[k], scalar(i + k));
+        };
+
+        vectorLanes("Vector2xN Load/Store", u, U);
+        vectorLanes("Vector2xN(Vector2)", Vector2xN(U(i)), [&](int){ return U(i); });
+        vectorLanes("Vector2xN +", u + v, [&](int j){ return U(j) + V(j); });
+        vectorLanes("Vector2xN -", u - v, [&](int j){ return U(j) - V(j); });
+        vectorLanes("Vector2xN *", u * s, [&](int j){ return U(j) * e[j]; });
+        vectorLanes("Vector2xN /", u / s, [&](int j){ return U(j) / e[j]; });
+        floatLanes("Vector2xN dot", u.dot(v), [&](int j){ return U(j).dot(V(j)); });
+        floatLanes("Vector2xN cross", u.cross(v), [&](int j){ return U(j).cross(V(j)); });
+        floatLanes("Vector2xN lengthSquared", u.lengthSquared(), [&](int j){ return U(j).lengthSquared(); });
+        floatLanes("Vector2xN length", u.length(), [&](int j){ return U(j).length(); });
+        vectorLanes("Vector2xN normalize", u.normalize(), [&](int j){ return U(j).normalize(); });
+
+        // Vector2 has no rotation; the engine writes it out as below
+        FloatN cosA = FloatN::Load(&c[i]), sinA = FloatN::Load(&d[i]);
+        vectorLanes("Vector2xN Rotate", u.Rotate(cosA, sinA), [&](int j){
+            return Vector2(a[j] * c[j] - b[j] * d[j], a[j] * d[j] + b[j] * c[j]);
+        });
+        vectorLanes("Vector2xN InverseRotate", u.InverseRotate(cosA, sinA), [&](int j){
+            return Vector2(a[j] * c[j] + b[j] * d[j], b[j] * c[j] - a[j] * d[j]);
+        });
+
+        vectorLanes("Vector2xN Select", Select(u.x < v.x, u, v), [&](int j){ return a[j] < c[j] ? U(j) : V(j); });
+
+        for(int k = 0; k < W; k++)
+            index[k] = (i * 7 + k * 5) % static_cast<int>(a.size());
+        vectorLanes("Vector2xN Gather", Vector2xN::Gather(a.data(), b.data(), index), [&](int j){ return U(index[j - i]); });
+    }
+}
+
+int main(){
+#if defined(NGEN2D_SIMD_AVX2) && (defined(__GNUC__) || defined(__clang__))
+    if(!__builtin_cpu_supports("avx2")){
+        std::printf("FloatN %s: CPU has no AVX2, skipped\n", BackendName());
+        return 77;
+    }
+#endif
+
+    // A multiple of every lane count
+    const int count = 8 * 1024;
+    std::vector<float> a = MakeInputs(count, 1, 1), b = MakeInputs(count, 5, 2), c = MakeInputs(count, 7, 3);
+    std::vector<float> d = MakeInputs(count, 11, 4), e = MakeInputs(count, 13, 5);
+
+    TestFloatN(a, b, c);
+    TestFloatN(b, c, a);
+    TestVector2xN(a, b, c, d, e);
+    TestVector2xN(d, e, a, b, c);
+
+    std::printf("FloatN %s, %d lanes: %s\n", BackendName(), FloatN::Width, failures ? "FAIL" : "PASS");
+    if(failures) std::printf("%d mismatches\n", failures);
+    return failures ? 1 : 0;
+}
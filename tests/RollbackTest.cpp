@@ -0,0 +1,154 @@
+#include "physics/PhysicsWorld.h"
+#include "forces/GravityForce.h"
+#include "shapes/AABBShape.h"
+#include "shapes/CircleShape.h"
+#include "core/Config.h"
+#include "core/Time.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Saves the world every tick, rolls back and resimulates, and checks every
+// resimulated tick hashes the same as the first time: bodies in list order,
+// particles and the contact events of the step. Runs with substeps, particles,
+// contact events, body reordering and worker threads all on.
+static const int SnapshotCapacity = 32;
+static const int Ticks = 40;
+
+static int failures = 0;
+
+static void Expect(const char* what, bool ok){
+    if(ok) return;
+    std::printf("%s\n", what);
+    failures++;
+}
+
+struct Hash{
+    uint64_t value = 1469598103934665603ull;
+
+    template<typename T>
+    void Add(const T& field){
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&field);
+        for(size_t k = 0; k < sizeof(T); k++){
+            value ^= bytes[k];
+            value *= 1099511628211ull;
+        }
+    }
+};
+
+static uint64_t WorldHash(const PhysicsWorld& world, const std::vector<ContactEvent>& events){
+    Hash hash;
+    hash.Add(world.GetStepCount());
+    for(int i = 0; i < world.GetBodyCount(); i++){
+        const RigidBody* body = world.GetBody(i);
+        hash.Add(body->id);
+        hash.Add(body->position);
+        hash.Add(body->velocity);
+        hash.Add(body->orientation);
+        hash.Add(body->angularVelocity);
+        hash.Add(body->sleepTime);
+        hash.Add(body->isSleeping);
+    }
+    const ParticleSystem& particles = world.GetParticles();
+    hash.Add(particles.GetCount());
+    for(int i = 0; i < particles.GetCount(); i++){
+        hash.Add(particles.GetPosition(i));
+        hash.Add(particles.GetVelocity(i));
+    }
+    for(const ContactEvent& event : events){
+        hash.Add(event.type);
+        hash.Add(event.bodyA);
+        hash.Add(event.bodyB);
+        hash.Add(event.step);
+        hash.Add(event.point);
+        hash.Add(event.normal);
+        hash.Add(event.impulse);
+    }
+    return hash.value;
+}
+
+// Save, step and hash one tick, returning the tick saved before the step
+static int Tick(PhysicsWorld& world, uint64_t& hash){
+    int tick = world.SaveState();
+    world.Step(Time::FixedDeltaTime);
+    std::vector<ContactEvent> events;
+    world.DrainContactEvents(events);
+    hash = WorldHash(world, events);
+    return tick;
+}
+
+// Restore ticks[from] and resimulate to the end, comparing with hashes
+static void Resimulate(PhysicsWorld& world, std::vector<int>& ticks, const std::vector<uint64_t>& hashes, int from,
+                       const char* what)
+{
+    if(!world.RestoreState(ticks[from])){
+        std::printf("%s: restore failed\n", what);
+        failures++;
+        return;
+    }
+    for(int s = from; s < Ticks; s++){
+        uint64_t hash;
+        ticks[s] = Tick(world, hash);
+        if(hash != hashes[s]){
+            std::printf("%s: diverged %d ticks after the restore\n", what, s - from);
+            failures++;
+            return;
+        }
+    }
+}
+
+int main(){
+    PhysicsWorld world;
+    GravityForce gravity(Vector2(0.0f, Config::GRAVITY));
+    world.AddForceGenerator(&gravity);
+    world.SetSnapshotCapacity(SnapshotCapacity);
+    world.SetSubsteps(4);
+    world.SetContactEvents(true);
+    world.SetBodyReordering(true);
+    world.SetWorkerThreads(2);
+
+    AABBShape groundShape(Vector2(400.0f, 20.0f));
+    AABBShape boxShape(Vector2(10.0f, 10.0f));
+    CircleShape circleShape(10.0f);
+    Collider groundCollider(&groundShape), boxCollider(&boxShape), circleCollider(&circleShape);
+
+    std::vector<std::unique_ptr<RigidBody>> bodies;
+    bodies.push_back(std::make_unique<RigidBody>(0.0f));
+    bodies.back()->position = Vector2(400.0f, 500.0f);
+    bodies.back()->collider = &groundCollider;
+    world.AddBody(bodies.back().get());
+    for(int i = 0; i < 30; i++){
+        bodies.push_back(std::make_unique<RigidBody>(1.0f));
+        RigidBody& body = *bodies.back();
+        body.position = Vector2(100.0f + (i % 10) * 60.0f, 460.0f - (i / 10) * 60.0f);
+        body.velocity = Vector2((i % 3 - 1) * 40.0f, 0.0f);
+        body.collider = i % 2 ? &circleCollider : &boxCollider;
+        body.SetInverseInertia(body.collider->shape->GetType());
+        world.AddBody(&body);
+    }
+
+    ParticleSystem& particles = world.GetParticles();
+    particles.gravity = Vector2(0.0f, Config::GRAVITY);
+    for(int i = 0; i < 2000; i++)
+        particles.Spawn(Vector2(150.0f + (i % 100) * 5.0f, 150.0f + (i / 100) * 5.0f), Vector2(0.0f, 0.0f), 2.0f);
+
+    std::vector<ContactEvent> settling;
+    for(int s = 0; s < 30; s++)
+        world.Step(Time::FixedDeltaTime);
+    world.DrainContactEvents(settling);
+
+    std::vector<int> ticks(Ticks);
+    std::vector<uint64_t> hashes(Ticks);
+    for(int s = 0; s < Ticks; s++)
+        ticks[s] = Tick(world, hashes[s]);
+
+    // As far back as the ring reaches, then a short rollback over the resimulated ticks
+    Resimulate(world, ticks, hashes, Ticks - SnapshotCapacity, "deep rollback");
+    Resimulate(world, ticks, hashes, Ticks - 3, "short rollback");
+    Expect("restore older than the ring", !world.RestoreState(ticks[0]));
+
+    std::printf("Rollback: %s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+#include "io/TransformReader.h"
+#include "io/TransformRecorder.h"
+#include "physics/PhysicsWorld.h"
+#include "forces/GravityForce.h"
+#include "shapes/AABBShape.h"
+#include "shapes/CircleShape.h"
+#include "core/Config.h"
+#include "core/Time.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace TransformRecording;
+
+// Records a falling pile with TransformRecorder and reads it back with
+// TransformReader: every frame in order, then from a seek into the middle,
+// then from copies whose chunk headers were altered to exclude the ids
+static const char* RecordingPath = "TransformRecordingTest.rec";
+static const char* CorruptPath = "TransformRecordingTest.corrupt.rec";
+
+static int failures = 0;
+
+static void Expect(const char* what, bool ok){
+    if(ok) return;
+    std::printf("%s\n", what);
+    failures++;
+}
+
+struct Frame{
+    uint64_t step;
+    std::vector<RecordedBody> bodies;
+};
+
+// The awake bodies of the world as TransformRecorder stores them
+static Frame Expected(const PhysicsWorld& world){
+    Frame frame{world.GetStepCount(), {}};
+    for(int i = 0; i < world.GetBodyCount(); i++){
+        const RigidBody* body = world.GetBody(i);
+        if(body->isSleeping) continue;
+        frame.bodies.push_back({body->id, Quantize(body->position.x, PositionScale), Quantize(body->position.y, PositionScale),
+                                Quantize(body->orientation, OrientationScale), Quantize(body->velocity.x, VelocityScale),
+                                Quantize(body->velocity.y, VelocityScale), Quantize(body->angularVelocity, AngularVelocityScale)});
+    }
+    return frame;
+}
+
+static bool Same(const Frame& expected, uint64_t step, const std::vector<RecordedBody>& bodies){
+    if(expected.step != step || expected.bodies.size() != bodies.size()) return false;
+    for(size_t i = 0; i < bodies.size(); i++){
+        if(std::memcmp(&expected.bodies[i], &bodies[i], sizeof(RecordedBody)) != 0) return false;
+    }
+    return true;
+}
+
+// Copy of the recording with the first chunk's idLimit replaced
+static void WriteCorrupt(uint32_t idLimit){
+    std::vector<unsigned char> bytes;
+    if(FILE* in = std::fopen(RecordingPath, "rb")){
+        unsigned char buffer[4096];
+        size_t read;
+        while((read = std::fread(buffer, 1, sizeof(buffer), in)) > 0)
+            bytes.insert(bytes.end(), buffer, buffer + read);
+        std::fclose(in);
+    }
+    if(bytes.size() < FileHeaderSize + ChunkHeaderSize) return;
+    PutU32(&bytes[FileHeaderSize + 28], idLimit);
+    if(FILE* out = std::fopen(CorruptPath, "wb")){
+        std::fwrite(bytes.data(), 1, bytes.size(), out);
+        std::fclose(out);
+    }
+}
+
+int main(){
+    PhysicsWorld world;
+    GravityForce gravity(Vector2(0.0f, Config::GRAVITY));
+    world.AddForceGenerator(&gravity);
+
+    AABBShape groundShape(Vector2(400.0f, 20.0f));
+    AABBShape boxShape(Vector2(10.0f, 10.0f));
+    CircleShape circleShape(10.0f);
+    Collider groundCollider(&groundShape), boxCollider(&boxShape), circleCollider(&circleShape);
+
+    std::vector<std::unique_ptr<RigidBody>> bodies;
+    bodies.push_back(std::make_unique<RigidBody>(0.0f));
+    bodies.back()->position = Vector2(400.0f, 500.0f);
+    bodies.back()->collider = &groundCollider;
+    world.AddBody(bodies.back().get());
+    for(int i = 0; i < 40; i++){
+        bodies.push_back(std::make_unique<RigidBody>(1.0f));
+        RigidBody& body = *bodies.back();
+        body.position = Vector2(100.0f + (i % 10) * 60.0f, 100.0f + (i / 10) * 40.0f);
+        body.velocity = Vector2((i % 3 - 1) * 50.0f, 0.0f);
+        body.collider = i % 2 ? &circleCollider : &boxCollider;
+        body.SetInverseInertia(body.collider->shape->GetType());
+        world.AddBody(&body);
+    }
+
+    TransformRecorder recorder;
+    if(!recorder.Start(RecordingPath, 16)){
+        std::printf("Could not write %s\n", RecordingPath);
+        return 1;
+    }
+    std::vector<Frame> expected;
+    for(int s = 0; s < 150; s++){
+        world.Step(Time::FixedDeltaTime);
+        recorder.Record(world, world.GetStepCount());
+        expected.push_back(Expected(world));
+    }
+    recorder.Stop();
+    Expect("recorder dropped chunks", recorder.GetDroppedChunkCount() == 0);
+
+    TransformReader reader;
+    Expect("open", reader.Open(RecordingPath));
+    Expect("chunk count", reader.GetChunkCount() == 10);
+    Expect("step range", reader.GetFirstStep() == expected.front().step && reader.GetLastStep() == expected.back().step);
+
+    uint64_t step;
+    std::vector<RecordedBody> frame;
+    size_t matched = 0;
+    while(matched < expected.size() && reader.ReadFrame(step, frame) && Same(expected[matched], step, frame))
+        matched++;
+    Expect("frames read back in order", matched == expected.size());
+    Expect("no frame after the last", !reader.ReadFrame(step, frame));
+
+    Expect("seek", reader.Seek(expected[70].step));
+    Expect("frame after seek", reader.ReadFrame(step, frame) && Same(expected[70], step, frame));
+    Expect("next frame after seek", reader.ReadFrame(step, frame) && Same(expected[71], step, frame));
+    reader.Close();
+
+    // Ids at or above the header's limit fail the read
+    WriteCorrupt(1);
+    Expect("open with a low idLimit", reader.Open(CorruptPath));
+    Expect("read past a low idLimit", !reader.ReadFrame(step, frame));
+    reader.Close();
+
+    // A limit past MaxIdLimit ends the file there
+    WriteCorrupt(MaxIdLimit + 1);
+    reader.Open(CorruptPath);
+    Expect("chunk with an oversized idLimit indexed", reader.IsEmpty());
+    reader.Close();
+
+    std::remove(RecordingPath);
+    std::remove(CorruptPath);
+    std::printf("TransformRecording: %s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
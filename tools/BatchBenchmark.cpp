@@ -0,0 +1,91 @@
+#include "physics/PhysicsWorld.h"
+#include "physics/WorldBatch.h"
+#include "forces/GravityForce.h"
+#include "shapes/AABBShape.h"
+#include "shapes/CircleShape.h"
+#include "core/Config.h"
+#include "core/Time.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// Throughput of many small independent worlds stepped through a WorldBatch,
+// set up like a restitution sweep: every world drops the same bodies, each
+// with its own restitution.
+//   BatchBenchmark [worlds] [bodies per world] [worker threads] [steps]
+// Prints world steps per second for one step per batch call and for a block of
+// steps per call, and what extracting positions and velocities costs.
+static int PrintUsage(){
+    std::printf("usage: BatchBenchmark [worlds] [bodies per world] [worker threads] [steps]\n");
+    return 1;
+}
+
+struct SweepWorld{
+    PhysicsWorld world;
+    GravityForce gravity{Vector2(0.0f, Config::GRAVITY)};
+    std::vector<std::unique_ptr<RigidBody>> bodies;
+
+    void Add(const Vector2& position, const Vector2& size, float mass, bool circle, float restitution){
+        bodies.push_back(std::make_unique<RigidBody>(mass));
+        RigidBody* body = bodies.back().get();
+        body->position = position;
+        body->size = size;
+        Shape* shape = circle ? static_cast<Shape*>(new CircleShape(size.x * 0.5f)) : new AABBShape(size / 2);
+        body->collider = new Collider(shape);
+        body->collider->restitution = restitution;
+        body->SetInverseInertia(shape->GetType());
+        world.AddBody(body);
+    }
+};
+
+static void BuildWorld(SweepWorld& scene, int bodyCount, float restitution){
+    scene.world.AddForceGenerator(&scene.gravity);
+    scene.Add(Vector2(300.0f, 625.0f), Vector2(600.0f, 50.0f), 0.0f, false, restitution);
+    scene.Add(Vector2(-10.0f, 300.0f), Vector2(20.0f, 600.0f), 0.0f, false, restitution);
+    scene.Add(Vector2(610.0f, 300.0f), Vector2(20.0f, 600.0f), 0.0f, false, restitution);
+
+    for(int i = 0; i < bodyCount; i++){
+        Vector2 position(40.0f + (i * 37) % 520, 100.0f + (i / 14) * 30.0f);
+        scene.Add(position, Vector2(20.0f, 20.0f), 1.0f, i % 2 == 0, restitution);
+    }
+}
+
+int main(int argc, char** argv){
+    int worldCount = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int bodyCount = argc > 2 ? std::atoi(argv[2]) : 20;
+    int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+    int steps = argc > 4 ? std::atoi(argv[4]) : 120;
+    if(worldCount < 1 || bodyCount < 0 || threads < 0 || steps < 1) return PrintUsage();
+
+    std::vector<std::unique_ptr<SweepWorld>> scenes;
+    WorldBatch batch;
+    batch.SetWorkerThreads(threads);
+    for(int w = 0; w < worldCount; w++){
+        scenes.push_back(std::make_unique<SweepWorld>());
+        BuildWorld(*scenes.back(), bodyCount, worldCount > 1 ? static_cast<float>(w) / (worldCount - 1) : 0.5f);
+        batch.Add(&scenes.back()->world);
+    }
+
+    std::printf("%d worlds of %d bodies, %d worker threads, %d steps\n", worldCount, bodyCount, threads, steps);
+
+    auto start = std::chrono::steady_clock::now();
+    for(int s = 0; s < steps; s++)
+        batch.Step(Time::FixedDeltaTime);
+    double single = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-22s %14.0f world steps/s\n", "1 step per call", static_cast<double>(worldCount) * steps / single);
+
+    batch.Step(Time::FixedDeltaTime, steps);
+    std::printf("%-22s %14.0f world steps/s\n", "all steps per call", batch.GetStepsPerSecond());
+
+    uint32_t fields = ObservePosition | ObserveVelocity;
+    int bodiesPerWorld = bodyCount + 3;
+    std::vector<float> observations(static_cast<size_t>(worldCount) * bodiesPerWorld * WorldBatch::GetFloatsPerBody(fields));
+    start = std::chrono::steady_clock::now();
+    batch.Extract(fields, bodiesPerWorld, observations.data());
+    double extract = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-22s %14.1f us (%zu floats)\n", "extract", extract, observations.size());
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include "physics/RigidBody.h"
+#include "physics/SpatialHash.h"
+#include "collision/Collision.h"
+#include "collision/CollisionResolver.h"
+#include "shapes/AABBShape.h"
+#include "shapes/CircleShape.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Per-call cost of the collision kernels, the reference for layout or SIMD work
+// on them. Inputs are random but seeded, so runs are comparable; hitRatio is
+// the share of cases that collide (for Resolve: that approach rather than
+// separate, for the broadphase: bodies that share cells with neighbours).
+//   KernelBenchmark [hit ratio] [cases] [runs] [seed] [kernel]
+// Each run goes over the cases until about OpsPerRun calls have been made; the
+// fastest run is reported as ns/op, ops/s and, on x86, time stamp counter ticks
+// per op (reference cycles, not core cycles under frequency scaling).
+static int PrintUsage(){
+    std::printf("usage: KernelBenchmark [hit ratio 0..1] [cases] [runs] [seed] [kernel]\n"
+                "kernels: obb circle obbcircle hash resolve\n");
+    return 1;
+}
+
+static const long OpsPerRun = 2000000;
+static const int HashBodies = 1024;     // Bodies per broadphase rebuild
+static const float HashCellSize = 100.0f;
+
+static uint64_t ReadTimestamp(){
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static bool HasTimestamp(){
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Two bodies and their shapes; the colliders point into the case, so cases
+// stay where they were allocated
+struct Case{
+    RigidBody a, b;
+    AABBShape boxA{Vector2(1.0f, 1.0f)}, boxB{Vector2(1.0f, 1.0f)};
+    CircleShape circleA{1.0f}, circleB{1.0f};
+    Collider colliderA{nullptr}, colliderB{nullptr};
+    CollisionManifold manifold;
+    // Motion to restore before each Resolve
+    Vector2 positionA, positionB, velocityA, velocityB;
+    float angularA = 0.0f, angularB = 0.0f;
+};
+
+enum class PairKind { Boxes, Circles, BoxCircle };
+
+struct Generator{
+    std::mt19937 rng;
+    explicit Generator(unsigned seed) : rng(seed) {}
+    float Uniform(float lo, float hi){ return std::uniform_real_distribution<float>(lo, hi)(rng); }
+};
+
+static bool Collide(PairKind kind, Case& c){
+    c.manifold = CollisionManifold();
+    switch(kind){
+        case PairKind::Boxes: return Collision::OBBvsOBB(c.a, c.b, c.manifold);
+        case PairKind::Circles: return Collision::CirclevsCircle(c.a, c.b, c.circleA, c.circleB, c.manifold);
+        case PairKind::BoxCircle: return Collision::OBBvsCircle(c.a, c.b, c.boxA, c.circleB, c.manifold);
+    }
+    return false;
+}
+
+// Random pairs within reach of each other, kept or thrown away until the
+// requested share of them collide
+static std::vector<std::unique_ptr<Case>> MakeCases(PairKind kind, int count, float hitRatio, Generator& gen){
+    std::vector<std::unique_ptr<Case>> cases;
+    int hitsWanted = static_cast<int>(std::lround(count * hitRatio));
+    int hits = 0, misses = 0;
+    while(hits + misses < count){
+        auto c = std::make_unique<Case>();
+        c->boxA.halfsize = Vector2(gen.Uniform(5.0f, 30.0f), gen.Uniform(5.0f, 30.0f));
+        c->boxB.halfsize = Vector2(gen.Uniform(5.0f, 30.0f), gen.Uniform(5.0f, 30.0f));
+        c->circleA.radius = gen.Uniform(5.0f, 30.0f);
+        c->circleB.radius = gen.Uniform(5.0f, 30.0f);
+        c->colliderA.shape = kind == PairKind::Circles ? static_cast<Shape*>(&c->circleA) : &c->boxA;
+        c->colliderB.shape = kind == PairKind::Boxes ? static_cast<Shape*>(&c->boxB) : &c->circleB;
+        c->a.collider = &c->colliderA;
+        c->b.collider = &c->colliderB;
+        c->a.SetInverseInertia(c->colliderA.shape->GetType());
+        c->b.SetInverseInertia(c->colliderB.shape->GetType());
+
+        float angle = gen.Uniform(0.0f, 6.2831853f);
+        float distance = gen.Uniform(0.0f, 90.0f);
+        c->a.position = Vector2(gen.Uniform(-1000.0f, 1000.0f), gen.Uniform(-1000.0f, 1000.0f));
+        c->b.position = c->a.position + Vector2(std::cos(angle), std::sin(angle)) * distance;
+        c->a.orientation = gen.Uniform(-3.1415927f, 3.1415927f);
+        c->b.orientation = gen.Uniform(-3.1415927f, 3.1415927f);
+
+        bool hit = Collide(kind, *c);
+        if(hit ? hits >= hitsWanted : misses >= count - hitsWanted) continue;
+        (hit ? hits : misses)++;
+        cases.push_back(std::move(c));
+    }
+    return cases;
+}
+
+struct Result{
+    double nsPerOp;
+    double ticksPerOp;
+    long ops;
+    long hits;
+};
+
+// Best of runs; op(i) handles case i and returns its hits. A template, so the
+// kernel call is inlined into the loop rather than made through a pointer
+template<class Op>
+static Result Measure(int caseCount, int runs, long opsPerRun, const Op& op){
+    long passes = std::max(1L, opsPerRun / caseCount);
+    Result best{1e300, 0.0, passes * caseCount, 0};
+    for(int run = 0; run < runs; run++){
+        long hits = 0;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t startTicks = ReadTimestamp();
+        for(long pass = 0; pass < passes; pass++){
+            for(int i = 0; i < caseCount; i++)
+                hits += op(i);
+        }
+        uint64_t ticks = ReadTimestamp() - startTicks;
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        double nsPerOp = ns / best.ops;
+        if(nsPerOp < best.nsPerOp){
+            best.nsPerOp = nsPerOp;
+            best.ticksPerOp = static_cast<double>(ticks) / best.ops;
+        }
+        best.hits = hits;
+    }
+    return best;
+}
+
+static void Print(const char* name, const Result& r){
+    char ticks[32] = "-";
+    if(HasTimestamp()) std::snprintf(ticks, sizeof(ticks), "%.1f", r.ticksPerOp);
+    std::printf("%-12s %12.2f %14.0f %12s %10.3f\n", name, r.nsPerOp, 1e9 / r.nsPerOp, ticks,
+                static_cast<double>(r.hits) / r.ops);
+}
+
+static Result BenchPairs(PairKind kind, int caseCount, float hitRatio, int runs, Generator& gen){
+    std::vector<std::unique_ptr<Case>> cases = MakeCases(kind, caseCount, hitRatio, gen);
+    return Measure(caseCount, runs, OpsPerRun, [&](int i){ return Collide(kind, *cases[i]) ? 1 : 0; });
+}
+
+// Box pairs that touch; hits approach each other and take an impulse, misses
+// separate and leave after the position correction. Every call first puts
+// the two bodies back where the case started, which is included in the time
+static Result BenchResolve(int caseCount, float hitRatio, int runs, Generator& gen){
+    std::vector<std::unique_ptr<Case>> cases = MakeCases(PairKind::Boxes, caseCount, 1.0f, gen);
+    int hitsWanted = static_cast<int>(std::lround(caseCount * hitRatio));
+    for(int i = 0; i < caseCount; i++){
+        Case& c = *cases[i];
+        float speed = gen.Uniform(50.0f, 400.0f) * (i < hitsWanted ? 1.0f : -1.0f);
+        c.positionA = c.a.position;
+        c.positionB = c.b.position;
+        c.velocityA = c.manifold.normal * (0.5f * speed);
+        c.velocityB = c.manifold.normal * (-0.5f * speed);
+        c.angularA = gen.Uniform(-2.0f, 2.0f);
+        c.angularB = gen.Uniform(-2.0f, 2.0f);
+    }
+    std::shuffle(cases.begin(), cases.end(), gen.rng);
+
+    return Measure(caseCount, runs, OpsPerRun, [&](int i){
+        Case& c = *cases[i];
+        c.a.position = c.positionA;
+        c.b.position = c.positionB;
+        c.a.velocity = c.velocityA;
+        c.b.velocity = c.velocityB;
+        c.a.angularVelocity = c.angularA;
+        c.b.angularVelocity = c.angularB;
+        return CollisionResolver::Resolve(c.a, c.b, c.manifold, 1.0f / 60.0f) > 0.0f ? 1 : 0;
+    });
+}
+
+// One op is a whole rebuild: Clear, Insert every body, GetPotentialCollisions.
+// Bodies sit one per cell; hits are moved onto a cell corner, where they
+// share cells with their neighbours. Each case is a different layout
+static Result BenchHash(int caseCount, float hitRatio, int runs, Generator& gen){
+    int layouts = std::max(1, std::min(caseCount, 16));
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(HashBodies))));
+    std::vector<std::vector<AABB>> bounds(layouts);
+    for(auto& layout : bounds){
+        for(int i = 0; i < HashBodies; i++){
+            Vector2 cell((i % side) * HashCellSize, (i / side) * HashCellSize);
+            Vector2 half(gen.Uniform(5.0f, 20.0f), gen.Uniform(5.0f, 20.0f));
+            Vector2 centre = gen.Uniform(0.0f, 1.0f) < hitRatio ? cell
+                           : cell + Vector2(HashCellSize, HashCellSize) * 0.5f;
+            layout.push_back({centre - half, centre + half});
+        }
+    }
+
+    SpatialHash hash(HashCellSize);
+    hash.Reserve(HashBodies);
+    std::vector<std::pair<int, int>> pairs;
+    Result r = Measure(layouts, runs, OpsPerRun / HashBodies, [&](int i){
+        hash.Clear();
+        for(int k = 0; k < HashBodies; k++)
+            hash.Insert(bounds[i][k], k);
+        hash.GetPotentialCollisions(pairs);
+        return static_cast<int>(pairs.size());
+    });
+    // Report per body, with pairs found per body as the hit column
+    r.nsPerOp /= HashBodies;
+    r.ticksPerOp /= HashBodies;
+    r.ops *= HashBodies;
+    return r;
+}
+
+int main(int argc, char** argv){
+    float hitRatio = argc > 1 ? static_cast<float>(std::atof(argv[1])) : 0.5f;
+    int caseCount = argc > 2 ? std::atoi(argv[2]) : 4096;
+    int runs = argc > 3 ? std::atoi(argv[3]) : 5;
+    unsigned seed = argc > 4 ? static_cast<unsigned>(std::atol(argv[4])) : 1u;
+    const char* only = argc > 5 ? argv[5] : nullptr;
+    if(hitRatio < 0.0f || hitRatio > 1.0f || caseCount < 1 || runs < 1) return PrintUsage();
+
+    std::printf("hit ratio %.2f, %d cases, best of %d runs, seed %u\n", hitRatio, caseCount, runs, seed);
+    std::printf("%-12s %12s %14s %12s %10s\n", "kernel", "ns/op", "ops/s", "ticks/op", "hits/op");
+
+    struct Kernel{ const char* name; std::function<Result(Generator&)> run; };
+    const Kernel kernels[] = {
+        {"obb", [&](Generator& gen){ return BenchPairs(PairKind::Boxes, caseCount, hitRatio, runs, gen); }},
+        {"circle", [&](Generator& gen){ return BenchPairs(PairKind::Circles, caseCount, hitRatio, runs, gen); }},
+        {"obbcircle", [&](Generator& gen){ return BenchPairs(PairKind::BoxCircle, caseCount, hitRatio, runs, gen); }},
+        {"hash", [&](Generator& gen){ return BenchHash(caseCount, hitRatio, runs, gen); }},
+        {"resolve", [&](Generator& gen){ return BenchResolve(caseCount, hitRatio, runs, gen); }},
+    };
+    bool found = false;
+    for(const Kernel& kernel : kernels){
+        if(only && std::strcmp(only, kernel.name) != 0) continue;
+        found = true;
+        // Every kernel gets its own stream, so filtering doesn't change the inputs
+        Generator gen(seed * 7919u + static_cast<unsigned>(&kernel - kernels));
+        Print(kernel.name, kernel.run(gen));
+    }
+    return found ? 0 : PrintUsage();
+}
@@ -0,0 +1,125 @@
+#include "physics/PhysicsWorld.h"
+#include "forces/GravityForce.h"
+#include "shapes/AABBShape.h"
+#include "core/Config.h"
+#include "core/Time.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// Cost of a particle step against the 60 Hz frame budget. Particles are poured
+// as a block into a walled basin with a few boxes on the floor, then stepped at
+// the fixed rate, once on the calling thread and once with worker threads.
+//   ParticleBenchmark [particles] [worker threads] [steps]
+// Both runs must end with the same checksum: the particle passes give the same
+// result for any number of threads.
+static int PrintUsage(){
+    std::printf("usage: ParticleBenchmark [particles] [worker threads] [steps]\n");
+    return 1;
+}
+
+static const float ParticleRadius = 1.5f;
+static const float Spacing = 3.2f;
+static const float GroundTop = 0.0f;
+
+struct Scene{
+    PhysicsWorld world;
+    GravityForce gravity{Vector2(0.0f, Config::GRAVITY)};
+    std::vector<std::unique_ptr<RigidBody>> bodies;
+
+    void AddBox(const Vector2& position, const Vector2& size, float mass){
+        bodies.push_back(std::make_unique<RigidBody>(mass));
+        RigidBody* body = bodies.back().get();
+        body->position = position;
+        body->size = size;
+        body->collider = new Collider(new AABBShape(size / 2));
+        body->SetInverseInertia(body->collider->shape->GetType());
+        world.AddBody(body);
+    }
+};
+
+// A square block of particles above a basin twice its width
+static void BuildScene(Scene& scene, int count){
+    int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+    float width = columns * Spacing;
+
+    scene.world.AddForceGenerator(&scene.gravity);
+    scene.world.GetParticles().gravity = Vector2(0.0f, Config::GRAVITY);
+    scene.AddBox(Vector2(0.0f, GroundTop + 50.0f), Vector2(width * 2.0f + 200.0f, 100.0f), 0.0f);
+    scene.AddBox(Vector2(-width - 50.0f, GroundTop - width), Vector2(100.0f, width * 2.0f), 0.0f);
+    scene.AddBox(Vector2(width + 50.0f, GroundTop - width), Vector2(100.0f, width * 2.0f), 0.0f);
+    for(int i = 0; i < 8; i++)
+        scene.AddBox(Vector2(-width + (i + 0.5f) * width / 4.0f, GroundTop - 20.0f), Vector2(40.0f, 40.0f), 1.0f);
+
+    ParticleSystem& particles = scene.world.GetParticles();
+    particles.Reserve(count);
+    for(int i = 0; i < count; i++){
+        float x = -width * 0.5f + (i % columns) * Spacing;
+        float y = GroundTop - 100.0f - width - (i / columns) * Spacing;
+        particles.Spawn(Vector2(x, y), Vector2(0.0f, 0.0f), ParticleRadius);
+    }
+}
+
+// FNV-1a over particle positions and velocities
+static uint64_t Checksum(const ParticleSystem& particles){
+    uint64_t hash = 1469598103934665603ull;
+    for(int i = 0; i < particles.GetCount(); i++){
+        Vector2 values[2] = { particles.GetPosition(i), particles.GetVelocity(i) };
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+        for(size_t k = 0; k < sizeof(values); k++){
+            hash ^= bytes[k];
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+struct Result{
+    double msPerStep;
+    double worstMs;
+    uint64_t checksum;
+};
+
+static Result Run(int count, int threads, int steps){
+    Scene scene;
+    BuildScene(scene, count);
+    scene.world.SetWorkerThreads(threads);
+
+    Result result{};
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < steps; i++){
+        auto stepStart = std::chrono::steady_clock::now();
+        scene.world.Step(Time::FixedDeltaTime);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepStart).count();
+        if(ms > result.worstMs) result.worstMs = ms;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    result.msPerStep = std::chrono::duration<double, std::milli>(end - start).count() / steps;
+    result.checksum = Checksum(scene.world.GetParticles());
+    return result;
+}
+
+int main(int argc, char** argv){
+    int count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int threads = argc > 2 ? std::atoi(argv[2]) : 3;
+    int steps = argc > 3 ? std::atoi(argv[3]) : 120;
+    if(count < 1 || threads < 0 || steps < 1) return PrintUsage();
+
+    const double budgetMs = 1000.0 / 60.0;
+    std::printf("%d particles, %d steps at 60 Hz (%.2f ms budget)\n", count, steps, budgetMs);
+    std::printf("%-10s %10s %10s %10s %18s\n", "threads", "ms/step", "worst", "budget", "checksum");
+
+    const int setups[] = { 0, threads };
+    for(int setup = 0; setup < (threads > 0 ? 2 : 1); setup++){
+        Result r = Run(count, setups[setup], steps);
+        std::printf("%-10d %10.3f %10.3f %9.0f%% %18llx\n", setups[setup], r.msPerStep, r.worstMs,
+                    100.0 * r.msPerStep / budgetMs, static_cast<unsigned long long>(r.checksum));
+    }
+    return 0;
+}
@@ -0,0 +1,341 @@
+#include "physics/PartitionedWorld.h"
+#include "physics/PhysicsWorld.h"
+#include "io/PartitionTransport.h"
+#include "forces/GravityForce.h"
+#include "shapes/AABBShape.h"
+#include "shapes/CircleShape.h"
+#include "core/Config.h"
+#include "core/Time.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Run one scene as a PartitionedWorld split over several processes talking
+// through Unix sockets, and as a single world, and compare the two step by
+// step.
+//   PartitionTool [partitions] [steps] [bodies]
+// A body counts as a boundary body from the first step it comes within the
+// ghost width of a partition boundary in either run, or near a boundary body;
+// all other bodies must match the single world bit for bit. Prints how far
+// boundary bodies drifted and exits non-zero on any mismatch.
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int PrintUsage(){
+    std::printf("usage: PartitionTool [partitions] [steps] [bodies]\n");
+    return 1;
+}
+
+static const float SceneWidth = 4000.0f;
+static const float FloorBottom = 850.0f;
+static const float ProximityMargin = 16.0f; // Covers a step of motion at the speeds in the scene
+
+// What partitions report per owned body each step
+struct BodySample{
+    uint32_t id;
+    float positionX, positionY;
+    float velocityX, velocityY;
+    float orientation;
+    float angularVelocity;
+};
+
+struct SceneBodies{
+    std::vector<std::unique_ptr<RigidBody>> bodies;
+    std::vector<std::unique_ptr<Shape>> shapes;
+    std::vector<std::unique_ptr<Collider>> colliders;
+
+    void Add(const Vector2& position, const Vector2& size, float mass, bool circle){
+        bodies.push_back(std::make_unique<RigidBody>(mass));
+        RigidBody* body = bodies.back().get();
+        body->id = static_cast<uint32_t>(bodies.size() - 1);
+        body->position = position;
+        body->size = size;
+        if(circle) shapes.push_back(std::make_unique<CircleShape>(size.x * 0.5f));
+        else shapes.push_back(std::make_unique<AABBShape>(size / 2));
+        colliders.push_back(std::make_unique<Collider>(shapes.back().get()));
+        body->collider = colliders.back().get();
+        body->SetInverseInertia(shapes.back()->GetType());
+    }
+};
+
+// Statics first (ground, walls and a bin per pile), then the bodies, dropped
+// into the bins, some of which straddle partition boundaries. A few are
+// thrown sideways so they cross strips
+static void BuildScene(SceneBodies& scene, int bodyCount){
+    const float pileSpacing = 250.0f;
+    int piles = static_cast<int>(SceneWidth / pileSpacing) - 1;
+
+    scene.Add(Vector2(SceneWidth * 0.5f, 825.0f), Vector2(SceneWidth, 50.0f), 0.0f, false);
+    scene.Add(Vector2(-10.0f, 400.0f), Vector2(20.0f, 800.0f), 0.0f, false);
+    scene.Add(Vector2(SceneWidth + 10.0f, 400.0f), Vector2(20.0f, 800.0f), 0.0f, false);
+    for(int p = 0; p < piles; p++){
+        float pileX = pileSpacing * (1 + p);
+        scene.Add(Vector2(pileX - 70.0f, 600.0f), Vector2(20.0f, 400.0f), 0.0f, false);
+        scene.Add(Vector2(pileX + 70.0f, 600.0f), Vector2(20.0f, 400.0f), 0.0f, false);
+    }
+
+    uint32_t seed = 12345;
+    auto next = [&seed](){ seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+    for(int i = 0; i < bodyCount; i++){
+        float pileX = pileSpacing * (1 + i % piles);
+        Vector2 position(pileX + (next() - 0.5f) * 80.0f, 100.0f + next() * 600.0f);
+        float size = 12.0f + next() * 16.0f;
+        scene.Add(position, Vector2(size, size), 1.0f, next() < 0.5f);
+        if(next() < 0.01f)
+            scene.bodies.back()->velocity = Vector2((next() - 0.5f) * 800.0f, -500.0f);
+    }
+}
+
+static void Configure(PhysicsWorld& world, GravityForce& gravity){
+    world.AddForceGenerator(&gravity);
+    world.SetResidualTolerance(0.0f);
+    world.SetBodyReordering(false);
+}
+
+static bool WriteAll(int fd, const void* data, size_t size){
+    const char* bytes = static_cast<const char*>(data);
+    while(size > 0){
+        ssize_t written = write(fd, bytes, size);
+        if(written <= 0) return false;
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+static bool ReadAll(int fd, void* data, size_t size){
+    char* bytes = static_cast<char*>(data);
+    while(size > 0){
+        ssize_t got = read(fd, bytes, size);
+        if(got <= 0) return false;
+        bytes += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+static int RunPartition(int partition, const std::vector<float>& boundaries, const std::string& prefix,
+                        int steps, int bodyCount, int out){
+    std::vector<int> peers;
+    if(partition > 0) peers.push_back(partition - 1);
+    if(partition < static_cast<int>(boundaries.size())) peers.push_back(partition + 1);
+
+    UnixSocketTransport transport;
+    if(!transport.Open(prefix.c_str(), partition, peers)){
+        std::fprintf(stderr, "partition %d: could not connect to its neighbours\n", partition);
+        return 1;
+    }
+
+    PartitionedWorld partitioned(partition, boundaries, transport);
+    GravityForce gravity(Vector2(0.0f, Config::GRAVITY));
+    Configure(partitioned.GetWorld(), gravity);
+
+    SceneBodies scene;
+    BuildScene(scene, bodyCount);
+    for(auto& body : scene.bodies)
+        partitioned.AddBody(body.get());
+
+    std::vector<RigidBody*> owned;
+    std::vector<BodySample> samples;
+    for(int s = 0; s < steps; s++){
+        if(!partitioned.Step(Time::FixedDeltaTime)){
+            std::fprintf(stderr, "partition %d: exchange failed at step %d\n", partition, s);
+            return 1;
+        }
+        partitioned.GetOwnedBodies(owned);
+        samples.clear();
+        for(const RigidBody* body : owned){
+            samples.push_back({body->id, body->position.x, body->position.y, body->velocity.x, body->velocity.y,
+                               body->orientation, body->angularVelocity});
+        }
+        uint32_t count = static_cast<uint32_t>(samples.size());
+        if(!WriteAll(out, &count, sizeof(count)) || !WriteAll(out, samples.data(), count * sizeof(BodySample)))
+            return 1;
+    }
+    return 0;
+}
+
+static bool SameBits(const BodySample& a, const BodySample& b){
+    return a.positionX == b.positionX && a.positionY == b.positionY &&
+           a.velocityX == b.velocityX && a.velocityY == b.velocityY &&
+           a.orientation == b.orientation && a.angularVelocity == b.angularVelocity;
+}
+
+// Mark bodies near a boundary, then everything within reach of a marked body
+static void SpreadBoundary(const std::vector<BodySample>& state, const std::vector<float>& extent,
+                           const std::vector<float>& boundaries, float ghostWidth, std::vector<char>& boundary){
+    int count = static_cast<int>(state.size());
+    for(int i = 0; i < count; i++){
+        for(float b : boundaries){
+            if(std::fabs(state[i].positionX - b) < ghostWidth + extent[i]) boundary[i] = 1;
+        }
+    }
+
+    std::vector<int> order(count);
+    for(int i = 0; i < count; i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](int a, int b){
+        return state[a].positionX - extent[a] < state[b].positionX - extent[b];
+    });
+    std::vector<std::vector<int>> near(count);
+    for(int a = 0; a < count; a++){
+        int i = order[a];
+        float maxX = state[i].positionX + extent[i] + ProximityMargin;
+        for(int b = a + 1; b < count; b++){
+            int j = order[b];
+            if(state[j].positionX - extent[j] > maxX) break;
+            if(std::fabs(state[i].positionY - state[j].positionY) > extent[i] + extent[j] + ProximityMargin) continue;
+            near[i].push_back(j);
+            near[j].push_back(i);
+        }
+    }
+
+    std::vector<int> stack;
+    for(int i = 0; i < count; i++)
+        if(boundary[i]) stack.push_back(i);
+    while(!stack.empty()){
+        int i = stack.back();
+        stack.pop_back();
+        for(int j : near[i]){
+            if(!boundary[j]){
+                boundary[j] = 1;
+                stack.push_back(j);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    int partitions = argc > 1 ? std::atoi(argv[1]) : 4;
+    int steps = argc > 2 ? std::atoi(argv[2]) : 600;
+    int bodyCount = argc > 3 ? std::atoi(argv[3]) : 600;
+    if(partitions < 1 || steps < 1 || bodyCount < 0) return PrintUsage();
+
+    std::vector<float> boundaries;
+    for(int p = 1; p < partitions; p++)
+        boundaries.push_back(SceneWidth * p / partitions);
+    std::string prefix = "/tmp/ngen2d-partition-" + std::to_string(getpid()) + "-";
+
+    std::vector<int> pipes(partitions);
+    std::vector<pid_t> children(partitions);
+    for(int p = 0; p < partitions; p++){
+        int fds[2];
+        if(pipe(fds) != 0) return 1;
+        children[p] = fork();
+        if(children[p] == 0){
+            close(fds[0]);
+            _exit(RunPartition(p, boundaries, prefix, steps, bodyCount, fds[1]));
+        }
+        close(fds[1]);
+        pipes[p] = fds[0];
+    }
+
+    PhysicsWorld world;
+    GravityForce gravity(Vector2(0.0f, Config::GRAVITY));
+    Configure(world, gravity);
+    SceneBodies scene;
+    BuildScene(scene, bodyCount);
+    for(auto& body : scene.bodies)
+        world.AddBody(body.get());
+
+    // Dynamic bodies only, by id - statics
+    const int statics = static_cast<int>(scene.bodies.size()) - bodyCount;
+    std::vector<float> extent(bodyCount);
+    for(int i = 0; i < bodyCount; i++){
+        const RigidBody& body = *scene.bodies[statics + i];
+        extent[i] = std::max(body.size.x, body.size.y) * 0.75f;
+    }
+
+    std::vector<BodySample> reference(bodyCount), partitioned(bodyCount), received;
+    std::vector<char> boundary(bodyCount, 0), seen(bodyCount);
+    for(int i = 0; i < bodyCount; i++){
+        const RigidBody& body = *scene.bodies[statics + i];
+        reference[i] = {body.id, body.position.x, body.position.y, body.velocity.x, body.velocity.y,
+                        body.orientation, body.angularVelocity};
+    }
+    SpreadBoundary(reference, extent, boundaries, Config::PartitionGhostWidth, boundary);
+
+    int mismatches = 0, lost = 0;
+    for(int s = 0; s < steps && lost == 0; s++){
+        world.Step(Time::FixedDeltaTime);
+        for(int i = 0; i < bodyCount; i++){
+            const RigidBody& body = *scene.bodies[statics + i];
+            reference[i] = {body.id, body.position.x, body.position.y, body.velocity.x, body.velocity.y,
+                            body.orientation, body.angularVelocity};
+        }
+
+        std::fill(seen.begin(), seen.end(), 0);
+        for(int p = 0; p < partitions; p++){
+            uint32_t count = 0;
+            if(!ReadAll(pipes[p], &count, sizeof(count))){
+                std::fprintf(stderr, "partition %d stopped at step %d\n", p, s);
+                return 1;
+            }
+            received.resize(count);
+            if(!ReadAll(pipes[p], received.data(), count * sizeof(BodySample))) return 1;
+            for(const BodySample& sample : received){
+                int i = static_cast<int>(sample.id) - statics;
+                if(i < 0 || i >= bodyCount || seen[i]++) lost++;
+                else partitioned[i] = sample;
+            }
+        }
+        for(int i = 0; i < bodyCount; i++)
+            if(!seen[i]) lost++;
+        if(lost > 0){
+            std::printf("step %d: bodies missing or owned twice\n", s);
+            break;
+        }
+
+        SpreadBoundary(reference, extent, boundaries, Config::PartitionGhostWidth, boundary);
+        SpreadBoundary(partitioned, extent, boundaries, Config::PartitionGhostWidth, boundary);
+        for(int i = 0; i < bodyCount; i++){
+            if(!boundary[i] && !SameBits(reference[i], partitioned[i])){
+                if(mismatches++ < 10)
+                    std::printf("step %d: body %u differs from the single world\n", s, reference[i].id);
+            }
+        }
+    }
+
+    for(int p = 0; p < partitions; p++){
+        close(pipes[p]);
+        int status = 0;
+        waitpid(children[p], &status, 0);
+    }
+
+    // Fast landings can push small bodies through the floor in either run
+    int boundaryCount = 0, fellReference = 0, fellPartitioned = 0;
+    float maxDrift = 0.0f, totalDrift = 0.0f;
+    for(int i = 0; i < bodyCount; i++){
+        if(reference[i].positionY > FloorBottom) fellReference++;
+        if(partitioned[i].positionY > FloorBottom) fellPartitioned++;
+        if(!boundary[i]) continue;
+        boundaryCount++;
+        float dx = reference[i].positionX - partitioned[i].positionX;
+        float dy = reference[i].positionY - partitioned[i].positionY;
+        float drift = std::sqrt(dx * dx + dy * dy);
+        maxDrift = std::max(maxDrift, drift);
+        totalDrift += drift;
+    }
+
+    std::printf("%d partitions, %d bodies, %d steps\n", partitions, bodyCount, steps);
+    std::printf("interior bodies:  %d, %d mismatched samples\n", bodyCount - boundaryCount, mismatches);
+    std::printf("boundary bodies:  %d, drift mean %.3f max %.3f px\n", boundaryCount,
+                boundaryCount > 0 ? totalDrift / boundaryCount : 0.0f, maxDrift);
+    std::printf("fell through floor: %d single world, %d partitioned\n", fellReference, fellPartitioned);
+    return mismatches == 0 && lost == 0 ? 0 : 1;
+}
+
+#else
+
+int main(){
+    std::printf("PartitionTool needs Unix domain sockets\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "io/TransformReader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace TransformRecording;
+
+// Inspect transform recordings written by TransformRecorder.
+//   RecordingTool info <file>
+//   RecordingTool dump <file> <step> [stepCount]
+static int PrintUsage(){
+    std::printf("usage: RecordingTool info <file>\n"
+                "       RecordingTool dump <file> <step> [stepCount]\n");
+    return 1;
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 3)
+        return PrintUsage();
+
+    TransformReader reader;
+    if(!reader.Open(argv[2])){
+        std::fprintf(stderr, "Could not open recording: %s\n", argv[2]);
+        return 1;
+    }
+
+    if(std::strcmp(argv[1], "info") == 0){
+        std::printf("chunks: %zu\n", reader.GetChunkCount());
+        std::printf("steps:  %llu - %llu\n",
+                    static_cast<unsigned long long>(reader.GetFirstStep()),
+                    static_cast<unsigned long long>(reader.GetLastStep()));
+        return 0;
+    }
+
+    if(std::strcmp(argv[1], "dump") == 0 && argc >= 4){
+        uint64_t start = std::strtoull(argv[3], nullptr, 10);
+        long stepCount = argc >= 5 ? std::strtol(argv[4], nullptr, 10) : 1;
+
+        if(!reader.Seek(start)){
+            std::fprintf(stderr, "Step %llu is not in the recording\n", static_cast<unsigned long long>(start));
+            return 1;
+        }
+
+        uint64_t step;
+        std::vector<RecordedBody> frame;
+        for(long n = 0; n < stepCount && reader.ReadFrame(step, frame); n++){
+            std::printf("step %llu: %zu awake\n", static_cast<unsigned long long>(step), frame.size());
+            for(const RecordedBody& body : frame){
+                std::printf("  id %u pos (%.2f, %.2f) rot %.4f vel (%.2f, %.2f) w %.4f\n",
+                            body.id,
+                            Dequantize(body.positionX, PositionScale),
+                            Dequantize(body.positionY, PositionScale),
+                            Dequantize(body.orientation, OrientationScale),
+                            Dequantize(body.velocityX, VelocityScale),
+                            Dequantize(body.velocityY, VelocityScale),
+                            Dequantize(body.angularVelocity, AngularVelocityScale));
+            }
+        }
+        return 0;
+    }
+
+    return PrintUsage();
+}
@@ -0,0 +1,308 @@
+#include "Sandbox.h"
+#include "Spawns.h"
+#include "core/Time.h"
+#include "io/TransformRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Replay an input script against the demo's Sandbox headlessly and check the
+// result against a baseline, for catching changes in behaviour or speed.
+//   ReplayTool run <script> [repeats]
+//   ReplayTool record <script> <baseline> [repeats]
+//   ReplayTool check <script> <baseline> [tolerance] [repeats]
+//   ReplayTool capture <script> <recording>
+// The script is replayed repeats times (default 5) from a fresh Sandbox. Every
+// replay must end in the same state hash; step times from all of them make up
+// the distribution. check fails (exit code 1) if the hash or step count differ
+// from the baseline, or the median or 90th percentile step time grew by more
+// than tolerance (default 0.25, i.e. 25%). Timings only compare on the machine
+// that recorded the baseline. capture replays once and streams every step to
+// a transform recording (see TransformRecorder) for RecordingTool.
+//
+// Script lines (# starts a comment):
+//   step <count>                 fixed steps of Time::FixedDeltaTime
+//   ball|hexagon|burst <x> <y>   left, middle and right click in the demo
+//   iterations|substeps|threads <count>
+//   speculative 0|1
+static int PrintUsage(){
+    std::printf("usage: ReplayTool run <script> [repeats]\n"
+                "       ReplayTool record <script> <baseline> [repeats]\n"
+                "       ReplayTool check <script> <baseline> [tolerance] [repeats]\n"
+                "       ReplayTool capture <script> <recording>\n");
+    return 1;
+}
+
+enum class CommandType { Step, Ball, Hexagon, Burst, Iterations, Substeps, Threads, Speculative };
+
+struct Command{
+    CommandType type;
+    long count;     // Steps or setting
+    Vector2 position;
+};
+
+struct Distribution{
+    long steps = 0;
+    double meanUs = 0.0, medianUs = 0.0, p90Us = 0.0, p99Us = 0.0, maxUs = 0.0;
+};
+
+struct Baseline{
+    uint64_t hash = 0;
+    Distribution times;
+};
+
+static bool LoadScript(const char* path, std::vector<Command>& commands){
+    FILE* file = std::fopen(path, "r");
+    if(!file){
+        std::fprintf(stderr, "Could not open script: %s\n", path);
+        return false;
+    }
+
+    struct Keyword{ const char* name; CommandType type; bool spawn; };
+    const Keyword keywords[] = {
+        {"step", CommandType::Step, false}, {"ball", CommandType::Ball, true},
+        {"hexagon", CommandType::Hexagon, true}, {"burst", CommandType::Burst, true},
+        {"iterations", CommandType::Iterations, false}, {"substeps", CommandType::Substeps, false},
+        {"threads", CommandType::Threads, false}, {"speculative", CommandType::Speculative, false},
+    };
+
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while(ok && std::fgets(line, sizeof(line), file)){
+        lineNumber++;
+        if(char* comment = std::strchr(line, '#')) *comment = '\0';
+        char word[32];
+        if(std::sscanf(line, "%31s", word) != 1) continue;
+
+        const Keyword* keyword = nullptr;
+        for(const Keyword& k : keywords){
+            if(std::strcmp(word, k.name) == 0) keyword = &k;
+        }
+
+        Command command{keyword ? keyword->type : CommandType::Step, 0, Vector2()};
+        if(!keyword){
+            ok = false;
+        } else if(keyword->spawn){
+            ok = std::sscanf(line, "%*s %f %f", &command.position.x, &command.position.y) == 2;
+        } else {
+            ok = std::sscanf(line, "%*s %ld", &command.count) == 1 && command.count >= 0;
+        }
+        if(ok) commands.push_back(command);
+        else std::fprintf(stderr, "%s:%d: cannot parse '%s'\n", path, lineNumber, word);
+    }
+    std::fclose(file);
+    return ok;
+}
+
+// FNV-1a over the motion state of every body, in id order (the world
+// reorders its list), and every particle
+static uint64_t HashState(const PhysicsWorld& world){
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&](const void* data, size_t size){
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for(size_t i = 0; i < size; i++){
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+
+    std::vector<std::pair<uint32_t, const RigidBody*>> bodies;
+    for(int i = 0; i < world.GetBodyCount(); i++)
+        bodies.emplace_back(world.GetBody(i)->id, world.GetBody(i));
+    std::sort(bodies.begin(), bodies.end());
+    for(const auto& [id, body] : bodies){
+        float state[6] = {body->position.x, body->position.y, body->velocity.x, body->velocity.y,
+                          body->orientation, body->angularVelocity};
+        mix(&id, sizeof(id));
+        mix(state, sizeof(state));
+        mix(&body->isSleeping, sizeof(body->isSleeping));
+    }
+
+    const ParticleSystem& particles = world.GetParticles();
+    for(int i = 0; i < particles.GetCount(); i++){
+        Vector2 position = particles.GetPosition(i);
+        Vector2 velocity = particles.GetVelocity(i);
+        float state[4] = {position.x, position.y, velocity.x, velocity.y};
+        mix(state, sizeof(state));
+    }
+    return hash;
+}
+
+// One replay from a fresh Sandbox; appends each step's time in microseconds
+// and hands every step to recorder, if any
+static uint64_t Replay(const std::vector<Command>& commands, std::vector<double>& stepTimes,
+                       TransformRecorder* recorder = nullptr){
+    auto sandbox = std::make_unique<Sandbox>();
+    PhysicsWorld& world = sandbox->GetWorld();
+
+    for(const Command& command : commands){
+        switch(command.type){
+            case CommandType::Step:
+                for(long i = 0; i < command.count; i++){
+                    auto start = std::chrono::steady_clock::now();
+                    world.Step(Time::FixedDeltaTime);
+                    stepTimes.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+                    if(recorder) recorder->Record(world, world.GetStepCount());
+                }
+                break;
+            case CommandType::Ball: Spawns::Ball(world, command.position); break;
+            case CommandType::Hexagon: Spawns::Hexagon(world, command.position); break;
+            case CommandType::Burst: Spawns::Burst(world, command.position); break;
+            case CommandType::Iterations: world.SetIterations(static_cast<int>(command.count)); break;
+            case CommandType::Substeps: world.SetSubsteps(static_cast<int>(command.count)); break;
+            case CommandType::Threads: world.SetWorkerThreads(static_cast<int>(command.count)); break;
+            case CommandType::Speculative: world.SetSpeculativeContacts(command.count != 0); break;
+        }
+    }
+    return HashState(world);
+}
+
+static double Percentile(const std::vector<double>& sorted, double fraction){
+    if(sorted.empty()) return 0.0;
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Replays repeats times; false if the replays disagree
+static bool Measure(const std::vector<Command>& commands, int repeats, Baseline& result){
+    std::vector<double> times;
+    for(int r = 0; r < repeats; r++){
+        uint64_t hash = Replay(commands, times);
+        if(r == 0){
+            result.hash = hash;
+            result.times.steps = static_cast<long>(times.size());
+        } else if(hash != result.hash){
+            std::fprintf(stderr, "Replay %d ended in state %016llx, replay 0 in %016llx: not deterministic\n",
+                         r, static_cast<unsigned long long>(hash), static_cast<unsigned long long>(result.hash));
+            return false;
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    Distribution& d = result.times;
+    for(double t : times) d.meanUs += t;
+    d.meanUs = times.empty() ? 0.0 : d.meanUs / times.size();
+    d.medianUs = Percentile(times, 0.5);
+    d.p90Us = Percentile(times, 0.9);
+    d.p99Us = Percentile(times, 0.99);
+    d.maxUs = times.empty() ? 0.0 : times.back();
+    return true;
+}
+
+static void Print(const char* label, const Baseline& b){
+    std::printf("%-9s hash %016llx  steps %ld  mean %.1f  median %.1f  p90 %.1f  p99 %.1f  max %.1f us\n",
+                label, static_cast<unsigned long long>(b.hash), b.times.steps, b.times.meanUs,
+                b.times.medianUs, b.times.p90Us, b.times.p99Us, b.times.maxUs);
+}
+
+static bool SaveBaseline(const char* path, const char* script, const Baseline& b){
+    FILE* file = std::fopen(path, "w");
+    if(!file) return false;
+    std::fprintf(file, "# ReplayTool baseline for %s\n", script);
+    std::fprintf(file, "hash %016llx\n", static_cast<unsigned long long>(b.hash));
+    std::fprintf(file, "steps %ld\n", b.times.steps);
+    std::fprintf(file, "mean_us %.3f\nmedian_us %.3f\np90_us %.3f\np99_us %.3f\nmax_us %.3f\n",
+                 b.times.meanUs, b.times.medianUs, b.times.p90Us, b.times.p99Us, b.times.maxUs);
+    return std::fclose(file) == 0;
+}
+
+static bool LoadBaseline(const char* path, Baseline& b){
+    FILE* file = std::fopen(path, "r");
+    if(!file) return false;
+    char line[256];
+    int found = 0;
+    while(std::fgets(line, sizeof(line), file)){
+        unsigned long long hash;
+        if(std::sscanf(line, "hash %llx", &hash) == 1){ b.hash = hash; found++; }
+        else if(std::sscanf(line, "steps %ld", &b.times.steps) == 1) found++;
+        else if(std::sscanf(line, "mean_us %lf", &b.times.meanUs) == 1) found++;
+        else if(std::sscanf(line, "median_us %lf", &b.times.medianUs) == 1) found++;
+        else if(std::sscanf(line, "p90_us %lf", &b.times.p90Us) == 1) found++;
+        else if(std::sscanf(line, "p99_us %lf", &b.times.p99Us) == 1) found++;
+        else if(std::sscanf(line, "max_us %lf", &b.times.maxUs) == 1) found++;
+    }
+    std::fclose(file);
+    return found == 7;
+}
+
+static bool CheckTime(const char* name, double baseline, double current, double tolerance){
+    bool ok = current <= baseline * (1.0 + tolerance);
+    std::printf("  %-7s %10.1f -> %10.1f us (%+.0f%%)%s\n", name, baseline, current,
+                baseline > 0.0 ? (current / baseline - 1.0) * 100.0 : 0.0, ok ? "" : "  REGRESSION");
+    return ok;
+}
+
+int main(int argc, char** argv){
+    if(argc < 3) return PrintUsage();
+    const char* mode = argv[1];
+    const char* script = argv[2];
+    bool run = std::strcmp(mode, "run") == 0;
+    bool record = std::strcmp(mode, "record") == 0;
+    bool check = std::strcmp(mode, "check") == 0;
+    bool capture = std::strcmp(mode, "capture") == 0;
+    if(!run && !record && !check && !capture) return PrintUsage();
+    if((record || check || capture) && argc < 4) return PrintUsage();
+
+    if(capture){
+        std::vector<Command> commands;
+        if(!LoadScript(script, commands)) return 1;
+        TransformRecorder recorder;
+        if(!recorder.Start(argv[3])){
+            std::fprintf(stderr, "Could not write recording: %s\n", argv[3]);
+            return 1;
+        }
+        std::vector<double> times;
+        uint64_t hash = Replay(commands, times, &recorder);
+        recorder.Stop();
+        std::printf("captured %zu steps, hash %016llx, %d chunks dropped\n", times.size(),
+                    static_cast<unsigned long long>(hash), recorder.GetDroppedChunkCount());
+        return recorder.GetDroppedChunkCount() == 0 ? 0 : 1;
+    }
+
+    double tolerance = check && argc > 4 ? std::atof(argv[4]) : 0.25;
+    int repeatArg = run ? 3 : record ? 4 : 5;
+    int repeats = argc > repeatArg ? std::atoi(argv[repeatArg]) : 5;
+    if(repeats < 1 || tolerance < 0.0) return PrintUsage();
+
+    std::vector<Command> commands;
+    if(!LoadScript(script, commands)) return 1;
+
+    Baseline current;
+    if(!Measure(commands, repeats, current)) return 1;
+    Print("replay", current);
+
+    if(record){
+        if(!SaveBaseline(argv[3], script, current)){
+            std::fprintf(stderr, "Could not write baseline: %s\n", argv[3]);
+            return 1;
+        }
+        return 0;
+    }
+    if(!check) return 0;
+
+    Baseline baseline;
+    if(!LoadBaseline(argv[3], baseline)){
+        std::fprintf(stderr, "Could not read baseline: %s\n", argv[3]);
+        return 1;
+    }
+    Print("baseline", baseline);
+
+    bool ok = true;
+    if(current.hash != baseline.hash || current.times.steps != baseline.times.steps){
+        std::printf("  final state differs from the baseline\n");
+        ok = false;
+    }
+    ok &= CheckTime("median", baseline.times.medianUs, current.times.medianUs, tolerance);
+    ok &= CheckTime("p90", baseline.times.p90Us, current.times.p90Us, tolerance);
+    std::printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
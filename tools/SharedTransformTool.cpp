@@ -0,0 +1,109 @@
+#include "io/SharedTransformReader.h"
+#include "io/SharedTransformExporter.h"
+#include "physics/PhysicsWorld.h"
+#include "forces/GravityForce.h"
+#include "shapes/CircleShape.h"
+#include "shapes/AABBShape.h"
+#include "core/Config.h"
+#include "core/Time.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+// Exercise the shared transform region from two processes.
+//   SharedTransformTool publish <name> <steps>   run a headless world and publish each step
+//   SharedTransformTool read <name> <frames>     poll the region and print what it sees
+static int PrintUsage(){
+    std::printf("usage: SharedTransformTool publish <name> <steps>\n"
+                "       SharedTransformTool read <name> <frames>\n");
+    return 1;
+}
+
+static int Publish(const char* name, long steps){
+    PhysicsWorld world;
+    GravityForce gravity(Vector2(0.0f, Config::GRAVITY));
+    world.AddForceGenerator(&gravity);
+
+    RigidBody ground(0.0f);
+    ground.position = Vector2(600.0f, 775.0f);
+    ground.size = Vector2(1200.0f, 50.0f);
+    ground.collider = new Collider(new AABBShape(ground.size / 2));
+    world.AddBody(&ground);
+
+    std::vector<RigidBody> balls(200);
+    for(size_t i = 0; i < balls.size(); i++){
+        RigidBody& ball = balls[i];
+        ball.position = Vector2(100.0f + (i % 20) * 50.0f, 100.0f + (i / 20) * 40.0f);
+        ball.size = Vector2(30.0f, 30.0f);
+        ball.collider = new Collider(new CircleShape(15.0f));
+        ball.SetInverseInertia(ball.collider->shape->GetType());
+        world.AddBody(&ball);
+    }
+
+    SharedTransformExporter exporter;
+    if(!exporter.Open(name, 1024)){
+        std::fprintf(stderr, "Could not create shared memory region %s\n", name);
+        return 1;
+    }
+    world.SetTransformExporter(&exporter);
+
+    auto frame = std::chrono::duration<float>(Time::FixedDeltaTime);
+    for(long i = 0; i < steps; i++){
+        world.Step(Time::FixedDeltaTime);
+        std::this_thread::sleep_for(frame);
+    }
+    return 0;
+}
+
+static int Read(const char* name, long frames){
+    SharedTransformReader reader;
+    for(int attempt = 0; !reader.Open(name); attempt++){
+        if(attempt == 100){
+            std::fprintf(stderr, "Shared memory region %s not found\n", name);
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    long torn = 0;
+    uint64_t lastStep = 0;
+    for(long n = 0; n < frames;){
+        SharedTransformView view;
+        if(!reader.BeginRead(view) || view.step == lastStep){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        float sumY = 0.0f;
+        for(uint32_t i = 0; i < view.bodyCount; i++)
+            sumY += view.bodies[i].positionY;
+        uint64_t step = view.step;
+        uint32_t count = view.bodyCount;
+
+        if(!reader.EndRead()){
+            torn++;
+            continue;
+        }
+
+        lastStep = step;
+        n++;
+        std::printf("step %llu: %u bodies, mean y %.2f\n", static_cast<unsigned long long>(step), count, count ? sumY / count : 0.0f);
+    }
+    std::printf("discarded %ld torn frames\n", torn);
+    return 0;
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 4)
+        return PrintUsage();
+
+    long count = std::strtol(argv[3], nullptr, 10);
+    if(std::strcmp(argv[1], "publish") == 0)
+        return Publish(argv[2], count);
+    if(std::strcmp(argv[1], "read") == 0)
+        return Read(argv[2], count);
+    return PrintUsage();
+}
@@ -0,0 +1,139 @@
+#include "physics/PhysicsWorld.h"
+#include "forces/GravityForce.h"
+#include "shapes/AABBShape.h"
+#include "core/Config.h"
+#include "core/Time.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Compare the iterations, speculative and substepping solvers on stacking scenes.
+//   SolverBenchmark [stack|pyramid] [height] [steps]
+// For each configuration it prints the cost per step and how well the pile held:
+// how far the top box drifted from where it should rest, the deepest overlap,
+// the residual speed and how many boxes fell asleep.
+static int PrintUsage(){
+    std::printf("usage: SolverBenchmark [stack|pyramid] [height] [steps]\n");
+    return 1;
+}
+
+static const float BoxSize = 40.0f;
+static const float GroundTop = 750.0f;
+
+struct Scene{
+    PhysicsWorld world;
+    GravityForce gravity{Vector2(0.0f, Config::GRAVITY)};
+    std::vector<std::unique_ptr<RigidBody>> bodies;
+    RigidBody* top = nullptr;
+    float topRestY = 0.0f;
+
+    RigidBody* AddBox(const Vector2& position, const Vector2& size, float mass){
+        bodies.push_back(std::make_unique<RigidBody>(mass));
+        RigidBody* body = bodies.back().get();
+        body->position = position;
+        body->size = size;
+        body->collider = new Collider(new AABBShape(size / 2));
+        body->SetInverseInertia(body->collider->shape->GetType());
+        world.AddBody(body);
+        return body;
+    }
+};
+
+static void BuildScene(Scene& scene, bool pyramid, int height){
+    scene.world.AddForceGenerator(&scene.gravity);
+    scene.AddBox(Vector2(600.0f, GroundTop + 25.0f), Vector2(1200.0f, 50.0f), 0.0f);
+
+    Vector2 size(BoxSize, BoxSize);
+    for(int row = 0; row < height; row++){
+        int count = pyramid ? height - row : 1;
+        float startX = 600.0f - (count - 1) * BoxSize * 0.5f;
+        float y = GroundTop - BoxSize * 0.5f - row * BoxSize;
+        for(int i = 0; i < count; i++)
+            scene.top = scene.AddBox(Vector2(startX + i * BoxSize, y), size, 1.0f);
+    }
+    scene.topRestY = scene.top->position.y;
+}
+
+struct Result{
+    double msPerStep;
+    float topDrift;
+    float maxOverlap;
+    float maxSpeed;
+    int sleeping;
+    int dynamic;
+};
+
+// Deepest overlap between any two boxes (rotation ignored; piles stay near axis-aligned)
+static float MaxOverlap(const Scene& scene){
+    float worst = 0.0f;
+    for(size_t i = 0; i < scene.bodies.size(); i++){
+        for(size_t j = i + 1; j < scene.bodies.size(); j++){
+            const RigidBody& a = *scene.bodies[i];
+            const RigidBody& b = *scene.bodies[j];
+            float ox = (a.size.x + b.size.x) * 0.5f - std::abs(a.position.x - b.position.x);
+            float oy = (a.size.y + b.size.y) * 0.5f - std::abs(a.position.y - b.position.y);
+            if(ox > 0.0f && oy > 0.0f)
+                worst = std::max(worst, std::min(ox, oy));
+        }
+    }
+    return worst;
+}
+
+static Result Run(bool pyramid, int height, long steps, int iterations, int substeps, bool speculative){
+    Scene scene;
+    BuildScene(scene, pyramid, height);
+    scene.world.SetIterations(iterations);
+    scene.world.SetSubsteps(substeps);
+    scene.world.SetSpeculativeContacts(speculative);
+
+    auto start = std::chrono::steady_clock::now();
+    for(long i = 0; i < steps; i++)
+        scene.world.Step(Time::FixedDeltaTime);
+    auto end = std::chrono::steady_clock::now();
+
+    Result result{};
+    result.msPerStep = std::chrono::duration<double, std::milli>(end - start).count() / steps;
+    result.topDrift = std::abs(scene.top->position.y - scene.topRestY);
+    result.maxOverlap = MaxOverlap(scene);
+    for(auto& body : scene.bodies){
+        if(body->inverseMass == 0.0f) continue;
+        result.dynamic++;
+        if(body->isSleeping) result.sleeping++;
+        result.maxSpeed = std::max(result.maxSpeed, body->velocity.length());
+    }
+    return result;
+}
+
+int main(int argc, char** argv){
+    bool pyramid = false;
+    int height = 10;
+    long steps = 600;
+    if(argc > 1){
+        if(std::strcmp(argv[1], "pyramid") == 0) pyramid = true;
+        else if(std::strcmp(argv[1], "stack") != 0) return PrintUsage();
+    }
+    if(argc > 2) height = std::atoi(argv[2]);
+    if(argc > 3) steps = std::atol(argv[3]);
+    if(height < 1 || steps < 1) return PrintUsage();
+
+    std::printf("%s of height %d, %ld steps\n", pyramid ? "pyramid" : "stack", height, steps);
+    std::printf("%-16s %10s %10s %10s %10s %10s\n", "solver", "ms/step", "topDrift", "overlap", "maxSpeed", "asleep");
+
+    struct Setup{ const char* name; int iterations; int substeps; bool speculative; };
+    const Setup setups[] = {
+        {"iterations 4", 4, 0, false}, {"iterations 8", 8, 0, false}, {"iterations 16", 16, 0, false},
+        {"speculative 4", 4, 0, true}, {"speculative 8", 8, 0, true},
+        {"substeps 2", 4, 2, false}, {"substeps 4", 4, 4, false}, {"substeps 8", 4, 8, false},
+    };
+    for(const Setup& setup : setups){
+        Result r = Run(pyramid, height, steps, setup.iterations, setup.substeps, setup.speculative);
+        std::printf("%-16s %10.4f %10.2f %10.2f %10.2f %6d/%-3d\n", setup.name, r.msPerStep,
+                    r.topDrift, r.maxOverlap, r.maxSpeed, r.sleeping, r.dynamic);
+    }
+    return 0;
+}